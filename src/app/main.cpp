@@ -6,12 +6,25 @@
 #endif
 #endif
 
+#include <cstring>
+
 #include "rd_log.h"
 #include "render.h"
 
-int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) {
+int main(int argc, char* argv[]) {
+  bool headless = false;
+  for (int i = 1; i < argc; i++) {
+    if (0 == strcmp(argv[i], "--headless")) {
+      headless = true;
+    }
+  }
+
   crossdesk::Render render;
-  render.Run();
+  if (headless) {
+    render.RunHeadless();
+  } else {
+    render.Run();
+  }
 
   return 0;
 }
\ No newline at end of file
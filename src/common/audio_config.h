@@ -0,0 +1,93 @@
+/*
+ * @Author: DI JUNKUN
+ * @Date: 2026-10-19
+ * Copyright (c) 2026 by DI JUNKUN, All Rights Reserved.
+ */
+
+#ifndef _AUDIO_CONFIG_H_
+#define _AUDIO_CONFIG_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace crossdesk {
+
+// pcm s16 layout of the audio stream, negotiated between host and viewer
+class AudioConfig {
+ public:
+  static constexpr int kSampleRate = 48000;
+  static constexpr int kMinFrameDurationUs = 2500;
+  static constexpr int kMaxFrameDurationUs = 60000;
+  static constexpr int kDefaultFrameDurationUs = 10000;
+  static constexpr int kMaxChannels = 2;
+  // the opus frame durations
+  static constexpr int kFrameDurations[] = {2500,  5000,  10000,
+                                            20000, 40000, 60000};
+  static constexpr int kFrameDurationCount =
+      sizeof(kFrameDurations) / sizeof(kFrameDurations[0]);
+
+ public:
+  AudioConfig() {}
+  AudioConfig(int frame_duration_us, int channels)
+      : frame_duration_us(ClampFrameDuration(frame_duration_us)),
+        channels(ClampChannels(channels)) {}
+
+  // snap to the nearest opus frame duration
+  static int ClampFrameDuration(int frame_duration_us) {
+    int best = kDefaultFrameDurationUs;
+    int best_diff = -1;
+    for (int duration : kFrameDurations) {
+      int diff = std::abs(duration - frame_duration_us);
+      if (best_diff < 0 || diff < best_diff) {
+        best = duration;
+        best_diff = diff;
+      }
+    }
+    return best;
+  }
+
+  static int ClampChannels(int channels) {
+    return std::clamp(channels, 1, kMaxChannels);
+  }
+
+  // fewer channels and longer frames win, so neither side is pushed beyond
+  // what it asked for in bandwidth or packet rate
+  static AudioConfig Negotiate(const AudioConfig& local,
+                               const AudioConfig& remote) {
+    return AudioConfig(
+        std::max(local.frame_duration_us, remote.frame_duration_us),
+        std::min(local.channels, remote.channels));
+  }
+
+  size_t SamplesPerFrame() const {
+    return (size_t)kSampleRate * frame_duration_us / 1000000;
+  }
+
+  size_t FrameSizeBytes() const {
+    return SamplesPerFrame() * channels * sizeof(int16_t);
+  }
+
+  size_t BytesPerMs() const {
+    return (size_t)kSampleRate / 1000 * channels * sizeof(int16_t);
+  }
+
+  static size_t MaxFrameSizeBytes() {
+    return (size_t)kSampleRate * kMaxFrameDurationUs / 1000000 * kMaxChannels *
+           sizeof(int16_t);
+  }
+
+  bool operator==(const AudioConfig& other) const {
+    return frame_duration_us == other.frame_duration_us &&
+           channels == other.channels;
+  }
+  bool operator!=(const AudioConfig& other) const { return !(*this == other); }
+
+ public:
+  int frame_duration_us = kDefaultFrameDurationUs;
+  int channels = 1;
+};
+}  // namespace crossdesk
+#endif
\ No newline at end of file
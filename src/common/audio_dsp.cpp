@@ -0,0 +1,322 @@
+#include "audio_dsp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define AUDIO_DSP_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define AUDIO_DSP_NEON 1
+#endif
+
+namespace crossdesk {
+
+static constexpr double kPi = 3.14159265358979323846;
+
+void S16ToF32(const int16_t* in, float* out, size_t count) {
+  const float scale = 1.0f / 32768.0f;
+  size_t i = 0;
+#if defined(AUDIO_DSP_SSE2)
+  const __m128 vscale = _mm_set1_ps(scale);
+  for (; i + 8 <= count; i += 8) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    // sign extend by placing each sample in the high half and shifting down
+    __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+    __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+    _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), vscale));
+    _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), vscale));
+  }
+#elif defined(AUDIO_DSP_NEON)
+  for (; i + 8 <= count; i += 8) {
+    int16x8_t x = vld1q_s16(in + i);
+    vst1q_f32(out + i,
+              vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), scale));
+    vst1q_f32(out + i + 4,
+              vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), scale));
+  }
+#endif
+  for (; i < count; i++) {
+    out[i] = in[i] * scale;
+  }
+}
+
+void F32ToS16(const float* in, int16_t* out, size_t count) {
+  size_t i = 0;
+#if defined(AUDIO_DSP_SSE2)
+  const __m128 vscale = _mm_set1_ps(32768.0f);
+  for (; i + 8 <= count; i += 8) {
+    // round to nearest, the pack saturates to the s16 range
+    __m128i lo = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i), vscale));
+    __m128i hi = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i + 4), vscale));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm_packs_epi32(lo, hi));
+  }
+#elif defined(AUDIO_DSP_NEON)
+  for (; i + 8 <= count; i += 8) {
+    int32x4_t lo = vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(in + i), 32768.0f));
+    int32x4_t hi =
+        vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(in + i + 4), 32768.0f));
+    vst1q_s16(out + i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+  }
+#endif
+  for (; i < count; i++) {
+    long value = std::lround(in[i] * 32768.0f);
+    out[i] = (int16_t)std::clamp(value, -32768L, 32767L);
+  }
+}
+
+void RemixChannels(const float* in, int in_channels, float* out,
+                   int out_channels, size_t frames) {
+  if (in_channels == out_channels) {
+    memcpy(out, in, frames * in_channels * sizeof(float));
+    return;
+  }
+
+  for (size_t i = 0; i < frames; i++) {
+    const float* src = in + i * in_channels;
+    float* dst = out + i * out_channels;
+
+    if (in_channels == 1) {
+      for (int c = 0; c < out_channels; c++) {
+        dst[c] = src[0];
+      }
+    } else if (out_channels == 1) {
+      float sum = 0;
+      for (int c = 0; c < in_channels; c++) {
+        sum += src[c];
+      }
+      dst[0] = sum / in_channels;
+    } else {
+      // keep the front pair, fold the rest evenly into it
+      float left = src[0];
+      float right = src[1];
+      for (int c = 2; c < in_channels; c++) {
+        left += src[c] * 0.5f;
+        right += src[c] * 0.5f;
+      }
+      float norm = 1.0f / (1.0f + 0.5f * (in_channels - 2));
+      dst[0] = left * norm;
+      dst[1] = right * norm;
+      for (int c = 2; c < out_channels; c++) {
+        dst[c] = 0;
+      }
+    }
+  }
+}
+
+PolyphaseResampler::PolyphaseResampler() {}
+
+PolyphaseResampler::~PolyphaseResampler() {}
+
+int PolyphaseResampler::Init(int in_rate, int out_rate, int channels,
+                             int taps_per_phase) {
+  if (in_rate <= 0 || out_rate <= 0 || channels <= 0 || taps_per_phase <= 0) {
+    return -1;
+  }
+
+  int g = std::gcd(in_rate, out_rate);
+  interpolation_ = out_rate / g;
+  decimation_ = in_rate / g;
+  channels_ = channels;
+  taps_per_phase_ = taps_per_phase;
+
+  if (IsPassthrough()) {
+    coeffs_.clear();
+    Reset();
+    return 0;
+  }
+
+  // windowed sinc low pass at the upsampled rate, cut below the lower
+  // of the two nyquist frequencies
+  int length = taps_per_phase_ * interpolation_;
+  double cutoff = 0.45 / std::max(interpolation_, decimation_);
+  double center = (length - 1) / 2.0;
+  std::vector<double> prototype(length);
+  for (int n = 0; n < length; n++) {
+    double x = n - center;
+    double sinc =
+        x == 0 ? 2 * cutoff : std::sin(2 * kPi * cutoff * x) / (kPi * x);
+    double window = 0.42 - 0.5 * std::cos(2 * kPi * n / (length - 1)) +
+                    0.08 * std::cos(4 * kPi * n / (length - 1));
+    prototype[n] = sinc * window * interpolation_;
+  }
+
+  coeffs_.resize(length);
+  for (int phase = 0; phase < interpolation_; phase++) {
+    for (int k = 0; k < taps_per_phase_; k++) {
+      coeffs_[phase * taps_per_phase_ + k] =
+          (float)prototype[phase + k * interpolation_];
+    }
+  }
+
+  Reset();
+  return 0;
+}
+
+void PolyphaseResampler::Reset() {
+  history_.assign(
+      ((size_t)std::max(taps_per_phase_ - 1, 0) + kMaxBlockFrames) * channels_,
+      0.0f);
+  position_ = 0;
+}
+
+void PolyphaseResampler::Process(const float* in, size_t in_frames,
+                                 std::vector<float>& out) {
+  if (IsPassthrough()) {
+    out.insert(out.end(), in, in + in_frames * channels_);
+    return;
+  }
+
+  while (in_frames > 0) {
+    size_t block_frames = std::min(in_frames, kMaxBlockFrames);
+    ProcessBlock(in, block_frames, out);
+    in += block_frames * channels_;
+    in_frames -= block_frames;
+  }
+}
+
+void PolyphaseResampler::ProcessBlock(const float* in, size_t in_frames,
+                                      std::vector<float>& out) {
+  size_t history_frames = taps_per_phase_ - 1;
+  memcpy(history_.data() + history_frames * channels_, in,
+         in_frames * channels_ * sizeof(float));
+
+  while (position_ / interpolation_ < in_frames) {
+    size_t base = history_frames + position_ / interpolation_;
+    const float* coeffs =
+        coeffs_.data() + (position_ % interpolation_) * taps_per_phase_;
+
+    size_t offset = out.size();
+    out.resize(offset + channels_, 0.0f);
+    for (int k = 0; k < taps_per_phase_; k++) {
+      const float* frame = history_.data() + (base - k) * channels_;
+      for (int c = 0; c < channels_; c++) {
+        out[offset + c] += coeffs[k] * frame[c];
+      }
+    }
+
+    position_ += decimation_;
+  }
+
+  // the last taps_per_phase_ - 1 frames become the next history
+  position_ -= in_frames * interpolation_;
+  memmove(history_.data(), history_.data() + in_frames * channels_,
+          history_frames * channels_ * sizeof(float));
+}
+
+AudioConverter::AudioConverter()
+    : frame_cache_(AudioConfig::MaxFrameSizeBytes()),
+      frame_buffer_(AudioConfig::MaxFrameSizeBytes()) {}
+
+AudioConverter::~AudioConverter() {}
+
+int AudioConverter::Init(SampleFormat format, int sample_rate, int channels,
+                         const AudioConfig& out_config) {
+  if (sample_rate <= 0 || channels <= 0) {
+    return -1;
+  }
+
+  format_ = format;
+  sample_rate_ = sample_rate;
+  channels_ = channels;
+  out_config_ = out_config;
+  frame_cache_.Clear();
+
+  return resampler_.Init(sample_rate_, AudioConfig::kSampleRate,
+                         out_config_.channels);
+}
+
+void AudioConverter::Process(const void* data, size_t frames,
+                             const frame_cb& cb) {
+  // already canonical, only framing is left
+  if (format_ == SampleFormat::S16 && channels_ == out_config_.channels &&
+      resampler_.IsPassthrough()) {
+    EmitFrames(static_cast<const uint8_t*>(data),
+               frames * channels_ * sizeof(int16_t), cb);
+    return;
+  }
+
+  size_t count = frames * channels_;
+  if (format_ == SampleFormat::F32) {
+    ProcessFloat(static_cast<const float*>(data), frames, cb);
+    return;
+  }
+
+  input_.resize(count);
+  S16ToF32(static_cast<const int16_t*>(data), input_.data(), count);
+  ProcessFloat(input_.data(), frames, cb);
+}
+
+void AudioConverter::ProcessPlanar(const void* const* planes, size_t frames,
+                                   const frame_cb& cb) {
+  input_.resize(frames * channels_);
+  for (int c = 0; c < channels_; c++) {
+    for (size_t i = 0; i < frames; i++) {
+      input_[i * channels_ + c] =
+          format_ == SampleFormat::F32
+              ? static_cast<const float*>(planes[c])[i]
+              : static_cast<const int16_t*>(planes[c])[i] / 32768.0f;
+    }
+  }
+  ProcessFloat(input_.data(), frames, cb);
+}
+
+void AudioConverter::ProcessFloat(const float* interleaved, size_t frames,
+                                  const frame_cb& cb) {
+  const float* samples = interleaved;
+  if (channels_ != out_config_.channels) {
+    remixed_.resize(frames * out_config_.channels);
+    RemixChannels(interleaved, channels_, remixed_.data(),
+                  out_config_.channels, frames);
+    samples = remixed_.data();
+  }
+
+  size_t count = frames * out_config_.channels;
+  if (!resampler_.IsPassthrough()) {
+    resampled_.clear();
+    resampler_.Process(samples, frames, resampled_);
+    samples = resampled_.data();
+    count = resampled_.size();
+  }
+
+  pcm_.resize(count);
+  F32ToS16(samples, pcm_.data(), count);
+  EmitFrames(reinterpret_cast<const uint8_t*>(pcm_.data()),
+             count * sizeof(int16_t), cb);
+}
+
+void AudioConverter::EmitFrames(const uint8_t* data, size_t size,
+                                const frame_cb& cb) {
+  const size_t frame_size = out_config_.FrameSizeBytes();
+
+  // complete a frame left over from the previous call first
+  size_t cached = frame_cache_.Size();
+  if (cached > 0) {
+    size_t fill = std::min(size, frame_size - cached);
+    frame_cache_.Write(data, fill);
+    data += fill;
+    size -= fill;
+
+    if (frame_cache_.Size() < frame_size) {
+      return;
+    }
+
+    frame_cache_.Read(frame_buffer_.data(), frame_size);
+    cb(frame_buffer_.data(), frame_size);
+  }
+
+  while (size >= frame_size) {
+    cb(data, frame_size);
+    data += frame_size;
+    size -= frame_size;
+  }
+
+  if (size > 0) {
+    frame_cache_.Write(data, size);
+  }
+}
+}  // namespace crossdesk
\ No newline at end of file
@@ -0,0 +1,109 @@
+/*
+ * @Author: DI JUNKUN
+ * @Date: 2026-10-19
+ * Copyright (c) 2026 by DI JUNKUN, All Rights Reserved.
+ */
+
+#ifndef _AUDIO_DSP_H_
+#define _AUDIO_DSP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "audio_config.h"
+#include "audio_ring_buffer.h"
+
+namespace crossdesk {
+
+// sample format conversion, float is in [-1, 1]
+void S16ToF32(const int16_t* in, float* out, size_t count);
+void F32ToS16(const float* in, int16_t* out, size_t count);
+
+// interleaved channel remix, mono is duplicated on upmix and every
+// channel is averaged on downmix to mono, extra channels beyond stereo
+// are folded into left and right
+void RemixChannels(const float* in, int in_channels, float* out,
+                   int out_channels, size_t frames);
+
+// Rational polyphase resampler over interleaved float, e.g. 44.1k to 48k
+// runs 160 phases decimated by 147. Keeps its history across calls.
+class PolyphaseResampler {
+ public:
+  PolyphaseResampler();
+  ~PolyphaseResampler();
+
+ public:
+  int Init(int in_rate, int out_rate, int channels, int taps_per_phase = 24);
+  void Reset();
+  bool IsPassthrough() const { return interpolation_ == decimation_; }
+
+  // appends the resampled frames to out
+  void Process(const float* in, size_t in_frames, std::vector<float>& out);
+
+ private:
+  // longer inputs are split, so the history never has to grow
+  static constexpr size_t kMaxBlockFrames = 1024;
+
+  void ProcessBlock(const float* in, size_t in_frames,
+                    std::vector<float>& out);
+
+ private:
+  int interpolation_ = 1;
+  int decimation_ = 1;
+  int channels_ = 1;
+  int taps_per_phase_ = 0;
+  // coefficients laid out by phase, taps_per_phase_ per phase
+  std::vector<float> coeffs_;
+  // taps_per_phase_ - 1 frames of history followed by room for one block
+  // of input, sized once in Reset
+  std::vector<float> history_;
+  // position of the next output in input frames times interpolation
+  uint64_t position_ = 0;
+};
+
+// Brings any capture format to the canonical pcm s16 at 48k in the
+// negotiated layout, then cuts it into whole frames.
+class AudioConverter {
+ public:
+  enum class SampleFormat { S16, F32 };
+  typedef std::function<void(const uint8_t*, size_t)> frame_cb;
+
+ public:
+  AudioConverter();
+  ~AudioConverter();
+
+ public:
+  int Init(SampleFormat format, int sample_rate, int channels,
+           const AudioConfig& out_config);
+
+  // interleaved input
+  void Process(const void* data, size_t frames, const frame_cb& cb);
+  // one buffer per channel
+  void ProcessPlanar(const void* const* planes, size_t frames,
+                     const frame_cb& cb);
+
+  const AudioConfig& GetOutputConfig() const { return out_config_; }
+
+ private:
+  void ProcessFloat(const float* interleaved, size_t frames,
+                    const frame_cb& cb);
+  void EmitFrames(const uint8_t* data, size_t size, const frame_cb& cb);
+
+ private:
+  SampleFormat format_ = SampleFormat::S16;
+  int sample_rate_ = AudioConfig::kSampleRate;
+  int channels_ = 1;
+  AudioConfig out_config_;
+  PolyphaseResampler resampler_;
+
+  std::vector<float> input_;
+  std::vector<float> remixed_;
+  std::vector<float> resampled_;
+  std::vector<int16_t> pcm_;
+  AudioRingBuffer frame_cache_;
+  std::vector<uint8_t> frame_buffer_;
+};
+}  // namespace crossdesk
+#endif
\ No newline at end of file
@@ -0,0 +1,249 @@
+#include "audio_jitter_buffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace crossdesk {
+
+// frames quieter than this mean absolute amplitude may be dropped whole
+static constexpr int kSilenceLevel = 32;
+// splice crossfade when shortening a frame
+static constexpr int kCrossfadeMs = 2;
+// concealment stops after this long, the output then plays silence
+static constexpr uint64_t kMaxConcealUs = 60000;
+
+AudioJitterBuffer::AudioJitterBuffer(int min_target_ms, int max_target_ms)
+    : min_target_ms_(min_target_ms), max_target_ms_(max_target_ms) {}
+
+AudioJitterBuffer::~AudioJitterBuffer() {}
+
+void AudioJitterBuffer::SetAudioConfig(const AudioConfig& audio_config) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (audio_config == audio_config_) {
+    return;
+  }
+  audio_config_ = audio_config;
+  last_frame_.clear();
+  concealing_ = false;
+}
+
+void AudioJitterBuffer::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  last_arrival_us_ = 0;
+  last_frame_duration_us_ = 0;
+  jitter_us_ = 0;
+  peak_jitter_us_ = 0;
+  extra_delay_ms_ = 0;
+  last_frame_.clear();
+  concealing_ = false;
+  comfort_noise_ = false;
+  stats_ = Stats();
+}
+
+void AudioJitterBuffer::SetExtraDelay(int extra_delay_ms) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  extra_delay_ms_ = std::max(extra_delay_ms, 0);
+}
+
+void AudioJitterBuffer::SetComfortNoise(int level_db) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  comfort_noise_ = true;
+  // uniform noise, peak is sqrt(3) times the rms
+  comfort_noise_amplitude_ =
+      level_db <= -90 ? 0.0f
+                      : (float)(32768.0 * std::pow(10.0, level_db / 20.0) *
+                                std::sqrt(3.0));
+}
+
+void AudioJitterBuffer::AppendNoise(size_t bytes, std::vector<uint8_t>& out) {
+  size_t offset = out.size();
+  out.resize(offset + bytes);
+  int16_t* dst = reinterpret_cast<int16_t*>(out.data() + offset);
+  for (size_t i = 0; i < bytes / sizeof(int16_t); i++) {
+    noise_seed_ = noise_seed_ * 1664525u + 1013904223u;
+    float r = (float)(noise_seed_ >> 8) / (float)(1u << 24) * 2.0f - 1.0f;
+    dst[i] = (int16_t)(r * comfort_noise_amplitude_);
+  }
+}
+
+size_t AudioJitterBuffer::TargetBytes() const {
+  double target_us =
+      2.0 * audio_config_.frame_duration_us + std::max(2 * jitter_us_,
+                                                       peak_jitter_us_);
+  int target_ms = std::clamp((int)(target_us / 1000), min_target_ms_,
+                             max_target_ms_) +
+                  extra_delay_ms_;
+  return target_ms * audio_config_.BytesPerMs();
+}
+
+bool AudioJitterBuffer::IsSilent(const int16_t* samples, size_t count) const {
+  if (count == 0) {
+    return true;
+  }
+
+  int64_t sum = 0;
+  for (size_t i = 0; i < count; i++) {
+    sum += std::abs((int)samples[i]);
+  }
+  return sum / (int64_t)count < kSilenceLevel;
+}
+
+void AudioJitterBuffer::Compress(const uint8_t* data, size_t size,
+                                 size_t remove_bytes,
+                                 std::vector<uint8_t>& out) {
+  const size_t channels = audio_config_.channels;
+  const int16_t* in = reinterpret_cast<const int16_t*>(data);
+  size_t frames = size / sizeof(int16_t) / channels;
+  size_t remove = remove_bytes / sizeof(int16_t) / channels;
+  size_t fade = std::min<size_t>(
+      (size_t)AudioConfig::kSampleRate / 1000 * kCrossfadeMs,
+      (frames - remove) / 2);
+  // splice out the middle of the frame, overlap adding the two edges
+  size_t start = (frames - remove - fade) / 2;
+
+  size_t offset = out.size();
+  out.resize(offset + (frames - remove) * channels * sizeof(int16_t));
+  int16_t* dst = reinterpret_cast<int16_t*>(out.data() + offset);
+
+  memcpy(dst, in, start * channels * sizeof(int16_t));
+  dst += start * channels;
+  for (size_t i = 0; i < fade; i++) {
+    float w = (float)(i + 1) / (float)(fade + 1);
+    for (size_t c = 0; c < channels; c++) {
+      float a = in[(start + i) * channels + c];
+      float b = in[(start + remove + i) * channels + c];
+      *dst++ = (int16_t)std::lround(a * (1.0f - w) + b * w);
+    }
+  }
+  size_t tail = start + remove + fade;
+  memcpy(dst, in + tail * channels,
+         (frames - tail) * channels * sizeof(int16_t));
+}
+
+void AudioJitterBuffer::Put(const uint8_t* data, size_t size,
+                            size_t queued_bytes, uint64_t now_us,
+                            std::vector<uint8_t>& out) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.received_frames++;
+
+  size_t bytes_per_ms = audio_config_.BytesPerMs();
+  size_t sample_frame_bytes = audio_config_.channels * sizeof(int16_t);
+  size -= size % sample_frame_bytes;
+  if (size == 0) {
+    return;
+  }
+
+  uint64_t frame_duration_us = size * 1000 / bytes_per_ms;
+  if (comfort_noise_) {
+    // the pause was intended, it says nothing about network jitter
+    last_arrival_us_ = 0;
+  }
+  if (last_arrival_us_ != 0 && now_us > last_arrival_us_) {
+    double d = std::fabs((double)(now_us - last_arrival_us_) -
+                         (double)last_frame_duration_us_);
+    jitter_us_ += (d - jitter_us_) / 16.0;
+    peak_jitter_us_ = std::max(d, peak_jitter_us_ * 0.995);
+  }
+  last_arrival_us_ = now_us;
+  last_frame_duration_us_ = frame_duration_us;
+
+  size_t target_bytes = TargetBytes();
+  stats_.target_ms = (int)(target_bytes / bytes_per_ms);
+  stats_.jitter_ms = (int)(jitter_us_ / 1000);
+
+  const int16_t* samples = reinterpret_cast<const int16_t*>(data);
+  size_t sample_count = size / sizeof(int16_t);
+  bool silent = IsSilent(samples, sample_count);
+
+  if (queued_bytes == 0 || concealing_ || comfort_noise_) {
+    // starting or recovering from an underrun, build the cushion up front
+    size_t prefill = target_bytes > size ? target_bytes - size : 0;
+    prefill -= prefill % sample_frame_bytes;
+    if (comfort_noise_) {
+      AppendNoise(prefill, out);
+    } else {
+      out.insert(out.end(), prefill, 0);
+    }
+  }
+
+  size_t excess = queued_bytes > target_bytes ? queued_bytes - target_bytes : 0;
+  size_t begin = out.size();
+  if (excess >= size && silent) {
+    // a whole silent frame can go without anyone noticing
+    stats_.dropped_frames++;
+  } else if (excess >= 2 * bytes_per_ms * audio_config_.frame_duration_us /
+                           1000 &&
+             size >= 4 * sample_frame_bytes) {
+    size_t remove = std::min(excess, size / 4);
+    remove -= remove % sample_frame_bytes;
+    Compress(data, size, remove, out);
+    stats_.compressed_frames++;
+  } else {
+    out.insert(out.end(), data, data + size);
+  }
+
+  if (concealing_ && out.size() > begin) {
+    // the concealment faded out, fade the real signal back in
+    int16_t* dst = reinterpret_cast<int16_t*>(out.data() + begin);
+    size_t frames = (out.size() - begin) / sample_frame_bytes;
+    size_t fade = std::min<size_t>(
+        frames, (size_t)AudioConfig::kSampleRate / 1000 * kCrossfadeMs);
+    for (size_t i = 0; i < fade; i++) {
+      float w = (float)(i + 1) / (float)(fade + 1);
+      for (int c = 0; c < audio_config_.channels; c++) {
+        int16_t& s = dst[i * audio_config_.channels + c];
+        s = (int16_t)(s * w);
+      }
+    }
+  }
+
+  concealing_ = false;
+  comfort_noise_ = false;
+  conceal_gain_ = 1.0f;
+  concealed_us_ = 0;
+  last_frame_.assign(data, data + size);
+}
+
+void AudioJitterBuffer::Conceal(size_t needed_bytes,
+                                std::vector<uint8_t>& out) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t bytes_per_ms = audio_config_.BytesPerMs();
+
+  if (comfort_noise_ && needed_bytes > 0) {
+    size_t sample_frame_bytes = audio_config_.channels * sizeof(int16_t);
+    size_t bytes = needed_bytes + sample_frame_bytes - 1;
+    bytes -= bytes % sample_frame_bytes;
+    AppendNoise(bytes, out);
+    stats_.comfort_noise_ms += bytes / bytes_per_ms;
+    return;
+  }
+
+  if (last_frame_.empty() || needed_bytes == 0) {
+    return;
+  }
+
+  size_t produced = 0;
+  while (produced < needed_bytes && concealed_us_ < kMaxConcealUs) {
+    // repeat the last frame, halving it each time
+    conceal_gain_ *= 0.5f;
+    size_t offset = out.size();
+    out.resize(offset + last_frame_.size());
+    const int16_t* src = reinterpret_cast<const int16_t*>(last_frame_.data());
+    int16_t* dst = reinterpret_cast<int16_t*>(out.data() + offset);
+    for (size_t i = 0; i < last_frame_.size() / sizeof(int16_t); i++) {
+      dst[i] = (int16_t)(src[i] * conceal_gain_);
+    }
+
+    produced += last_frame_.size();
+    concealed_us_ += last_frame_.size() * 1000 / bytes_per_ms;
+    stats_.concealed_frames++;
+    concealing_ = true;
+  }
+}
+
+AudioJitterBuffer::Stats AudioJitterBuffer::GetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+}  // namespace crossdesk
\ No newline at end of file
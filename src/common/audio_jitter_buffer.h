@@ -0,0 +1,91 @@
+/*
+ * @Author: DI JUNKUN
+ * @Date: 2026-10-19
+ * Copyright (c) 2026 by DI JUNKUN, All Rights Reserved.
+ */
+
+#ifndef _AUDIO_JITTER_BUFFER_H_
+#define _AUDIO_JITTER_BUFFER_H_
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "audio_config.h"
+
+namespace crossdesk {
+
+// Playout policy in front of the audio output queue. It keeps the queued
+// depth near a target derived from the observed interarrival jitter,
+// shortens the queue when it grows past the target and fills underruns
+// with a fading repeat of the last frame.
+class AudioJitterBuffer {
+ public:
+  struct Stats {
+    uint64_t received_frames = 0;
+    uint64_t dropped_frames = 0;
+    uint64_t compressed_frames = 0;
+    uint64_t concealed_frames = 0;
+    uint64_t comfort_noise_ms = 0;
+    int target_ms = 0;
+    int jitter_ms = 0;
+  };
+
+ public:
+  explicit AudioJitterBuffer(int min_target_ms = 20, int max_target_ms = 200);
+  ~AudioJitterBuffer();
+
+ public:
+  void SetAudioConfig(const AudioConfig& audio_config);
+  void Reset();
+
+  // queued_bytes is what the output still holds, the frame to be queued is
+  // appended to out, possibly shortened or preceded by a prefill
+  void Put(const uint8_t* data, size_t size, size_t queued_bytes,
+           uint64_t now_us, std::vector<uint8_t>& out);
+
+  // called when the output runs short by needed_bytes
+  void Conceal(size_t needed_bytes, std::vector<uint8_t>& out);
+
+  // added on top of the jitter target, used to hold audio back for video
+  void SetExtraDelay(int extra_delay_ms);
+
+  // the sender went silent, fill the output with noise at level_db dbfs
+  // until the next frame arrives
+  void SetComfortNoise(int level_db);
+
+  Stats GetStats();
+
+ private:
+  size_t TargetBytes() const;
+  bool IsSilent(const int16_t* samples, size_t count) const;
+  void AppendNoise(size_t bytes, std::vector<uint8_t>& out);
+  void Compress(const uint8_t* data, size_t size, size_t remove_bytes,
+                std::vector<uint8_t>& out);
+
+ private:
+  std::mutex mutex_;
+  AudioConfig audio_config_;
+  int min_target_ms_;
+  int max_target_ms_;
+  int extra_delay_ms_ = 0;
+
+  // interarrival jitter, smoothed as in rfc 3550 plus a decaying peak
+  uint64_t last_arrival_us_ = 0;
+  uint64_t last_frame_duration_us_ = 0;
+  double jitter_us_ = 0;
+  double peak_jitter_us_ = 0;
+
+  std::vector<uint8_t> last_frame_;
+  float conceal_gain_ = 1.0f;
+  uint64_t concealed_us_ = 0;
+  bool concealing_ = false;
+
+  bool comfort_noise_ = false;
+  float comfort_noise_amplitude_ = 0;
+  uint32_t noise_seed_ = 1;
+
+  Stats stats_;
+};
+}  // namespace crossdesk
+#endif
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include "audio_mixer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define AUDIO_MIXER_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AUDIO_MIXER_NEON 1
+#endif
+
+namespace crossdesk {
+
+// ring room per source, enough for the largest jitter target plus a/v delay
+static constexpr int kSourceRingMs = 640;
+
+// dst = saturate(dst + src)
+static void MixSaturate(int16_t* dst, const int16_t* src, size_t count) {
+  size_t i = 0;
+#if defined(AUDIO_MIXER_SSE2)
+  for (; i + 8 <= count; i += 8) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_adds_epi16(a, b));
+  }
+#elif defined(AUDIO_MIXER_NEON)
+  for (; i + 8 <= count; i += 8) {
+    vst1q_s16(dst + i, vqaddq_s16(vld1q_s16(dst + i), vld1q_s16(src + i)));
+  }
+#endif
+  for (; i < count; i++) {
+    int sum = (int)dst[i] + (int)src[i];
+    dst[i] = (int16_t)std::clamp(sum, -32768, 32767);
+  }
+}
+
+static void ApplyGain(int16_t* samples, size_t count, float gain) {
+  for (size_t i = 0; i < count; i++) {
+    int value = (int)std::lround(samples[i] * gain);
+    samples[i] = (int16_t)std::clamp(value, -32768, 32767);
+  }
+}
+
+AudioMixer::AudioMixer() {}
+
+AudioMixer::~AudioMixer() {}
+
+void AudioMixer::SetOutputConfig(const AudioConfig& output_config) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (output_config == output_config_) {
+    return;
+  }
+  output_config_ = output_config;
+  // buffered audio is in the old layout
+  sources_.clear();
+}
+
+AudioConfig AudioMixer::GetOutputConfig() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return output_config_;
+}
+
+AudioMixer::Source* AudioMixer::GetOrCreateSource(const std::string& id) {
+  auto it = sources_.find(id);
+  if (it != sources_.end()) {
+    return it->second.get();
+  }
+
+  auto source = std::make_unique<Source>(output_config_.BytesPerMs() *
+                                         kSourceRingMs);
+  source->config = output_config_;
+  source->jitter_buffer.SetAudioConfig(source->config);
+  Source* raw = source.get();
+  sources_[id] = std::move(source);
+  return raw;
+}
+
+void AudioMixer::SetSourceConfig(const std::string& id,
+                                 const AudioConfig& config) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Source* source = GetOrCreateSource(id);
+  source->config = config;
+  source->jitter_buffer.SetAudioConfig(config);
+}
+
+void AudioMixer::RemoveSource(const std::string& id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  sources_.erase(id);
+}
+
+void AudioMixer::SetGain(const std::string& id, float gain) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  GetOrCreateSource(id)->gain = std::max(gain, 0.0f);
+}
+
+void AudioMixer::SetMute(const std::string& id, bool mute) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  GetOrCreateSource(id)->mute = mute;
+}
+
+void AudioMixer::SetExtraDelay(const std::string& id, int extra_delay_ms) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  GetOrCreateSource(id)->jitter_buffer.SetExtraDelay(extra_delay_ms);
+}
+
+void AudioMixer::SetComfortNoise(const std::string& id, int level_db) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  GetOrCreateSource(id)->jitter_buffer.SetComfortNoise(level_db);
+}
+
+void AudioMixer::WriteSource(Source* source,
+                             const std::vector<uint8_t>& shaped) {
+  const int16_t* in = reinterpret_cast<const int16_t*>(shaped.data());
+  int in_channels = source->config.channels;
+  int out_channels = output_config_.channels;
+
+  if (in_channels == out_channels) {
+    source->ring.Write(shaped.data(), shaped.size());
+    return;
+  }
+
+  size_t frames = shaped.size() / sizeof(int16_t) / in_channels;
+  source->converted.resize(frames * out_channels * sizeof(int16_t));
+  int16_t* out = reinterpret_cast<int16_t*>(source->converted.data());
+  for (size_t i = 0; i < frames; i++) {
+    if (in_channels == 1) {
+      // mono to stereo, duplicate
+      out[i * 2] = in[i];
+      out[i * 2 + 1] = in[i];
+    } else {
+      // stereo to mono, average
+      out[i] = (int16_t)(((int)in[i * 2] + (int)in[i * 2 + 1]) / 2);
+    }
+  }
+  source->ring.Write(source->converted.data(), source->converted.size());
+}
+
+void AudioMixer::Put(const std::string& id, const uint8_t* data, size_t size,
+                     uint64_t now_us) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Source* source = GetOrCreateSource(id);
+
+  // the playout buffer sees the queue in its own layout
+  size_t queued = source->ring.Size() / output_config_.channels *
+                  source->config.channels;
+  source->shaped.clear();
+  source->jitter_buffer.Put(data, size, queued, now_us, source->shaped);
+  if (!source->shaped.empty()) {
+    WriteSource(source, source->shaped);
+  }
+}
+
+void AudioMixer::Mix(size_t needed_bytes, std::vector<uint8_t>& out) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (needed_bytes == 0) {
+    return;
+  }
+
+  size_t block_samples =
+      (size_t)AudioConfig::kSampleRate / 1000 * kMixBlockMs *
+      output_config_.channels;
+  size_t block_bytes = block_samples * sizeof(int16_t);
+  block_.resize(block_samples);
+  mix_.resize(block_samples);
+
+  for (size_t produced = 0; produced < needed_bytes;
+       produced += block_bytes) {
+    std::fill(mix_.begin(), mix_.end(), 0);
+
+    for (auto& [_, source] : sources_) {
+      size_t available = source->ring.Size();
+      if (available < block_bytes) {
+        // conceal in the source layout, then bring it to the ring
+        size_t missing = (block_bytes - available) / output_config_.channels *
+                         source->config.channels;
+        source->shaped.clear();
+        source->jitter_buffer.Conceal(missing, source->shaped);
+        if (!source->shaped.empty()) {
+          WriteSource(source.get(), source->shaped);
+        }
+      }
+
+      size_t read = source->ring.Read(reinterpret_cast<uint8_t*>(block_.data()),
+                                      block_bytes);
+      if (source->mute || read == 0) {
+        continue;
+      }
+
+      size_t samples = read / sizeof(int16_t);
+      if (source->gain != 1.0f) {
+        ApplyGain(block_.data(), samples, source->gain);
+      }
+      MixSaturate(mix_.data(), block_.data(), samples);
+    }
+
+    const uint8_t* mixed = reinterpret_cast<const uint8_t*>(mix_.data());
+    out.insert(out.end(), mixed, mixed + block_bytes);
+  }
+}
+
+int AudioMixer::QueuedMs(const std::string& id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = sources_.find(id);
+  if (it == sources_.end()) {
+    return 0;
+  }
+  return (int)(it->second->ring.Size() / output_config_.BytesPerMs());
+}
+
+AudioJitterBuffer::Stats AudioMixer::GetStats(const std::string& id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = sources_.find(id);
+  if (it == sources_.end()) {
+    return AudioJitterBuffer::Stats();
+  }
+  return it->second->jitter_buffer.GetStats();
+}
+}  // namespace crossdesk
\ No newline at end of file
@@ -0,0 +1,80 @@
+/*
+ * @Author: DI JUNKUN
+ * @Date: 2026-10-19
+ * Copyright (c) 2026 by DI JUNKUN, All Rights Reserved.
+ */
+
+#ifndef _AUDIO_MIXER_H_
+#define _AUDIO_MIXER_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "audio_config.h"
+#include "audio_jitter_buffer.h"
+#include "audio_ring_buffer.h"
+
+namespace crossdesk {
+
+// Mixes the audio of every connected peer into one output. Each peer owns a
+// playout buffer and an input ring kept in the output layout, the output
+// pulls mixed blocks of a fixed duration.
+class AudioMixer {
+ public:
+  static constexpr int kMixBlockMs = 10;
+
+ public:
+  AudioMixer();
+  ~AudioMixer();
+
+ public:
+  void SetOutputConfig(const AudioConfig& output_config);
+  AudioConfig GetOutputConfig();
+
+  // sources are created on first use
+  void SetSourceConfig(const std::string& id, const AudioConfig& config);
+  void RemoveSource(const std::string& id);
+  void SetGain(const std::string& id, float gain);
+  void SetMute(const std::string& id, bool mute);
+  void SetExtraDelay(const std::string& id, int extra_delay_ms);
+  void SetComfortNoise(const std::string& id, int level_db);
+
+  // pcm s16 in the source layout, from the network thread
+  void Put(const std::string& id, const uint8_t* data, size_t size,
+           uint64_t now_us);
+
+  // appends at least needed_bytes of mixed output, whole blocks only
+  void Mix(size_t needed_bytes, std::vector<uint8_t>& out);
+
+  // buffered playout of a source in ms, not counting the output queue
+  int QueuedMs(const std::string& id);
+  AudioJitterBuffer::Stats GetStats(const std::string& id);
+
+ private:
+  struct Source {
+    explicit Source(size_t ring_capacity) : ring(ring_capacity) {}
+    AudioConfig config;
+    AudioJitterBuffer jitter_buffer;
+    AudioRingBuffer ring;
+    float gain = 1.0f;
+    bool mute = false;
+    std::vector<uint8_t> shaped;
+    std::vector<uint8_t> converted;
+  };
+
+  Source* GetOrCreateSource(const std::string& id);
+  void WriteSource(Source* source, const std::vector<uint8_t>& shaped);
+
+ private:
+  std::mutex mutex_;
+  AudioConfig output_config_;
+  std::unordered_map<std::string, std::unique_ptr<Source>> sources_;
+  std::vector<int16_t> block_;
+  std::vector<int16_t> mix_;
+};
+}  // namespace crossdesk
+#endif
\ No newline at end of file
@@ -0,0 +1,73 @@
+/*
+ * @Author: DI JUNKUN
+ * @Date: 2026-10-19
+ * Copyright (c) 2026 by DI JUNKUN, All Rights Reserved.
+ */
+
+#ifndef _AUDIO_RING_BUFFER_H_
+#define _AUDIO_RING_BUFFER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace crossdesk {
+
+// Fixed capacity single producer single consumer byte ring. Storage is
+// allocated once, Write and Read never allocate and never block.
+class AudioRingBuffer {
+ public:
+  explicit AudioRingBuffer(size_t capacity) : buffer_(capacity) {}
+
+  size_t Capacity() const { return buffer_.size(); }
+
+  size_t Size() const {
+    return write_pos_.load(std::memory_order_acquire) -
+           read_pos_.load(std::memory_order_acquire);
+  }
+
+  // returns the number of bytes written, short when the ring is full
+  size_t Write(const uint8_t* data, size_t len) {
+    size_t write_pos = write_pos_.load(std::memory_order_relaxed);
+    size_t read_pos = read_pos_.load(std::memory_order_acquire);
+    len = std::min(len, buffer_.size() - (write_pos - read_pos));
+
+    size_t offset = write_pos % buffer_.size();
+    size_t first = std::min(len, buffer_.size() - offset);
+    memcpy(buffer_.data() + offset, data, first);
+    memcpy(buffer_.data(), data + first, len - first);
+
+    write_pos_.store(write_pos + len, std::memory_order_release);
+    return len;
+  }
+
+  // returns the number of bytes read, short when the ring runs dry
+  size_t Read(uint8_t* data, size_t len) {
+    size_t read_pos = read_pos_.load(std::memory_order_relaxed);
+    size_t write_pos = write_pos_.load(std::memory_order_acquire);
+    len = std::min(len, write_pos - read_pos);
+
+    size_t offset = read_pos % buffer_.size();
+    size_t first = std::min(len, buffer_.size() - offset);
+    memcpy(data, buffer_.data() + offset, first);
+    memcpy(data + first, buffer_.data(), len - first);
+
+    read_pos_.store(read_pos + len, std::memory_order_release);
+    return len;
+  }
+
+  // only safe while neither side is running
+  void Clear() {
+    read_pos_.store(0, std::memory_order_relaxed);
+    write_pos_.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  std::vector<uint8_t> buffer_;
+  std::atomic<size_t> read_pos_{0};
+  std::atomic<size_t> write_pos_{0};
+};
+}  // namespace crossdesk
+#endif
\ No newline at end of file
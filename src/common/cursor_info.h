@@ -0,0 +1,35 @@
+/*
+ * @Author: DI JUNKUN
+ * @Date: 2026-10-19
+ * Copyright (c) 2026 by DI JUNKUN, All Rights Reserved.
+ */
+
+#ifndef _CURSOR_INFO_H_
+#define _CURSOR_INFO_H_
+
+namespace crossdesk {
+
+// platform independent cursor type, sent from host to viewers
+enum class CursorType {
+  ARROW = 0,
+  TEXT,
+  HAND,
+  CROSSHAIR,
+  RESIZE_EW,
+  RESIZE_NS,
+  RESIZE_NESW,
+  RESIZE_NWSE,
+  RESIZE_ALL,
+  NOT_ALLOWED,
+  HIDDEN
+};
+
+class CursorInfo {
+ public:
+  // position in virtual desktop coordinates
+  int x = 0;
+  int y = 0;
+  CursorType type = CursorType::ARROW;
+};
+}  // namespace crossdesk
+#endif
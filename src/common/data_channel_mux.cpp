@@ -0,0 +1,229 @@
+#include "data_channel_mux.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace crossdesk {
+
+// queues never grow without bound when the channel is down
+static const size_t kMaxQueueDepth[DataChannelMux::kPriorityCount] = {128, 128,
+                                                                      64};
+
+static uint64_t NowMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static void PutU32(uint8_t* p, uint32_t value) {
+  p[0] = (uint8_t)value;
+  p[1] = (uint8_t)(value >> 8);
+  p[2] = (uint8_t)(value >> 16);
+  p[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t GetU32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+const char* DataChannelMux::PriorityName(Priority priority) {
+  switch (priority) {
+    case Priority::INPUT:
+      return "input";
+    case Priority::CONTROL:
+      return "control";
+    default:
+      return "bulk";
+  }
+}
+
+bool DataChannelMux::IsChunk(const char* data, size_t size) {
+  return size >= kChunkHeaderSize && (uint8_t)data[0] == kChunkMarker;
+}
+
+void DataChannelMux::SetSender(send_cb cb) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cb_ = cb;
+}
+
+void DataChannelMux::SetBulkRate(size_t bytes_per_second) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  bulk_rate_ = std::max(bytes_per_second, kChunkSize);
+}
+
+int DataChannelMux::Send(Priority priority, const std::string& msg) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  int index = (int)priority;
+  std::deque<Message>& queue = queues_[index];
+  if (queue.size() >= kMaxQueueDepth[index]) {
+    queue.pop_front();
+    stats_[index].dropped++;
+  }
+
+  Message message;
+  message.data = msg;
+  message.enqueue_time_us = NowMicros();
+  // short bulk messages go out unchunked so older peers still read them
+  if (priority == Priority::BULK && msg.size() > kChunkSize) {
+    message.id = next_message_id_++;
+  }
+  queue.push_back(std::move(message));
+
+  if (priority != Priority::BULK) {
+    Flush(false, NowMicros());
+  }
+  return 0;
+}
+
+void DataChannelMux::Pump() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t now_us = NowMicros();
+  if (last_pump_us_ != 0) {
+    // at most 100 ms worth of burst after an idle period
+    bulk_budget_ = std::min(
+        bulk_budget_ + (double)bulk_rate_ * (now_us - last_pump_us_) / 1e6,
+        std::max((double)bulk_rate_ / 10, (double)kChunkSize));
+  }
+  last_pump_us_ = now_us;
+  Flush(true, now_us);
+}
+
+void DataChannelMux::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (int i = 0; i < kPriorityCount; i++) {
+    queues_[i].clear();
+  }
+  bulk_budget_ = 0;
+  last_pump_us_ = 0;
+}
+
+void DataChannelMux::Flush(bool include_bulk, uint64_t now_us) {
+  if (!cb_) {
+    return;
+  }
+
+  for (int i = 0; i < (int)Priority::BULK; i++) {
+    std::deque<Message>& queue = queues_[i];
+    while (!queue.empty()) {
+      Message& message = queue.front();
+      if (cb_(message.data.data(), message.data.size()) != 0) {
+        // stale input must not be replayed later, control keeps its order
+        // and the next pump retries
+        if (i == (int)Priority::INPUT) {
+          stats_[i].dropped++;
+          queue.pop_front();
+          continue;
+        }
+        return;
+      }
+      OnSent((Priority)i, message, now_us);
+      queue.pop_front();
+    }
+  }
+
+  if (!include_bulk) {
+    return;
+  }
+
+  std::deque<Message>& bulk = queues_[(int)Priority::BULK];
+  while (!bulk.empty() && bulk_budget_ > 0) {
+    Message& message = bulk.front();
+    size_t before = message.offset;
+    if (message.id == 0) {
+      if (cb_(message.data.data(), message.data.size()) != 0) {
+        return;
+      }
+      message.offset = message.data.size();
+    } else if (!SendChunk(message)) {
+      return;
+    }
+    bulk_budget_ -= (double)(message.offset - before);
+
+    if (message.offset >= message.data.size()) {
+      OnSent(Priority::BULK, message, now_us);
+      bulk.pop_front();
+    }
+  }
+}
+
+bool DataChannelMux::SendChunk(Message& message) {
+  size_t payload = std::min(kChunkSize, message.data.size() - message.offset);
+  uint8_t chunk[kChunkHeaderSize + kChunkSize];
+  chunk[0] = kChunkMarker;
+  PutU32(chunk + 1, message.id);
+  PutU32(chunk + 5, (uint32_t)message.offset);
+  PutU32(chunk + 9, (uint32_t)message.data.size());
+  memcpy(chunk + kChunkHeaderSize, message.data.data() + message.offset,
+         payload);
+
+  if (cb_((const char*)chunk, kChunkHeaderSize + payload) != 0) {
+    return false;
+  }
+  message.offset += payload;
+  return true;
+}
+
+void DataChannelMux::OnSent(Priority priority, const Message& message,
+                            uint64_t now_us) {
+  ClassStats& stats = stats_[(int)priority];
+  uint64_t latency_us =
+      now_us > message.enqueue_time_us ? now_us - message.enqueue_time_us : 0;
+  stats.sent++;
+  stats.bytes += message.data.size();
+  stats.avg_latency_us =
+      stats.sent == 1 ? latency_us
+                      : (stats.avg_latency_us * 15 + latency_us) / 16;
+  stats.max_latency_us = std::max(stats.max_latency_us, latency_us);
+}
+
+DataChannelMux::Stats DataChannelMux::GetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats stats;
+  for (int i = 0; i < kPriorityCount; i++) {
+    stats.classes[i] = stats_[i];
+    stats.classes[i].depth = queues_[i].size();
+  }
+  return stats;
+}
+
+bool DataChunkAssembler::Add(const char* data, size_t size,
+                             std::string* message) {
+  if (!DataChannelMux::IsChunk(data, size)) {
+    return false;
+  }
+
+  const uint8_t* header = (const uint8_t*)data;
+  uint32_t id = GetU32(header + 1);
+  size_t offset = GetU32(header + 5);
+  size_t total = GetU32(header + 9);
+  size_t payload = size - DataChannelMux::kChunkHeaderSize;
+  if (total == 0 || total > kMaxMessageSize || offset + payload > total) {
+    return false;
+  }
+
+  // a new id means the previous message was abandoned
+  if (id != id_ || buffer_.size() != total) {
+    id_ = id;
+    received_ = 0;
+    buffer_.assign(total, '\0');
+  }
+
+  memcpy(&buffer_[offset], data + DataChannelMux::kChunkHeaderSize, payload);
+  received_ += payload;
+  if (received_ < total) {
+    return false;
+  }
+
+  message->swap(buffer_);
+  Reset();
+  return true;
+}
+
+void DataChunkAssembler::Reset() {
+  id_ = 0;
+  received_ = 0;
+  buffer_.clear();
+}
+}  // namespace crossdesk
\ No newline at end of file
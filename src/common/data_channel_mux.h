@@ -0,0 +1,102 @@
+/*
+ * @Author: DI JUNKUN
+ * @Date: 2026-10-19
+ * Copyright (c) 2026 by DI JUNKUN, All Rights Reserved.
+ */
+
+#ifndef _DATA_CHANNEL_MUX_H_
+#define _DATA_CHANNEL_MUX_H_
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace crossdesk {
+
+// Schedules everything sent on one data channel by priority. Input and
+// control messages go out as soon as they are queued, bulk messages are
+// split into chunks that are paced by Pump() so they never sit in front
+// of input for long.
+class DataChannelMux {
+ public:
+  enum class Priority { INPUT = 0, CONTROL = 1, BULK = 2 };
+  static constexpr int kPriorityCount = 3;
+
+  struct ClassStats {
+    size_t depth = 0;
+    uint64_t sent = 0;
+    uint64_t bytes = 0;
+    uint64_t dropped = 0;
+    // queue to wire, for bulk until the last chunk is out
+    uint64_t avg_latency_us = 0;
+    uint64_t max_latency_us = 0;
+  };
+
+  struct Stats {
+    ClassStats classes[kPriorityCount];
+  };
+
+  typedef std::function<int(const char* data, size_t size)> send_cb;
+
+ public:
+  static constexpr size_t kChunkSize = 4096;
+  static constexpr size_t kDefaultBulkRate = 1024 * 1024;  // bytes per second
+  // chunks start with a byte json never starts with
+  static constexpr uint8_t kChunkMarker = 0xC7;
+  static constexpr size_t kChunkHeaderSize = 13;
+
+  static const char* PriorityName(Priority priority);
+  static bool IsChunk(const char* data, size_t size);
+
+ public:
+  void SetSender(send_cb cb);
+  void SetBulkRate(size_t bytes_per_second);
+
+  // queues the message, input and control are flushed right away
+  int Send(Priority priority, const std::string& msg);
+  // sends what is due, bulk within the rate budget, call it periodically
+  void Pump();
+  void Clear();
+  Stats GetStats();
+
+ private:
+  struct Message {
+    std::string data;
+    size_t offset = 0;
+    uint32_t id = 0;
+    uint64_t enqueue_time_us = 0;
+  };
+
+  void Flush(bool include_bulk, uint64_t now_us);
+  bool SendChunk(Message& message);
+  void OnSent(Priority priority, const Message& message, uint64_t now_us);
+
+ private:
+  std::mutex mutex_;
+  send_cb cb_ = nullptr;
+  std::deque<Message> queues_[kPriorityCount];
+  ClassStats stats_[kPriorityCount];
+  size_t bulk_rate_ = kDefaultBulkRate;
+  double bulk_budget_ = 0;
+  uint64_t last_pump_us_ = 0;
+  uint32_t next_message_id_ = 1;
+};
+
+// Rebuilds bulk messages from DataChannelMux chunks, one per sender.
+class DataChunkAssembler {
+ public:
+  static constexpr size_t kMaxMessageSize = 16 * 1024 * 1024;
+
+  // returns true and fills message once the last chunk arrived
+  bool Add(const char* data, size_t size, std::string* message);
+  void Reset();
+
+ private:
+  uint32_t id_ = 0;
+  size_t received_ = 0;
+  std::string buffer_;
+};
+}  // namespace crossdesk
+#endif
\ No newline at end of file
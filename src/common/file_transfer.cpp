@@ -0,0 +1,930 @@
+#include "file_transfer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <random>
+
+#include "rd_log.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace crossdesk {
+
+namespace {
+
+enum FrameType : uint8_t {
+  kOffer = 1,
+  kAccept,
+  kData,
+  kAck,
+  kDone,
+  kFailed,
+  kRequest,
+};
+
+// marker, type, transfer id
+constexpr size_t kFrameHeaderSize = 10;
+
+uint64_t NowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void PutU16(std::vector<uint8_t>& out, uint16_t value) {
+  out.push_back((uint8_t)value);
+  out.push_back((uint8_t)(value >> 8));
+}
+
+void PutU32(std::vector<uint8_t>& out, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    out.push_back((uint8_t)(value >> (i * 8)));
+  }
+}
+
+void PutU64(std::vector<uint8_t>& out, uint64_t value) {
+  for (int i = 0; i < 8; i++) {
+    out.push_back((uint8_t)(value >> (i * 8)));
+  }
+}
+
+uint16_t GetU16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+uint32_t GetU32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+uint64_t GetU64(const uint8_t* p) {
+  return (uint64_t)GetU32(p) | ((uint64_t)GetU32(p + 4) << 32);
+}
+
+std::vector<uint8_t> MakeFrame(FrameType type, uint64_t id,
+                               size_t body_size = 0) {
+  std::vector<uint8_t> frame;
+  frame.reserve(kFrameHeaderSize + body_size);
+  frame.push_back(FileTransfer::kMarker);
+  frame.push_back(type);
+  PutU64(frame, id);
+  return frame;
+}
+
+uint32_t ChunkCount(uint64_t size) {
+  return (uint32_t)((size + FileTransfer::kChunkSize - 1) /
+                    FileTransfer::kChunkSize);
+}
+
+}  // namespace
+
+// read only mapping of the whole file, chunks are sent straight from it
+class MappedFile {
+ public:
+  ~MappedFile() { Close(); }
+
+  int Open(const std::string& path) {
+    std::filesystem::path file_path = std::filesystem::u8path(path);
+#ifdef _WIN32
+    file_ = CreateFileW(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                        nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                        nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+      return -1;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_, &file_size)) {
+      return -1;
+    }
+    size_ = (uint64_t)file_size.QuadPart;
+    if (size_ == 0) {
+      return 0;
+    }
+    mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_) {
+      return -1;
+    }
+    data_ = (const uint8_t*)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+#else
+    fd_ = open(file_path.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+      return -1;
+    }
+    struct stat st;
+    if (fstat(fd_, &st) != 0 || !S_ISREG(st.st_mode)) {
+      return -1;
+    }
+    size_ = (uint64_t)st.st_size;
+    if (size_ == 0) {
+      return 0;
+    }
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (data == MAP_FAILED) {
+      return -1;
+    }
+    madvise(data, size_, MADV_SEQUENTIAL);
+    data_ = (const uint8_t*)data;
+#endif
+    return data_ ? 0 : -1;
+  }
+
+  void Close() {
+#ifdef _WIN32
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_) CloseHandle(mapping_);
+    if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+    mapping_ = nullptr;
+    file_ = INVALID_HANDLE_VALUE;
+#else
+    if (data_) munmap((void*)data_, size_);
+    if (fd_ >= 0) close(fd_);
+    fd_ = -1;
+#endif
+    data_ = nullptr;
+  }
+
+  const uint8_t* data() const { return data_; }
+  uint64_t size() const { return size_; }
+
+ private:
+#ifdef _WIN32
+  HANDLE file_ = INVALID_HANDLE_VALUE;
+  HANDLE mapping_ = nullptr;
+#else
+  int fd_ = -1;
+#endif
+  const uint8_t* data_ = nullptr;
+  uint64_t size_ = 0;
+};
+
+// positional writes, safe to call from several writer threads at once
+class ChunkWriter {
+ public:
+  ~ChunkWriter() { Close(); }
+
+  int Open(const std::string& path, uint64_t size) {
+    std::filesystem::path file_path = std::filesystem::u8path(path);
+#ifdef _WIN32
+    file_ = CreateFileW(file_path.c_str(), GENERIC_WRITE, 0, nullptr,
+                        OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+      return -1;
+    }
+    LARGE_INTEGER file_size;
+    file_size.QuadPart = (LONGLONG)size;
+    if (!SetFilePointerEx(file_, file_size, nullptr, FILE_BEGIN) ||
+        !SetEndOfFile(file_)) {
+      return -1;
+    }
+#else
+    fd_ = open(file_path.c_str(), O_WRONLY | O_CREAT, 0644);
+    if (fd_ < 0 || ftruncate(fd_, (off_t)size) != 0) {
+      return -1;
+    }
+#endif
+    return 0;
+  }
+
+  int Write(uint64_t offset, const uint8_t* data, size_t size) {
+#ifdef _WIN32
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = (DWORD)offset;
+    overlapped.OffsetHigh = (DWORD)(offset >> 32);
+    DWORD written = 0;
+    if (!WriteFile(file_, data, (DWORD)size, &written, &overlapped) ||
+        written != size) {
+      return -1;
+    }
+#else
+    while (size > 0) {
+      ssize_t written = pwrite(fd_, data, size, (off_t)offset);
+      if (written <= 0) {
+        return -1;
+      }
+      data += written;
+      offset += written;
+      size -= written;
+    }
+#endif
+    return 0;
+  }
+
+  void Close() {
+#ifdef _WIN32
+    if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+    file_ = INVALID_HANDLE_VALUE;
+#else
+    if (fd_ >= 0) close(fd_);
+    fd_ = -1;
+#endif
+  }
+
+ private:
+#ifdef _WIN32
+  HANDLE file_ = INVALID_HANDLE_VALUE;
+#else
+  int fd_ = -1;
+#endif
+};
+
+struct FileTransfer::Outgoing {
+  uint64_t id = 0;
+  std::string name;
+  MappedFile file;
+  uint32_t chunk_count = 0;
+  bool accepted = false;
+  bool finished = false;
+  bool failed = false;
+  uint32_t next_chunk = 0;
+  uint32_t acked = 0;
+  uint32_t resumed_from = 0;
+  uint64_t last_offer_ms = 0;
+  uint64_t last_progress_ms = 0;
+  uint64_t start_ms = 0;
+  uint64_t end_ms = 0;
+  bool reported = false;
+};
+
+struct FileTransfer::Incoming {
+  uint64_t id = 0;
+  std::string name;
+  uint64_t size = 0;
+  uint32_t chunk_count = 0;
+  std::string part_path;
+  std::string final_path;
+  ChunkWriter writer;
+  // queued or on disk, and on disk
+  std::vector<bool> pending;
+  std::vector<bool> written;
+  uint32_t contiguous = 0;
+  uint32_t last_acked = 0;
+  bool finished = false;
+  // writer threads check it before writing without taking mutex_
+  std::atomic<bool> failed{false};
+  uint64_t start_ms = 0;
+  uint64_t end_ms = 0;
+  bool reported = false;
+};
+
+struct FileTransfer::Request {
+  std::string name;
+  uint64_t start_ms = 0;
+  uint64_t end_ms = 0;
+  bool failed = false;
+  bool reported = false;
+};
+
+bool FileTransfer::IsFileMessage(const char* data, size_t size) {
+  return size >= kFrameHeaderSize && (uint8_t)data[0] == kMarker;
+}
+
+FileTransfer::FileTransfer() {}
+
+FileTransfer::~FileTransfer() {
+  {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    writers_running_ = false;
+  }
+  write_cond_.notify_all();
+  for (auto& thread : writer_threads_) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+}
+
+void FileTransfer::SetSender(send_cb cb) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cb_ = cb;
+}
+
+void FileTransfer::SetSaveDirectory(const std::string& save_directory) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  save_directory_ = save_directory;
+}
+
+int FileTransfer::SendFrame(const std::vector<uint8_t>& frame) {
+  if (!cb_) {
+    return -1;
+  }
+  return cb_((const char*)frame.data(), frame.size());
+}
+
+void FileTransfer::SetServeRequests(bool serve_requests) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  serve_requests_ = serve_requests;
+}
+
+void FileTransfer::SetAcceptUnrequestedOffers(bool accept) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  accept_unrequested_offers_ = accept;
+}
+
+static uint64_t NewTransferId() {
+  std::random_device random_device;
+  std::mt19937_64 random(((uint64_t)random_device() << 32) ^ random_device() ^
+                         NowMs());
+  uint64_t id = 0;
+  do {
+    id = random();
+  } while (id == 0);
+  return id;
+}
+
+uint64_t FileTransfer::SendFile(const std::string& path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return StartSend(path, NewTransferId());
+}
+
+uint64_t FileTransfer::RequestFile(const std::string& remote_path) {
+  std::string path = remote_path.substr(0, 4096);
+  uint64_t id = NewTransferId();
+  std::vector<uint8_t> frame = MakeFrame(kRequest, id, 2 + path.size());
+  PutU16(frame, (uint16_t)path.size());
+  frame.insert(frame.end(), path.begin(), path.end());
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  Request& request = requests_[id];
+  // the peer's path syntax may differ from ours, keep the last component
+  size_t slash = path.find_last_of("/\\");
+  request.name = slash == std::string::npos ? path : path.substr(slash + 1);
+  request.start_ms = NowMs();
+  LOG_INFO("Request file [{}]", path);
+  if (SendFrame(frame) != 0) {
+    request.failed = true;
+    request.end_ms = request.start_ms;
+  }
+  return id;
+}
+
+uint64_t FileTransfer::StartSend(const std::string& path, uint64_t id) {
+  auto outgoing = std::make_unique<Outgoing>();
+  if (outgoing->file.Open(path) != 0) {
+    LOG_ERROR("Open [{}] for transfer failed", path);
+    return 0;
+  }
+  if (outgoing->file.size() > kMaxFileSize) {
+    LOG_ERROR("File [{}] is too large to transfer, {} bytes", path,
+              outgoing->file.size());
+    return 0;
+  }
+
+  outgoing->id = id;
+  outgoing->name = std::filesystem::u8path(path).filename().u8string();
+  outgoing->chunk_count = ChunkCount(outgoing->file.size());
+  outgoing->start_ms = NowMs();
+  LOG_INFO("Send file [{}], {} bytes", outgoing->name, outgoing->file.size());
+
+  SendOffer(*outgoing, outgoing->start_ms);
+  outgoing_[id] = std::move(outgoing);
+  return id;
+}
+
+void FileTransfer::Cancel(uint64_t id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = outgoing_.find(id);
+  if (it != outgoing_.end() && !it->second->finished &&
+      !it->second->failed) {
+    it->second->failed = true;
+    it->second->end_ms = NowMs();
+    it->second->file.Close();
+    SendDone(id, true);
+  }
+}
+
+void FileTransfer::SendOffer(Outgoing& outgoing, uint64_t now_ms) {
+  std::string name = outgoing.name.substr(0, 1024);
+  std::vector<uint8_t> frame = MakeFrame(kOffer, outgoing.id, 14 + name.size());
+  PutU64(frame, outgoing.file.size());
+  PutU32(frame, (uint32_t)kChunkSize);
+  PutU16(frame, (uint16_t)name.size());
+  frame.insert(frame.end(), name.begin(), name.end());
+  SendFrame(frame);
+  outgoing.last_offer_ms = now_ms;
+}
+
+void FileTransfer::FillWindow(Outgoing& outgoing) {
+  std::vector<uint8_t> frame;
+  while (outgoing.next_chunk < outgoing.chunk_count &&
+         outgoing.next_chunk < outgoing.acked + kWindowChunks) {
+    uint64_t offset = (uint64_t)outgoing.next_chunk * kChunkSize;
+    size_t payload =
+        (size_t)std::min<uint64_t>(kChunkSize, outgoing.file.size() - offset);
+
+    frame = MakeFrame(kData, outgoing.id, 4 + payload);
+    PutU32(frame, outgoing.next_chunk);
+    frame.insert(frame.end(), outgoing.file.data() + offset,
+                 outgoing.file.data() + offset + payload);
+    if (SendFrame(frame) != 0) {
+      // the timeout rewinds and tries again
+      return;
+    }
+    outgoing.next_chunk++;
+  }
+}
+
+void FileTransfer::Pump() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t now_ms = NowMs();
+  PruneFinished(now_ms);
+  for (auto& [id, request] : requests_) {
+    if (!request.failed && now_ms - request.start_ms >= kGiveUpTimeoutMs) {
+      LOG_ERROR("Request for [{}] got no answer, giving up", request.name);
+      request.failed = true;
+      request.end_ms = now_ms;
+    }
+  }
+  for (auto& [id, outgoing] : outgoing_) {
+    if (outgoing->finished || outgoing->failed) {
+      continue;
+    }
+
+    if (now_ms - outgoing->last_progress_ms >= kGiveUpTimeoutMs &&
+        now_ms - outgoing->start_ms >= kGiveUpTimeoutMs) {
+      LOG_ERROR("File [{}] transfer stalled, giving up", outgoing->name);
+      outgoing->failed = true;
+      outgoing->end_ms = now_ms;
+      outgoing->file.Close();
+      continue;
+    }
+
+    if (!outgoing->accepted) {
+      if (now_ms - outgoing->last_offer_ms >= kRetransmitTimeoutMs) {
+        SendOffer(*outgoing, now_ms);
+      }
+      continue;
+    }
+
+    if (now_ms - outgoing->last_progress_ms >= kRetransmitTimeoutMs) {
+      // no ack for a while, the peer may have reconnected, ask again and
+      // continue from whatever it has on disk
+      outgoing->accepted = false;
+      outgoing->next_chunk = outgoing->acked;
+      SendOffer(*outgoing, now_ms);
+      continue;
+    }
+    FillWindow(*outgoing);
+  }
+}
+
+void FileTransfer::OnMessage(const char* data, size_t size) {
+  if (!IsFileMessage(data, size)) {
+    return;
+  }
+
+  const uint8_t* frame = (const uint8_t*)data;
+  uint8_t type = frame[1];
+  uint64_t id = GetU64(frame + 2);
+  const uint8_t* body = frame + kFrameHeaderSize;
+  size_t body_size = size - kFrameHeaderSize;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  switch (type) {
+    case kRequest:
+      OnRequest(id, body, body_size);
+      break;
+    case kOffer:
+      OnOffer(id, body, body_size);
+      break;
+    case kAccept:
+      OnAccept(id, body, body_size);
+      break;
+    case kData:
+      OnData(id, body, body_size);
+      break;
+    case kAck:
+      OnAck(id, body, body_size);
+      break;
+    case kDone:
+    case kFailed:
+      OnDone(id, type == kFailed);
+      break;
+    default:
+      break;
+  }
+}
+
+void FileTransfer::OnRequest(uint64_t id, const uint8_t* body, size_t size) {
+  if (size < 2 || size < 2 + (size_t)GetU16(body)) {
+    return;
+  }
+  // asked again after a reconnect, the offer retransmits on its own
+  if (outgoing_.count(id)) {
+    return;
+  }
+
+  std::string path((const char*)body + 2, GetU16(body));
+  if (!serve_requests_) {
+    LOG_WARN("Refuse request for [{}], serving files is off", path);
+    SendDone(id, true);
+    return;
+  }
+  LOG_INFO("Peer requested [{}]", path);
+  if (StartSend(path, id) == 0) {
+    SendDone(id, true);
+  }
+}
+
+void FileTransfer::OnOffer(uint64_t id, const uint8_t* body, size_t size) {
+  if (size < 14) {
+    return;
+  }
+  uint64_t file_size = GetU64(body);
+  uint32_t chunk_size = GetU32(body + 8);
+  size_t name_size = GetU16(body + 12);
+  if (chunk_size != kChunkSize || size < 14 + name_size) {
+    SendDone(id, true);
+    return;
+  }
+  if (file_size > kMaxFileSize) {
+    LOG_ERROR("Refuse file offer of {} bytes", file_size);
+    SendDone(id, true);
+    return;
+  }
+
+  auto it = incoming_.find(id);
+  if (it != incoming_.end()) {
+    // offered again after a reconnect, resume from the disk prefix
+    Incoming& incoming = *it->second;
+    if (incoming.finished || incoming.failed) {
+      SendDone(id, incoming.failed);
+      return;
+    }
+    std::vector<uint8_t> frame = MakeFrame(kAccept, id, 4);
+    PutU32(frame, incoming.contiguous);
+    SendFrame(frame);
+    return;
+  }
+
+  auto request = requests_.find(id);
+  if (request == requests_.end() && !accept_unrequested_offers_) {
+    LOG_WARN("Refuse unrequested file offer of {} bytes", file_size);
+    SendDone(id, true);
+    return;
+  }
+  if (request != requests_.end()) {
+    requests_.erase(request);
+  }
+
+  if (save_directory_.empty()) {
+    SendDone(id, true);
+    return;
+  }
+
+  // only the file name is trusted, never a path from the peer
+  std::string name((const char*)body + 14, name_size);
+  std::filesystem::path file_name =
+      std::filesystem::u8path(name).filename();
+  if (file_name.empty() || file_name == "." || file_name == "..") {
+    file_name = "received_file";
+  }
+
+  std::error_code ec;
+  std::filesystem::path directory = std::filesystem::u8path(save_directory_);
+  std::filesystem::create_directories(directory, ec);
+  std::filesystem::space_info space = std::filesystem::space(directory, ec);
+  if (!ec && space.available < file_size) {
+    LOG_ERROR("Refuse file offer of {} bytes, {} bytes free", file_size,
+              space.available);
+    SendDone(id, true);
+    return;
+  }
+  std::filesystem::path final_path = directory / file_name;
+  for (int i = 1; std::filesystem::exists(final_path, ec) ||
+                  std::filesystem::exists(final_path.u8string() + ".part", ec);
+       i++) {
+    final_path = directory / (file_name.stem().u8string() + " (" +
+                              std::to_string(i) + ")" +
+                              file_name.extension().u8string());
+  }
+
+  auto incoming = std::make_shared<Incoming>();
+  incoming->id = id;
+  incoming->name = file_name.u8string();
+  incoming->size = file_size;
+  incoming->chunk_count = ChunkCount(file_size);
+  incoming->final_path = final_path.u8string();
+  incoming->part_path = incoming->final_path + ".part";
+  incoming->pending.assign(incoming->chunk_count, false);
+  incoming->written.assign(incoming->chunk_count, false);
+  incoming->start_ms = NowMs();
+  if (incoming->writer.Open(incoming->part_path, file_size) != 0) {
+    LOG_ERROR("Create [{}] failed", incoming->part_path);
+    SendDone(id, true);
+    return;
+  }
+  LOG_INFO("Receive file [{}], {} bytes", incoming->name, file_size);
+  incoming_[id] = incoming;
+
+  std::vector<uint8_t> frame = MakeFrame(kAccept, id, 4);
+  PutU32(frame, 0);
+  SendFrame(frame);
+  if (incoming->chunk_count == 0) {
+    FinishIncoming(*incoming);
+  }
+}
+
+void FileTransfer::OnAccept(uint64_t id, const uint8_t* body, size_t size) {
+  auto it = outgoing_.find(id);
+  if (it == outgoing_.end() || size < 4) {
+    return;
+  }
+
+  Outgoing& outgoing = *it->second;
+  if (outgoing.finished || outgoing.failed) {
+    return;
+  }
+  uint32_t resume = std::min(GetU32(body), outgoing.chunk_count);
+  if (resume > 0 && outgoing.acked == 0) {
+    outgoing.resumed_from = resume;
+  }
+  outgoing.accepted = true;
+  outgoing.acked = std::max(outgoing.acked, resume);
+  // anything in flight before the offer is lost
+  outgoing.next_chunk = outgoing.acked;
+  outgoing.last_progress_ms = NowMs();
+  FillWindow(outgoing);
+}
+
+void FileTransfer::OnData(uint64_t id, const uint8_t* body, size_t size) {
+  auto it = incoming_.find(id);
+  if (it == incoming_.end() || size < 4) {
+    return;
+  }
+
+  std::shared_ptr<Incoming> incoming = it->second;
+  uint32_t chunk = GetU32(body);
+  if (incoming->finished || incoming->failed ||
+      chunk >= incoming->chunk_count) {
+    return;
+  }
+  if (incoming->pending[chunk]) {
+    // a retransmission, tell the sender where the disk really is
+    SendAck(id, incoming->contiguous);
+    return;
+  }
+
+  uint64_t offset = (uint64_t)chunk * kChunkSize;
+  size_t expected =
+      (size_t)std::min<uint64_t>(kChunkSize, incoming->size - offset);
+  if (size - 4 != expected) {
+    return;
+  }
+
+  incoming->pending[chunk] = true;
+  StartWriters();
+  {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    write_queue_.push_back(
+        WriteTask{incoming, chunk, std::vector<uint8_t>(body + 4, body + size)});
+  }
+  write_cond_.notify_one();
+}
+
+void FileTransfer::OnAck(uint64_t id, const uint8_t* body, size_t size) {
+  auto it = outgoing_.find(id);
+  if (it == outgoing_.end() || size < 4) {
+    return;
+  }
+
+  Outgoing& outgoing = *it->second;
+  uint32_t contiguous = std::min(GetU32(body), outgoing.chunk_count);
+  if (contiguous > outgoing.acked) {
+    outgoing.acked = contiguous;
+    outgoing.last_progress_ms = NowMs();
+  }
+  if (outgoing.accepted && !outgoing.finished && !outgoing.failed) {
+    FillWindow(outgoing);
+  }
+}
+
+void FileTransfer::OnDone(uint64_t id, bool failed) {
+  auto it = outgoing_.find(id);
+  if (it != outgoing_.end()) {
+    Outgoing& outgoing = *it->second;
+    if (outgoing.finished || outgoing.failed) {
+      return;
+    }
+    outgoing.end_ms = NowMs();
+    outgoing.failed = failed;
+    outgoing.finished = !failed;
+    outgoing.acked = failed ? outgoing.acked : outgoing.chunk_count;
+    outgoing.file.Close();
+    LOG_INFO("File [{}] transfer {} in {} ms", outgoing.name,
+             failed ? "failed" : "finished",
+             outgoing.end_ms - outgoing.start_ms);
+    return;
+  }
+
+  // the peer could not serve a request
+  auto request = requests_.find(id);
+  if (request != requests_.end()) {
+    if (!request->second.failed) {
+      LOG_ERROR("Request for [{}] refused", request->second.name);
+      request->second.failed = true;
+      request->second.end_ms = NowMs();
+    }
+    return;
+  }
+
+  // the sender gave up, queued writes may still hold the file open
+  auto in = incoming_.find(id);
+  if (in != incoming_.end() && !in->second->finished &&
+      !in->second->failed) {
+    in->second->failed = true;
+    in->second->end_ms = NowMs();
+    std::error_code ec;
+    std::filesystem::remove(std::filesystem::u8path(in->second->part_path),
+                            ec);
+  }
+}
+
+void FileTransfer::SendAck(uint64_t id, uint32_t contiguous) {
+  std::vector<uint8_t> frame = MakeFrame(kAck, id, 4);
+  PutU32(frame, contiguous);
+  SendFrame(frame);
+}
+
+void FileTransfer::SendDone(uint64_t id, bool failed) {
+  SendFrame(MakeFrame(failed ? kFailed : kDone, id));
+}
+
+void FileTransfer::StartWriters() {
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  if (writers_running_) {
+    return;
+  }
+  writers_running_ = true;
+  for (int i = 0; i < kWriterThreads; i++) {
+    writer_threads_.emplace_back(&FileTransfer::WriteLoop, this);
+  }
+}
+
+void FileTransfer::WriteLoop() {
+  while (true) {
+    WriteTask task;
+    {
+      std::unique_lock<std::mutex> lock(write_mutex_);
+      write_cond_.wait(
+          lock, [this] { return !writers_running_ || !write_queue_.empty(); });
+      if (!writers_running_) {
+        return;
+      }
+      task = std::move(write_queue_.front());
+      write_queue_.pop_front();
+    }
+
+    Incoming& incoming = *task.incoming;
+    // writes of different chunks run in parallel, only the bookkeeping
+    // below is serialized
+    int ret = incoming.failed ? -1
+                              : incoming.writer.Write(
+                                    (uint64_t)task.chunk * kChunkSize,
+                                    task.data.data(), task.data.size());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (incoming.failed || incoming.finished) {
+      continue;
+    }
+    if (ret != 0) {
+      LOG_ERROR("Write [{}] failed", incoming.part_path);
+      incoming.failed = true;
+      incoming.end_ms = NowMs();
+      SendDone(incoming.id, true);
+      continue;
+    }
+
+    incoming.written[task.chunk] = true;
+    while (incoming.contiguous < incoming.chunk_count &&
+           incoming.written[incoming.contiguous]) {
+      incoming.contiguous++;
+    }
+    if (incoming.contiguous == incoming.chunk_count) {
+      SendAck(incoming.id, incoming.contiguous);
+      FinishIncoming(incoming);
+    } else if (incoming.contiguous - incoming.last_acked >= kAckEveryChunks) {
+      incoming.last_acked = incoming.contiguous;
+      SendAck(incoming.id, incoming.contiguous);
+    }
+  }
+}
+
+void FileTransfer::FinishIncoming(Incoming& incoming) {
+  incoming.writer.Close();
+  std::error_code ec;
+  std::filesystem::rename(std::filesystem::u8path(incoming.part_path),
+                          std::filesystem::u8path(incoming.final_path), ec);
+  incoming.end_ms = NowMs();
+  if (ec) {
+    LOG_ERROR("Rename [{}] failed: {}", incoming.part_path, ec.message());
+    incoming.failed = true;
+    SendDone(incoming.id, true);
+    return;
+  }
+
+  incoming.finished = true;
+  LOG_INFO("File saved to [{}] in {} ms", incoming.final_path,
+           incoming.end_ms - incoming.start_ms);
+  SendDone(incoming.id, false);
+}
+
+void FileTransfer::PruneFinished(uint64_t now_ms) {
+  for (auto it = outgoing_.begin(); it != outgoing_.end();) {
+    Outgoing& outgoing = *it->second;
+    if ((outgoing.finished || outgoing.failed) &&
+        (outgoing.reported || now_ms - outgoing.end_ms >= kKeepFinishedMs)) {
+      it = outgoing_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  for (auto it = requests_.begin(); it != requests_.end();) {
+    Request& request = it->second;
+    if (request.failed && (request.reported ||
+                           now_ms - request.end_ms >= kKeepFinishedMs)) {
+      it = requests_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  // a sender that missed the done frame offers again until it gives up,
+  // keep the entry until then so it is answered instead of saved twice.
+  // queued writes hold their own reference
+  for (auto it = incoming_.begin(); it != incoming_.end();) {
+    Incoming& incoming = *it->second;
+    uint64_t age_ms = now_ms - incoming.end_ms;
+    if ((incoming.finished || incoming.failed) && age_ms >= kGiveUpTimeoutMs &&
+        (incoming.reported || age_ms >= kKeepFinishedMs)) {
+      it = incoming_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+std::vector<FileTransfer::Progress> FileTransfer::GetProgress() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t now_ms = NowMs();
+  std::vector<Progress> progress_list;
+  auto throughput = [now_ms](uint64_t bytes, uint64_t start_ms,
+                             uint64_t end_ms) -> uint64_t {
+    uint64_t elapsed_ms = (end_ms ? end_ms : now_ms) - start_ms;
+    return elapsed_ms ? bytes * 1000 / elapsed_ms : 0;
+  };
+
+  for (auto& [id, outgoing] : outgoing_) {
+    Progress progress;
+    progress.id = id;
+    progress.name = outgoing->name;
+    progress.size = outgoing->file.size();
+    progress.done_bytes = std::min<uint64_t>(
+        (uint64_t)outgoing->acked * kChunkSize, progress.size);
+    progress.outgoing = true;
+    progress.finished = outgoing->finished;
+    progress.failed = outgoing->failed;
+    // resumed bytes were not moved by this session
+    uint64_t moved = progress.done_bytes -
+                     std::min<uint64_t>((uint64_t)outgoing->resumed_from *
+                                            kChunkSize,
+                                        progress.done_bytes);
+    progress.bytes_per_second =
+        throughput(moved, outgoing->start_ms, outgoing->end_ms);
+    outgoing->reported = progress.finished || progress.failed;
+    progress_list.push_back(progress);
+  }
+
+  for (auto& [id, incoming] : incoming_) {
+    Progress progress;
+    progress.id = id;
+    progress.name = incoming->name;
+    progress.size = incoming->size;
+    progress.done_bytes = std::min<uint64_t>(
+        (uint64_t)incoming->contiguous * kChunkSize, incoming->size);
+    progress.finished = incoming->finished;
+    progress.failed = incoming->failed;
+    progress.bytes_per_second =
+        throughput(progress.done_bytes, incoming->start_ms, incoming->end_ms);
+    incoming->reported = progress.finished || progress.failed;
+    progress_list.push_back(progress);
+  }
+
+  for (auto& [id, request] : requests_) {
+    Progress progress;
+    progress.id = id;
+    progress.name = request.name;
+    progress.failed = request.failed;
+    request.reported = request.failed;
+    progress_list.push_back(progress);
+  }
+  return progress_list;
+}
+}  // namespace crossdesk
\ No newline at end of file
@@ -0,0 +1,135 @@
+/*
+ * @Author: DI JUNKUN
+ * @Date: 2026-10-19
+ * Copyright (c) 2026 by DI JUNKUN, All Rights Reserved.
+ */
+
+#ifndef _FILE_TRANSFER_H_
+#define _FILE_TRANSFER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace crossdesk {
+
+// Moves files over a dedicated data stream. The sender maps the file and
+// keeps a window of fixed size chunks in flight, the receiver writes
+// chunks at their offsets from a small writer pool and acknowledges the
+// contiguous prefix on disk. Unfinished transfers are offered again until
+// the receiver answers, which resumes them after a reconnect. Either side
+// can also ask the other for a file by path. The other side serves it only
+// when serving is enabled, and a side that does not accept unrequested
+// offers refuses files it did not ask for.
+class FileTransfer {
+ public:
+  struct Progress {
+    uint64_t id = 0;
+    std::string name;
+    uint64_t size = 0;
+    uint64_t done_bytes = 0;
+    bool outgoing = false;
+    bool finished = false;
+    bool failed = false;
+    uint64_t bytes_per_second = 0;
+  };
+
+  typedef std::function<int(const char* data, size_t size)> send_cb;
+
+ public:
+  static constexpr size_t kChunkSize = 16 * 1024;
+  static constexpr uint32_t kWindowChunks = 64;
+  static constexpr uint32_t kAckEveryChunks = 8;
+  static constexpr int kWriterThreads = 2;
+  // no answer or no ack progress for this long rewinds to the last ack
+  static constexpr uint64_t kRetransmitTimeoutMs = 2000;
+  static constexpr uint64_t kGiveUpTimeoutMs = 120000;
+  // offers above this are refused, it also keeps the chunk count in 32 bits
+  static constexpr uint64_t kMaxFileSize = 256ull << 30;
+  // finished transfers are dropped once reported, or after this if nobody
+  // asks for progress
+  static constexpr uint64_t kKeepFinishedMs = 600000;
+  // file frames start with a byte json and data channel chunks never use
+  static constexpr uint8_t kMarker = 0xF7;
+
+  static bool IsFileMessage(const char* data, size_t size);
+
+  FileTransfer();
+  ~FileTransfer();
+
+ public:
+  void SetSender(send_cb cb);
+  void SetSaveDirectory(const std::string& save_directory);
+  // the host serves requests, a viewer only takes what it asked for
+  void SetServeRequests(bool serve_requests);
+  void SetAcceptUnrequestedOffers(bool accept);
+
+  // returns the transfer id, 0 when the file cannot be read
+  uint64_t SendFile(const std::string& path);
+  // asks the peer to send one of its files, returns the transfer id
+  uint64_t RequestFile(const std::string& remote_path);
+  void Cancel(uint64_t id);
+
+  void OnMessage(const char* data, size_t size);
+  // refills windows and handles timeouts, call it periodically
+  void Pump();
+
+  // finished and failed transfers are returned at least once
+  std::vector<Progress> GetProgress();
+
+ private:
+  struct Outgoing;
+  struct Incoming;
+  struct Request;
+  struct WriteTask {
+    std::shared_ptr<Incoming> incoming;
+    uint32_t chunk;
+    std::vector<uint8_t> data;
+  };
+
+  uint64_t StartSend(const std::string& path, uint64_t id);
+  void SendOffer(Outgoing& outgoing, uint64_t now_ms);
+  void FillWindow(Outgoing& outgoing);
+  int SendFrame(const std::vector<uint8_t>& frame);
+
+  void OnRequest(uint64_t id, const uint8_t* body, size_t size);
+  void OnOffer(uint64_t id, const uint8_t* body, size_t size);
+  void OnAccept(uint64_t id, const uint8_t* body, size_t size);
+  void OnData(uint64_t id, const uint8_t* body, size_t size);
+  void OnAck(uint64_t id, const uint8_t* body, size_t size);
+  void OnDone(uint64_t id, bool failed);
+
+  void SendAck(uint64_t id, uint32_t contiguous);
+  void SendDone(uint64_t id, bool failed);
+  void StartWriters();
+  void WriteLoop();
+  void FinishIncoming(Incoming& incoming);
+  void PruneFinished(uint64_t now_ms);
+
+ private:
+  std::mutex mutex_;
+  send_cb cb_ = nullptr;
+  std::string save_directory_;
+  bool serve_requests_ = false;
+  bool accept_unrequested_offers_ = true;
+  std::unordered_map<uint64_t, std::unique_ptr<Outgoing>> outgoing_;
+  std::unordered_map<uint64_t, std::shared_ptr<Incoming>> incoming_;
+  // asked for, no offer yet
+  std::unordered_map<uint64_t, Request> requests_;
+
+  std::mutex write_mutex_;
+  std::condition_variable write_cond_;
+  std::deque<WriteTask> write_queue_;
+  std::vector<std::thread> writer_threads_;
+  bool writers_running_ = false;
+};
+}  // namespace crossdesk
+#endif
\ No newline at end of file
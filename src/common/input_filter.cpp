@@ -0,0 +1,98 @@
+#include "input_filter.h"
+
+#include <algorithm>
+
+namespace crossdesk {
+
+InputFilter::InputFilter(uint64_t stale_threshold_us, uint64_t hold_us)
+    : stale_threshold_us_(stale_threshold_us), hold_us_(hold_us) {}
+
+InputFilter::~InputFilter() {}
+
+// sequence numbers wrap, compare them the way RTP does
+static bool IsNewerSeq(uint32_t seq, uint32_t prev) {
+  return seq != prev && static_cast<uint32_t>(seq - prev) < 0x80000000u;
+}
+
+InputFilter::Verdict InputFilter::Accept(const std::string& remote_id,
+                                         uint32_t seq, uint64_t timestamp_us,
+                                         bool is_move, uint64_t now_us) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Remote& remote = remotes_[remote_id];
+  remote.stats.received++;
+
+  if (seq == 0) {
+    return Verdict::APPLY;
+  }
+
+  bool late = false;
+  if (timestamp_us != 0) {
+    int64_t offset_us = (int64_t)(now_us - timestamp_us);
+    if (!remote.has_offset) {
+      remote.min_offset_us = offset_us;
+      remote.prev_min_offset_us = offset_us;
+      remote.window_start_us = now_us;
+      remote.has_offset = true;
+    } else if (now_us - remote.window_start_us >= kOffsetWindowUs) {
+      remote.prev_min_offset_us = remote.min_offset_us;
+      remote.min_offset_us = offset_us;
+      remote.window_start_us = now_us;
+    }
+    remote.min_offset_us = std::min(remote.min_offset_us, offset_us);
+    int64_t baseline_us =
+        std::min(remote.min_offset_us, remote.prev_min_offset_us);
+    late = (uint64_t)(offset_us - baseline_us) > stale_threshold_us_;
+  }
+
+  if (!is_move) {
+    if (late) {
+      remote.stats.late_events++;
+    }
+    if (remote.held) {
+      remote.held = false;
+      return Verdict::APPLY_HELD_FIRST;
+    }
+    return Verdict::APPLY;
+  }
+
+  if (remote.last_move_seq != 0 && !IsNewerSeq(seq, remote.last_move_seq)) {
+    remote.stats.dropped_moves++;
+    return Verdict::DROP;
+  }
+  remote.last_move_seq = seq;
+
+  // a newer move supersedes the held one either way
+  if (remote.held) {
+    remote.stats.dropped_moves++;
+    remote.held = false;
+  }
+  if (late) {
+    remote.held = true;
+    remote.held_since_us = now_us;
+    return Verdict::HOLD;
+  }
+  return Verdict::APPLY;
+}
+
+bool InputFilter::TakeHeldMove(const std::string& remote_id, uint64_t now_us) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = remotes_.find(remote_id);
+  if (it == remotes_.end() || !it->second.held ||
+      now_us - it->second.held_since_us < hold_us_) {
+    return false;
+  }
+  it->second.held = false;
+  return true;
+}
+
+void InputFilter::Reset(const std::string& remote_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  remotes_.erase(remote_id);
+}
+
+InputFilter::Stats InputFilter::GetStats(const std::string& remote_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = remotes_.find(remote_id);
+  return it == remotes_.end() ? Stats() : it->second.stats;
+}
+}  // namespace crossdesk
\ No newline at end of file
@@ -0,0 +1,78 @@
+/*
+ * @Author: DI JUNKUN
+ * @Date: 2026-10-19
+ * Copyright (c) 2026 by DI JUNKUN, All Rights Reserved.
+ */
+
+#ifndef _INPUT_FILTER_H_
+#define _INPUT_FILTER_H_
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace crossdesk {
+
+// Drops pointer moves that were superseded while the data channel stalled.
+// A late move is held instead of applied, a newer move replaces it and a
+// button or key transition applies it first, so clicks land where the
+// pointer was. Lateness is measured against the lowest delay seen from the
+// remote over the last two windows, so neither a clock offset nor a later
+// clock step makes all input late for long.
+class InputFilter {
+ public:
+  enum class Verdict {
+    APPLY,
+    // apply the held move, then this event
+    APPLY_HELD_FIRST,
+    HOLD,
+    DROP,
+  };
+
+  struct Stats {
+    uint64_t received = 0;
+    uint64_t dropped_moves = 0;
+    uint64_t late_events = 0;
+  };
+
+ public:
+  // a held move with nothing newer behind it is applied after hold_us
+  static constexpr uint64_t kOffsetWindowUs = 5000000;
+
+  explicit InputFilter(uint64_t stale_threshold_us = 200000,
+                       uint64_t hold_us = 30000);
+  ~InputFilter();
+
+ public:
+  // seq 0 means the sender does not number its input, accept everything
+  Verdict Accept(const std::string& remote_id, uint32_t seq,
+                 uint64_t timestamp_us, bool is_move, uint64_t now_us);
+  // true when the held move waited long enough and should be applied now
+  bool TakeHeldMove(const std::string& remote_id, uint64_t now_us);
+  void Reset(const std::string& remote_id);
+  Stats GetStats(const std::string& remote_id);
+
+ private:
+  struct Remote {
+    // newest move sequence number accepted
+    uint32_t last_move_seq = 0;
+    // lowest receive time minus send time, path delay plus clock offset,
+    // for the current and the previous window
+    int64_t min_offset_us = 0;
+    int64_t prev_min_offset_us = 0;
+    uint64_t window_start_us = 0;
+    bool has_offset = false;
+    bool held = false;
+    uint64_t held_since_us = 0;
+    Stats stats;
+  };
+
+ private:
+  uint64_t stale_threshold_us_;
+  uint64_t hold_us_;
+  std::mutex mutex_;
+  std::unordered_map<std::string, Remote> remotes_;
+};
+}  // namespace crossdesk
+#endif
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include "latency_marker.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace crossdesk {
+
+namespace {
+
+constexpr uint8_t kWhite = 235;
+constexpr uint8_t kBlack = 16;
+// the smallest white to black step accepted as a marker
+constexpr int kMinContrast = 64;
+constexpr int kSyncBits = 4;
+constexpr int kCrcBits = 8;
+constexpr int kBits = LatencyMarker::kColumns * LatencyMarker::kRows;
+static_assert(kSyncBits * 2 + LatencyMarker::kTimestampBits + kCrcBits == kBits,
+              "marker layout does not fill the grid");
+// leading sync is 1010, trailing sync is 0101
+constexpr bool kLeadingSync[kSyncBits] = {true, false, true, false};
+constexpr bool kTrailingSync[kSyncBits] = {false, true, false, true};
+
+uint8_t Crc8(uint64_t value) {
+  uint8_t crc = 0;
+  for (int i = 0; i < LatencyMarker::kTimestampBits / 8; i++) {
+    crc ^= (uint8_t)(value >> (i * 8));
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+void EncodeBits(uint64_t timestamp_us, bool* bits) {
+  int index = 0;
+  for (int i = 0; i < kSyncBits; i++) {
+    bits[index++] = kLeadingSync[i];
+  }
+  for (int i = LatencyMarker::kTimestampBits - 1; i >= 0; i--) {
+    bits[index++] = (timestamp_us >> i) & 1;
+  }
+  uint8_t crc = Crc8(timestamp_us);
+  for (int i = kCrcBits - 1; i >= 0; i--) {
+    bits[index++] = (crc >> i) & 1;
+  }
+  for (int i = 0; i < kSyncBits; i++) {
+    bits[index++] = kTrailingSync[i];
+  }
+}
+
+// mean of the block centre, the edges bleed in lossy codecs
+int BlockLevel(const uint8_t* y_plane, int width, int bit) {
+  constexpr int kMargin = LatencyMarker::kBlockSize / 4;
+  constexpr int kInner = LatencyMarker::kBlockSize - kMargin * 2;
+  int x0 = (bit % LatencyMarker::kColumns) * LatencyMarker::kBlockSize +
+           kMargin;
+  int y0 = (bit / LatencyMarker::kColumns) * LatencyMarker::kBlockSize +
+           kMargin;
+  int sum = 0;
+  for (int y = y0; y < y0 + kInner; y++) {
+    const uint8_t* row = y_plane + (size_t)y * width + x0;
+    for (int x = 0; x < kInner; x++) {
+      sum += row[x];
+    }
+  }
+  return sum / (kInner * kInner);
+}
+
+}  // namespace
+
+bool LatencyMarker::Stamp(uint8_t* nv12, int width, int height,
+                          uint64_t timestamp_us) {
+  if (!nv12 || width < kWidth || height < kHeight) {
+    return false;
+  }
+
+  bool bits[kBits];
+  EncodeBits(timestamp_us & ((1ULL << kTimestampBits) - 1), bits);
+  for (int bit = 0; bit < kBits; bit++) {
+    int x0 = (bit % kColumns) * kBlockSize;
+    int y0 = (bit / kColumns) * kBlockSize;
+    for (int y = y0; y < y0 + kBlockSize; y++) {
+      memset(nv12 + (size_t)y * width + x0, bits[bit] ? kWhite : kBlack,
+             kBlockSize);
+    }
+  }
+
+  // neutral chroma so the blocks stay grey levels
+  uint8_t* uv_plane = nv12 + (size_t)width * height;
+  for (int y = 0; y < kHeight / 2; y++) {
+    memset(uv_plane + (size_t)y * width, 128, kWidth);
+  }
+  return true;
+}
+
+bool LatencyMarker::Detect(const uint8_t* nv12, int width, int height,
+                           uint64_t now_us, uint64_t* timestamp_us) {
+  if (!nv12 || !timestamp_us || width < kWidth || height < kHeight) {
+    return false;
+  }
+
+  int levels[kBits];
+  for (int bit = 0; bit < kBits; bit++) {
+    levels[bit] = BlockLevel(nv12, width, bit);
+  }
+
+  // the sync blocks calibrate black and white for this frame
+  int white = 0;
+  int black = 0;
+  for (int i = 0; i < kSyncBits; i++) {
+    int leading = levels[i];
+    int trailing = levels[kBits - kSyncBits + i];
+    white += (kLeadingSync[i] ? leading : 0) + (kTrailingSync[i] ? trailing : 0);
+    black += (kLeadingSync[i] ? 0 : leading) + (kTrailingSync[i] ? 0 : trailing);
+  }
+  white /= kSyncBits;
+  black /= kSyncBits;
+  if (white - black < kMinContrast) {
+    return false;
+  }
+  int threshold = (white + black) / 2;
+
+  bool bits[kBits];
+  for (int bit = 0; bit < kBits; bit++) {
+    bits[bit] = levels[bit] > threshold;
+  }
+  for (int i = 0; i < kSyncBits; i++) {
+    if (bits[i] != kLeadingSync[i] ||
+        bits[kBits - kSyncBits + i] != kTrailingSync[i]) {
+      return false;
+    }
+  }
+
+  uint64_t value = 0;
+  int index = kSyncBits;
+  for (int i = 0; i < kTimestampBits; i++) {
+    value = (value << 1) | (bits[index++] ? 1 : 0);
+  }
+  uint8_t crc = 0;
+  for (int i = 0; i < kCrcBits; i++) {
+    crc = (uint8_t)((crc << 1) | (bits[index++] ? 1 : 0));
+  }
+  if (crc != Crc8(value)) {
+    return false;
+  }
+
+  // pick the wrap of the low bits closest to now
+  const uint64_t span = 1ULL << kTimestampBits;
+  uint64_t timestamp = (now_us & ~(span - 1)) | value;
+  if (timestamp > now_us + span / 2 && timestamp >= span) {
+    timestamp -= span;
+  } else if (now_us > timestamp + span / 2) {
+    timestamp += span;
+  }
+  *timestamp_us = timestamp;
+  return true;
+}
+
+void LatencyWindow::Add(uint64_t latency_us) {
+  if (samples_.size() < kMaxSamples) {
+    samples_.push_back(latency_us);
+    return;
+  }
+  samples_[next_] = latency_us;
+  next_ = (next_ + 1) % kMaxSamples;
+}
+
+LatencyWindow::Percentiles LatencyWindow::Get() const {
+  Percentiles percentiles;
+  if (samples_.empty()) {
+    return percentiles;
+  }
+
+  std::vector<uint64_t> sorted = samples_;
+  std::sort(sorted.begin(), sorted.end());
+  auto at = [&sorted](double q) {
+    return sorted[std::min(sorted.size() - 1,
+                           (size_t)(q * (sorted.size() - 1) + 0.5))];
+  };
+  percentiles.count = sorted.size();
+  percentiles.p50_us = at(0.50);
+  percentiles.p95_us = at(0.95);
+  percentiles.p99_us = at(0.99);
+  return percentiles;
+}
+
+void LatencyWindow::Reset() {
+  samples_.clear();
+  next_ = 0;
+}
+}  // namespace crossdesk
\ No newline at end of file
@@ -0,0 +1,60 @@
+/*
+ * @Author: DI JUNKUN
+ * @Date: 2026-10-19
+ * Copyright (c) 2026 by DI JUNKUN, All Rights Reserved.
+ */
+
+#ifndef _LATENCY_MARKER_H_
+#define _LATENCY_MARKER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace crossdesk {
+
+// Glass to glass diagnostics. The host paints the capture time into the
+// top left corner of the luma plane as a grid of black and white blocks,
+// large enough to survive the encoder, and the viewer reads it back from
+// the decoded frame. Bits are framed by a sync pattern and a crc8.
+class LatencyMarker {
+ public:
+  static constexpr int kBlockSize = 16;
+  static constexpr int kColumns = 16;
+  static constexpr int kRows = 4;
+  static constexpr int kWidth = kBlockSize * kColumns;
+  static constexpr int kHeight = kBlockSize * kRows;
+  // low bits of the GetSystemTimeMicros clock, wraps after ~8.9 years
+  static constexpr int kTimestampBits = 48;
+
+  // nv12 with the luma stride equal to the width, false when too small
+  static bool Stamp(uint8_t* nv12, int width, int height,
+                    uint64_t timestamp_us);
+  // now_us restores the bits above kTimestampBits
+  static bool Detect(const uint8_t* nv12, int width, int height,
+                     uint64_t now_us, uint64_t* timestamp_us);
+};
+
+// Percentiles over the most recent samples.
+class LatencyWindow {
+ public:
+  struct Percentiles {
+    size_t count = 0;
+    uint64_t p50_us = 0;
+    uint64_t p95_us = 0;
+    uint64_t p99_us = 0;
+  };
+
+  static constexpr size_t kMaxSamples = 512;
+
+ public:
+  void Add(uint64_t latency_us);
+  Percentiles Get() const;
+  void Reset();
+
+ private:
+  std::vector<uint64_t> samples_;
+  size_t next_ = 0;
+};
+}  // namespace crossdesk
+#endif
\ No newline at end of file
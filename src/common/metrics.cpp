@@ -0,0 +1,186 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace crossdesk {
+
+namespace {
+
+// position of the highest set bit, v must not be 0
+int HighestBit(uint64_t v) {
+  int bit = 0;
+  if (v >> 32) {
+    v >>= 32;
+    bit += 32;
+  }
+  if (v >> 16) {
+    v >>= 16;
+    bit += 16;
+  }
+  if (v >> 8) {
+    v >>= 8;
+    bit += 8;
+  }
+  if (v >> 4) {
+    v >>= 4;
+    bit += 4;
+  }
+  if (v >> 2) {
+    v >>= 2;
+    bit += 2;
+  }
+  if (v >> 1) {
+    bit += 1;
+  }
+  return bit;
+}
+
+}  // namespace
+
+int MetricHistogram::BucketIndex(uint64_t value) {
+  if (value < (uint64_t)kSubBuckets) {
+    return (int)value;
+  }
+  int bit = HighestBit(value);
+  if (bit >= kMaxBits) {
+    return kBuckets - 1;
+  }
+  int sub = (int)(value >> (bit - kSubBucketBits)) & (kSubBuckets - 1);
+  return kSubBuckets * (bit - kSubBucketBits + 1) + sub;
+}
+
+uint64_t MetricHistogram::BucketValue(int index) {
+  if (index < kSubBuckets) {
+    return (uint64_t)index;
+  }
+  int bit = index / kSubBuckets + kSubBucketBits - 1;
+  int sub = index % kSubBuckets;
+  int shift = bit - kSubBucketBits;
+  uint64_t low = (uint64_t)(kSubBuckets + sub) << shift;
+  return low + ((1ULL << shift) >> 1);
+}
+
+MetricHistogram::Summary MetricHistogram::Summarize() const {
+  Summary summary;
+  std::vector<uint64_t> counts(kBuckets);
+  uint64_t total = 0;
+  for (int i = 0; i < kBuckets; i++) {
+    counts[i] = counts_[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+  // sum and max may run slightly ahead of the buckets while recording
+  summary.count = total;
+  summary.sum = sum_.load(std::memory_order_relaxed);
+  summary.max = max_.load(std::memory_order_relaxed);
+  if (total == 0) {
+    return summary;
+  }
+
+  uint64_t targets[3] = {(uint64_t)(total * 0.50), (uint64_t)(total * 0.95),
+                         (uint64_t)(total * 0.99)};
+  uint64_t* results[3] = {&summary.p50, &summary.p95, &summary.p99};
+  uint64_t seen = 0;
+  int next = 0;
+  for (int i = 0; i < kBuckets && next < 3; i++) {
+    seen += counts[i];
+    while (next < 3 && seen > targets[next]) {
+      *results[next] = std::min(BucketValue(i), summary.max);
+      next++;
+    }
+  }
+  return summary;
+}
+
+MetricsRegistry& MetricsRegistry::Global() {
+  static MetricsRegistry registry;
+  return registry;
+}
+
+MetricCounter* MetricsRegistry::Counter(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = counters_.find(name);
+  if (it != counters_.end()) {
+    return it->second;
+  }
+  counter_storage_.emplace_back();
+  counters_[name] = &counter_storage_.back();
+  return &counter_storage_.back();
+}
+
+MetricGauge* MetricsRegistry::Gauge(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = gauges_.find(name);
+  if (it != gauges_.end()) {
+    return it->second;
+  }
+  gauge_storage_.emplace_back();
+  gauges_[name] = &gauge_storage_.back();
+  return &gauge_storage_.back();
+}
+
+MetricHistogram* MetricsRegistry::Histogram(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = histograms_.find(name);
+  if (it != histograms_.end()) {
+    return it->second;
+  }
+  histogram_storage_.emplace_back();
+  histograms_[name] = &histogram_storage_.back();
+  return &histogram_storage_.back();
+}
+
+std::vector<MetricsRegistry::Entry> MetricsRegistry::Collect() {
+  std::vector<Entry> entries;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries.reserve(counters_.size() + gauges_.size() + histograms_.size());
+    for (const auto& [name, counter] : counters_) {
+      Entry entry;
+      entry.name = name;
+      entry.type = Type::COUNTER;
+      entry.value = (int64_t)counter->Value();
+      entries.push_back(entry);
+    }
+    for (const auto& [name, gauge] : gauges_) {
+      Entry entry;
+      entry.name = name;
+      entry.type = Type::GAUGE;
+      entry.value = gauge->Value();
+      entries.push_back(entry);
+    }
+    for (const auto& [name, histogram] : histograms_) {
+      Entry entry;
+      entry.name = name;
+      entry.type = Type::HISTOGRAM;
+      entry.summary = histogram->Summarize();
+      entries.push_back(entry);
+    }
+  }
+
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) { return a.name < b.name; });
+  return entries;
+}
+
+std::string MetricsRegistry::Dump() {
+  std::string text;
+  char line[256];
+  for (const Entry& entry : Collect()) {
+    if (entry.type == Type::HISTOGRAM) {
+      const MetricHistogram::Summary& s = entry.summary;
+      snprintf(line, sizeof(line),
+               "%s count=%llu mean=%llu p50=%llu p95=%llu p99=%llu max=%llu\n",
+               entry.name.c_str(), (unsigned long long)s.count,
+               (unsigned long long)(s.count ? s.sum / s.count : 0),
+               (unsigned long long)s.p50, (unsigned long long)s.p95,
+               (unsigned long long)s.p99, (unsigned long long)s.max);
+    } else {
+      snprintf(line, sizeof(line), "%s %lld\n", entry.name.c_str(),
+               (long long)entry.value);
+    }
+    text += line;
+  }
+  return text;
+}
+}  // namespace crossdesk
\ No newline at end of file
@@ -0,0 +1,140 @@
+/*
+ * @Author: DI JUNKUN
+ * @Date: 2026-10-19
+ * Copyright (c) 2026 by DI JUNKUN, All Rights Reserved.
+ */
+
+#ifndef _METRICS_H_
+#define _METRICS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace crossdesk {
+
+// Recording is a relaxed atomic add, callers look a metric up once and keep
+// the pointer. Registration and reads take the registry lock.
+class MetricCounter {
+ public:
+  void Add(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+  uint64_t Value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint64_t> value_{0};
+};
+
+class MetricGauge {
+ public:
+  void Set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+  void Add(int64_t n) { value_.fetch_add(n, std::memory_order_relaxed); }
+  int64_t Value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<int64_t> value_{0};
+};
+
+// Log linear buckets in the style of HdrHistogram, 32 sub buckets per power
+// of two keep every recorded value within about 3 percent.
+class MetricHistogram {
+ public:
+  struct Summary {
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    uint64_t p50 = 0;
+    uint64_t p95 = 0;
+    uint64_t p99 = 0;
+  };
+
+  static constexpr int kSubBucketBits = 5;
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  // larger values land in the last bucket
+  static constexpr int kMaxBits = 40;
+  static constexpr int kBuckets =
+      kSubBuckets * (kMaxBits - kSubBucketBits + 1);
+
+ public:
+  void Record(uint64_t value) {
+    counts_[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (value > max && !max_.compare_exchange_weak(
+                              max, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  Summary Summarize() const;
+
+  static int BucketIndex(uint64_t value);
+  // midpoint of the values a bucket holds
+  static uint64_t BucketValue(int index);
+
+ private:
+  std::atomic<uint64_t> counts_[kBuckets] = {};
+  std::atomic<uint64_t> sum_{0};
+  std::atomic<uint64_t> max_{0};
+};
+
+class MetricsRegistry {
+ public:
+  enum class Type { COUNTER, GAUGE, HISTOGRAM };
+
+  struct Entry {
+    std::string name;
+    Type type = Type::COUNTER;
+    // counter or gauge value
+    int64_t value = 0;
+    MetricHistogram::Summary summary;
+  };
+
+  // process wide, capture, sender, network and ui threads all record here
+  static MetricsRegistry& Global();
+
+  static uint64_t NowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+ public:
+  // the same name always returns the same metric
+  MetricCounter* Counter(const std::string& name);
+  MetricGauge* Gauge(const std::string& name);
+  MetricHistogram* Histogram(const std::string& name);
+
+  // sorted by name
+  std::vector<Entry> Collect();
+  // one line per metric, histograms in microseconds
+  std::string Dump();
+
+ private:
+  std::mutex mutex_;
+  std::deque<MetricCounter> counter_storage_;
+  std::deque<MetricGauge> gauge_storage_;
+  std::deque<MetricHistogram> histogram_storage_;
+  std::unordered_map<std::string, MetricCounter*> counters_;
+  std::unordered_map<std::string, MetricGauge*> gauges_;
+  std::unordered_map<std::string, MetricHistogram*> histograms_;
+};
+
+// records the lifetime of the scope in microseconds
+class ScopedMetricTimer {
+ public:
+  explicit ScopedMetricTimer(MetricHistogram* histogram)
+      : histogram_(histogram), start_us_(MetricsRegistry::NowMicros()) {}
+  ~ScopedMetricTimer() {
+    histogram_->Record(MetricsRegistry::NowMicros() - start_us_);
+  }
+
+ private:
+  MetricHistogram* histogram_;
+  uint64_t start_us_;
+};
+}  // namespace crossdesk
+#endif
\ No newline at end of file
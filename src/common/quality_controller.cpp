@@ -0,0 +1,156 @@
+#include "quality_controller.h"
+
+#include <algorithm>
+
+namespace crossdesk {
+
+QualityController::QualityController() { Reset(60); }
+
+QualityController::~QualityController() { CloseTrace(); }
+
+void QualityController::Reset(int max_fps) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  max_fps = std::max(max_fps, 15);
+
+  // cheapest lever first: resolution, then frame rate
+  ladder_ = {{max_fps, 1.0f},
+             {max_fps, 0.75f},
+             {std::min(max_fps, 30), 0.75f},
+             {std::min(max_fps, 20), 0.5f},
+             {15, 0.5f}};
+
+  level_ = 0;
+  congested_samples_ = 0;
+  clean_since_ms_ = 0;
+  last_change_ms_ = 0;
+  last_upgrade_ms_ = 0;
+  upgrade_hold_ms_ = kUpgradeHoldMs;
+  last_queue_dropped_ = 0;
+  bitrate_avg_ = 0;
+}
+
+int QualityController::OpenTrace(const std::string& path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (trace_file_) {
+    fclose(trace_file_);
+  }
+  trace_file_ = fopen(path.c_str(), "a");
+  return trace_file_ ? 0 : -1;
+}
+
+void QualityController::CloseTrace() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (trace_file_) {
+    fclose(trace_file_);
+    trace_file_ = nullptr;
+  }
+}
+
+QualityController::Level QualityController::Current() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return ladder_[level_];
+}
+
+int QualityController::CurrentLevel() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return level_;
+}
+
+QualityController::Decision QualityController::Update(const Sample& sample,
+                                                      uint64_t now_ms) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Decision decision;
+
+  bool queue_dropped = sample.queue_dropped > last_queue_dropped_;
+  last_queue_dropped_ = sample.queue_dropped;
+  bool queue_full = sample.queue_max_depth > 0 &&
+                    sample.queue_depth >= sample.queue_max_depth;
+  // a collapsing send rate with some loss means the link shrank
+  bool bitrate_collapsed = bitrate_avg_ > 0 &&
+                           sample.bitrate < bitrate_avg_ * 0.5 &&
+                           sample.loss_rate >= kCleanLossRate;
+  bitrate_avg_ = bitrate_avg_ == 0
+                     ? (double)sample.bitrate
+                     : bitrate_avg_ * 0.8 + (double)sample.bitrate * 0.2;
+
+  bool congested = sample.loss_rate >= kCongestedLossRate || queue_dropped ||
+                   queue_full || bitrate_collapsed;
+  bool clean = !congested && sample.loss_rate < kCleanLossRate;
+
+  if (congested) {
+    congested_samples_++;
+    clean_since_ms_ = 0;
+    if (sample.loss_rate >= kCongestedLossRate) {
+      decision.reason = "loss";
+    } else if (queue_dropped || queue_full) {
+      decision.reason = "send_queue";
+    } else {
+      decision.reason = "bitrate";
+    }
+
+    if (congested_samples_ >= kDowngradeSamples &&
+        level_ + 1 < (int)ladder_.size() &&
+        now_ms - last_change_ms_ >= kMinDowngradeIntervalMs) {
+      if (last_upgrade_ms_ != 0 && now_ms - last_upgrade_ms_ < kProbeWindowMs) {
+        upgrade_hold_ms_ = std::min(upgrade_hold_ms_ * 2, kMaxUpgradeHoldMs);
+      }
+      level_++;
+      congested_samples_ = 0;
+      last_change_ms_ = now_ms;
+      last_upgrade_ms_ = 0;
+      decision.changed = true;
+    }
+  } else {
+    congested_samples_ = 0;
+    if (!clean) {
+      clean_since_ms_ = 0;
+      decision.reason = "hold";
+    } else {
+      if (clean_since_ms_ == 0) {
+        clean_since_ms_ = now_ms;
+      }
+      decision.reason = "clean";
+      if (level_ > 0 && now_ms - clean_since_ms_ >= upgrade_hold_ms_) {
+        level_--;
+        clean_since_ms_ = now_ms;
+        last_change_ms_ = now_ms;
+        last_upgrade_ms_ = now_ms;
+        decision.changed = true;
+      }
+    }
+  }
+
+  // a probe that survived its window resets the backoff
+  if (last_upgrade_ms_ != 0 && !congested &&
+      now_ms - last_upgrade_ms_ >= kProbeWindowMs) {
+    upgrade_hold_ms_ = kUpgradeHoldMs;
+    last_upgrade_ms_ = 0;
+  }
+
+  decision.level = level_;
+  decision.settings = ladder_[level_];
+  Trace(sample, now_ms, congested, decision);
+  return decision;
+}
+
+void QualityController::Trace(const Sample& sample, uint64_t now_ms,
+                              bool congested, const Decision& decision) {
+  if (!trace_file_) {
+    return;
+  }
+
+  // one json object per sample, inputs next to the resulting state
+  fprintf(trace_file_,
+          "{\"t\":%llu,\"loss\":%.4f,\"bitrate\":%llu,\"bitrate_avg\":%.0f,"
+          "\"queue_depth\":%zu,\"queue_dropped\":%llu,\"congested\":%s,"
+          "\"reason\":\"%s\",\"level\":%d,\"changed\":%s,\"fps\":%d,"
+          "\"scale\":%.2f,\"upgrade_hold_ms\":%llu}\n",
+          (unsigned long long)now_ms, sample.loss_rate,
+          (unsigned long long)sample.bitrate, bitrate_avg_, sample.queue_depth,
+          (unsigned long long)sample.queue_dropped,
+          congested ? "true" : "false", decision.reason, decision.level,
+          decision.changed ? "true" : "false", decision.settings.fps,
+          decision.settings.scale, (unsigned long long)upgrade_hold_ms_);
+  fflush(trace_file_);
+}
+}  // namespace crossdesk
\ No newline at end of file
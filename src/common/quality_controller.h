@@ -0,0 +1,87 @@
+/*
+ * @Author: DI JUNKUN
+ * @Date: 2026-10-19
+ * Copyright (c) 2026 by DI JUNKUN, All Rights Reserved.
+ */
+
+#ifndef _QUALITY_CONTROLLER_H_
+#define _QUALITY_CONTROLLER_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace crossdesk {
+
+// Walks a ladder of capture settings from one viewer's stats and the send
+// queue. Steps down after sustained congestion, steps up only after a
+// long clean period that grows every time an upgrade fails.
+class QualityController {
+ public:
+  // minirtc reads the encoder quality only when the peer is created, so
+  // the ladder only moves what can change at runtime
+  struct Level {
+    int fps;
+    float scale;
+  };
+
+  struct Sample {
+    float loss_rate = 0;  // 0..1, as the viewer reports it for the video
+    uint64_t bitrate = 0;
+    size_t queue_depth = 0;
+    size_t queue_max_depth = 0;
+    uint64_t queue_dropped = 0;  // running total
+  };
+
+  struct Decision {
+    int level = 0;
+    Level settings{};
+    bool changed = false;
+    const char* reason = "";
+  };
+
+ public:
+  static constexpr float kCongestedLossRate = 0.05f;
+  static constexpr float kCleanLossRate = 0.01f;
+  // consecutive congested samples before stepping down
+  static constexpr int kDowngradeSamples = 2;
+  static constexpr uint64_t kMinDowngradeIntervalMs = 2000;
+  static constexpr uint64_t kUpgradeHoldMs = 10000;
+  static constexpr uint64_t kMaxUpgradeHoldMs = 60000;
+  // congestion this soon after an upgrade counts as a failed probe
+  static constexpr uint64_t kProbeWindowMs = 5000;
+
+  QualityController();
+  ~QualityController();
+
+ public:
+  // max_fps comes from the user settings, the ladder never goes above it
+  void Reset(int max_fps);
+  int OpenTrace(const std::string& path);
+  void CloseTrace();
+
+  Decision Update(const Sample& sample, uint64_t now_ms);
+  Level Current();
+  int CurrentLevel();
+
+ private:
+  void Trace(const Sample& sample, uint64_t now_ms, bool congested,
+             const Decision& decision);
+
+ private:
+  std::mutex mutex_;
+  std::vector<Level> ladder_;
+  int level_ = 0;
+  int congested_samples_ = 0;
+  uint64_t clean_since_ms_ = 0;
+  uint64_t last_change_ms_ = 0;
+  uint64_t last_upgrade_ms_ = 0;
+  uint64_t upgrade_hold_ms_ = kUpgradeHoldMs;
+  uint64_t last_queue_dropped_ = 0;
+  double bitrate_avg_ = 0;
+  FILE* trace_file_ = nullptr;
+};
+}  // namespace crossdesk
+#endif
\ No newline at end of file
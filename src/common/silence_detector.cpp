@@ -0,0 +1,59 @@
+#include "silence_detector.h"
+
+#include <cmath>
+
+namespace crossdesk {
+
+SilenceDetector::SilenceDetector(float on_threshold_db, float off_threshold_db,
+                                 int hangover_ms)
+    : on_threshold_db_(on_threshold_db),
+      off_threshold_db_(off_threshold_db),
+      hangover_us_(hangover_ms * 1000) {}
+
+SilenceDetector::~SilenceDetector() {}
+
+bool SilenceDetector::Process(const int16_t* samples, size_t count,
+                              int frame_duration_us) {
+  frames_++;
+
+  double energy = 0;
+  for (size_t i = 0; i < count; i++) {
+    energy += (double)samples[i] * samples[i];
+  }
+  double rms = count > 0 ? std::sqrt(energy / count) : 0;
+  level_db_ = rms > 0 ? (float)(20.0 * std::log10(rms / 32768.0)) : -96.0f;
+
+  if (level_db_ >= on_threshold_db_) {
+    silent_ = false;
+    below_us_ = 0;
+  } else if (!silent_) {
+    if (level_db_ < off_threshold_db_) {
+      below_us_ += frame_duration_us;
+    } else {
+      below_us_ = 0;
+    }
+
+    if (below_us_ >= hangover_us_) {
+      silent_ = true;
+    }
+  }
+
+  if (silent_) {
+    silent_frames_++;
+  }
+  return !silent_;
+}
+
+void SilenceDetector::Reset() {
+  silent_ = true;
+  below_us_ = 0;
+  level_db_ = -96.0f;
+}
+
+SilenceDetector::Stats SilenceDetector::GetStats() const {
+  Stats stats;
+  stats.frames = frames_;
+  stats.silent_frames = silent_frames_;
+  return stats;
+}
+}  // namespace crossdesk
\ No newline at end of file
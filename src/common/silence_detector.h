@@ -0,0 +1,55 @@
+/*
+ * @Author: DI JUNKUN
+ * @Date: 2026-10-19
+ * Copyright (c) 2026 by DI JUNKUN, All Rights Reserved.
+ */
+
+#ifndef _SILENCE_DETECTOR_H_
+#define _SILENCE_DETECTOR_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace crossdesk {
+
+// Energy based voice activity detection for captured pcm s16. Sound starts
+// as soon as a frame crosses the on threshold, silence only after frames
+// stayed under the lower off threshold for the whole hangover.
+class SilenceDetector {
+ public:
+  struct Stats {
+    uint64_t frames = 0;
+    uint64_t silent_frames = 0;
+  };
+
+ public:
+  explicit SilenceDetector(float on_threshold_db = -50.0f,
+                           float off_threshold_db = -56.0f,
+                           int hangover_ms = 300);
+  ~SilenceDetector();
+
+ public:
+  // returns true while the frame should be sent
+  bool Process(const int16_t* samples, size_t count, int frame_duration_us);
+  void Reset();
+
+  bool IsSilent() const { return silent_; }
+  // level of the last frame in dbfs
+  float LevelDb() const { return level_db_; }
+  Stats GetStats() const;
+
+ private:
+  float on_threshold_db_;
+  float off_threshold_db_;
+  int hangover_us_;
+
+  bool silent_ = true;
+  int below_us_ = 0;
+  float level_db_ = -96.0f;
+
+  std::atomic<uint64_t> frames_{0};
+  std::atomic<uint64_t> silent_frames_{0};
+};
+}  // namespace crossdesk
+#endif
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include "trace_recorder.h"
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+namespace crossdesk {
+
+namespace {
+
+uint64_t NowMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+TraceRecorder& TraceRecorder::Global() {
+  // never destroyed, threads may still release rings during exit
+  static TraceRecorder* recorder = new TraceRecorder();
+  return *recorder;
+}
+
+void TraceRecorder::SetEnabled(bool enabled) {
+  enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+void TraceRecorder::Begin(const char* name) { Record(name, 'B'); }
+
+void TraceRecorder::End(const char* name) { Record(name, 'E'); }
+
+void TraceRecorder::SetThreadName(const char* name) {
+  CurrentRing()->thread_name.store(name, std::memory_order_relaxed);
+}
+
+TraceRecorder::ThreadRing* TraceRecorder::CurrentRing() {
+  // hands the ring back when the thread exits
+  struct RingOwner {
+    TraceRecorder* recorder = nullptr;
+    ThreadRing* ring = nullptr;
+    ~RingOwner() {
+      if (ring) {
+        recorder->ReleaseRing(ring);
+      }
+    }
+  };
+  thread_local RingOwner owner;
+
+  if (!owner.ring) {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    ThreadRing* ring = nullptr;
+    if (!free_rings_.empty()) {
+      // the dead thread's events stay in dumps until this point
+      ring = free_rings_.back();
+      free_rings_.pop_back();
+      ring->thread_name.store(nullptr, std::memory_order_relaxed);
+      ring->head.store(0, std::memory_order_relaxed);
+    } else {
+      rings_.push_back(std::make_unique<ThreadRing>());
+      ring = rings_.back().get();
+    }
+    ring->tid = next_tid_++;
+    owner.recorder = this;
+    owner.ring = ring;
+  }
+  return owner.ring;
+}
+
+void TraceRecorder::ReleaseRing(ThreadRing* ring) {
+  std::lock_guard<std::mutex> lock(rings_mutex_);
+  free_rings_.push_back(ring);
+}
+
+void TraceRecorder::Record(const char* name, char phase) {
+  if (!IsEnabled()) {
+    return;
+  }
+
+  ThreadRing* ring = CurrentRing();
+  // named threads that never record cost no ring
+  if (ring->events.empty()) {
+    ring->events.resize(kRingEvents);
+  }
+  uint32_t seq = ring->seq.load(std::memory_order_relaxed);
+  ring->seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  uint64_t head = ring->head.load(std::memory_order_relaxed);
+  Event& event = ring->events[head % kRingEvents];
+  event.name = name;
+  event.ts_us = NowMicros();
+  event.phase = phase;
+  ring->head.store(head + 1, std::memory_order_relaxed);
+  ring->seq.store(seq + 2, std::memory_order_release);
+}
+
+int TraceRecorder::Dump(const std::string& path) {
+  bool was_enabled = enabled_.exchange(false);
+
+  FILE* file = fopen(path.c_str(), "w");
+  if (!file) {
+    enabled_ = was_enabled;
+    return -1;
+  }
+
+  fprintf(file, "{\"traceEvents\":[\n");
+  bool first = true;
+  std::vector<Event> events;
+  events.reserve(kRingEvents);
+  // also keeps rings from being recycled while they are read
+  std::lock_guard<std::mutex> lock(rings_mutex_);
+  for (const auto& ring : rings_) {
+    // a writer that passed the flag check before it was cleared can
+    // still be mid event, copy again until the sequence holds still
+    while (true) {
+      uint32_t seq = ring->seq.load(std::memory_order_acquire);
+      if (seq & 1) {
+        std::this_thread::yield();
+        continue;
+      }
+      events.clear();
+      uint64_t head = ring->head.load(std::memory_order_relaxed);
+      uint64_t begin = head > kRingEvents ? head - kRingEvents : 0;
+      for (uint64_t i = begin; i < head; i++) {
+        events.push_back(ring->events[i % kRingEvents]);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (ring->seq.load(std::memory_order_relaxed) == seq) {
+        break;
+      }
+    }
+
+    const char* thread_name =
+        ring->thread_name.load(std::memory_order_relaxed);
+    if (thread_name) {
+      fprintf(file,
+              "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+              "\"args\":{\"name\":\"%s\"}}",
+              first ? "" : ",\n", ring->tid, thread_name);
+      first = false;
+    }
+
+    for (const Event& event : events) {
+      fprintf(file,
+              "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu,\"pid\":1,"
+              "\"tid\":%u}",
+              first ? "" : ",\n", event.name, event.phase,
+              (unsigned long long)event.ts_us, ring->tid);
+      first = false;
+    }
+  }
+  fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+  fclose(file);
+
+  enabled_ = was_enabled;
+  return 0;
+}
+}  // namespace crossdesk
\ No newline at end of file
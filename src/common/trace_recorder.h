@@ -0,0 +1,104 @@
+/*
+ * @Author: DI JUNKUN
+ * @Date: 2026-10-19
+ * Copyright (c) 2026 by DI JUNKUN, All Rights Reserved.
+ */
+
+#ifndef _TRACE_RECORDER_H_
+#define _TRACE_RECORDER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace crossdesk {
+
+// Begin and end events into per thread rings, written out in the chrome
+// trace format that chrome://tracing and Perfetto open. Recording is a
+// relaxed flag check when off and a few stores when on. Names must be
+// string literals, only the pointer is kept. A thread's ring goes back
+// to a free list when it exits and is reused by the next new thread.
+class TraceRecorder {
+ public:
+  static constexpr size_t kRingEvents = 1 << 14;
+
+  static TraceRecorder& Global();
+
+ public:
+  void SetEnabled(bool enabled);
+  bool IsEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  void Begin(const char* name);
+  void End(const char* name);
+  // labels the calling thread in the dump
+  void SetThreadName(const char* name);
+
+  // pauses recording while the rings are read, restores it afterwards.
+  // each ring is copied under its sequence so a racing writer is retried
+  int Dump(const std::string& path);
+
+ private:
+  struct Event {
+    const char* name = nullptr;
+    uint64_t ts_us = 0;
+    char phase = 0;
+  };
+
+  struct ThreadRing {
+    uint32_t tid = 0;
+    std::atomic<const char*> thread_name{nullptr};
+    // odd while the owner writes an event
+    std::atomic<uint32_t> seq{0};
+    std::atomic<uint64_t> head{0};
+    std::vector<Event> events;
+  };
+
+  ThreadRing* CurrentRing();
+  void ReleaseRing(ThreadRing* ring);
+  void Record(const char* name, char phase);
+
+ private:
+  std::atomic<bool> enabled_{false};
+  std::mutex rings_mutex_;
+  std::vector<std::unique_ptr<ThreadRing>> rings_;
+  std::vector<ThreadRing*> free_rings_;
+  uint32_t next_tid_ = 1;
+};
+
+class TraceScope {
+ public:
+  explicit TraceScope(const char* name)
+      : name_(TraceRecorder::Global().IsEnabled() ? name : nullptr) {
+    if (name_) {
+      TraceRecorder::Global().Begin(name_);
+    }
+  }
+  ~TraceScope() {
+    if (name_) {
+      TraceRecorder::Global().End(name_);
+    }
+  }
+
+ private:
+  const char* name_;
+};
+}  // namespace crossdesk
+
+// builds without CROSSDESK_TRACE keep no trace code in the hot paths
+#ifdef CROSSDESK_TRACE
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) \
+  ::crossdesk::TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_THREAD(name) \
+  ::crossdesk::TraceRecorder::Global().SetThreadName(name)
+#else
+#define TRACE_SCOPE(name)
+#define TRACE_THREAD(name)
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include "video_send_queue.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "trace_recorder.h"
+
+namespace crossdesk {
+
+static uint64_t NowMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+VideoSendQueue::VideoSendQueue(size_t max_depth)
+    : max_depth_(std::clamp(max_depth, kMinDepth, kMaxDepth)),
+      wait_us_metric_(
+          MetricsRegistry::Global().Histogram("video_queue_wait_us")),
+      depth_metric_(MetricsRegistry::Global().Gauge("video_queue_depth")),
+      dropped_metric_(
+          MetricsRegistry::Global().Counter("video_queue_dropped")) {}
+
+VideoSendQueue::~VideoSendQueue() { Stop(); }
+
+int VideoSendQueue::Start(send_cb cb) {
+  if (running_) {
+    return 0;
+  }
+
+  cb_ = cb;
+  running_ = true;
+  sender_thread_ = std::thread(&VideoSendQueue::SendLoop, this);
+  return 0;
+}
+
+int VideoSendQueue::Stop() {
+  if (!running_) {
+    return 0;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  cond_.notify_all();
+  if (sender_thread_.joinable()) {
+    sender_thread_.join();
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& [_, queue] : queues_) {
+    for (auto& frame : queue) {
+      free_frames_.push_back(std::move(frame));
+    }
+  }
+  queues_.clear();
+  order_.clear();
+  depth_ = 0;
+  return 0;
+}
+
+void VideoSendQueue::SetMaxDepth(size_t max_depth) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  max_depth_ = std::clamp(max_depth, kMinDepth, kMaxDepth);
+}
+
+std::unique_ptr<VideoSendQueue::Frame> VideoSendQueue::AcquireFrame() {
+  // frames are recycled, steady state capture does not allocate
+  if (free_frames_.empty()) {
+    return std::make_unique<Frame>();
+  }
+  std::unique_ptr<Frame> frame = std::move(free_frames_.back());
+  free_frames_.pop_back();
+  return frame;
+}
+
+void VideoSendQueue::Push(const uint8_t* data, size_t size, int width,
+                          int height, uint64_t captured_timestamp,
+                          const char* stream_name) {
+  if (!running_) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto& queue = queues_[stream_name];
+
+  std::unique_ptr<Frame> frame;
+  if (queue.size() >= max_depth_) {
+    // drop oldest, its buffer takes the new frame
+    frame = std::move(queue.front());
+    queue.pop_front();
+    auto it = std::find(order_.begin(), order_.end(), frame->stream_name);
+    if (it != order_.end()) {
+      order_.erase(it);
+    }
+    depth_--;
+    dropped_++;
+    dropped_metric_->Add();
+  } else {
+    frame = AcquireFrame();
+  }
+
+  frame->data.assign(data, data + size);
+  frame->width = width;
+  frame->height = height;
+  frame->captured_timestamp = captured_timestamp;
+  frame->enqueue_time_us = NowMicros();
+  frame->stream_name = stream_name;
+
+  queue.push_back(std::move(frame));
+  order_.push_back(stream_name);
+  depth_++;
+  enqueued_++;
+  depth_metric_->Set((int64_t)depth_);
+  lock.unlock();
+
+  cond_.notify_one();
+}
+
+void VideoSendQueue::SendLoop() {
+  TRACE_THREAD("video sender");
+  while (true) {
+    std::unique_ptr<Frame> frame;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this] { return !running_ || !order_.empty(); });
+      if (!running_) {
+        break;
+      }
+
+      auto& queue = queues_[order_.front()];
+      order_.pop_front();
+      frame = std::move(queue.front());
+      queue.pop_front();
+      depth_--;
+      depth_metric_->Set((int64_t)depth_);
+    }
+
+    uint64_t latency_us = NowMicros() - frame->enqueue_time_us;
+    wait_us_metric_->Record(latency_us);
+    if (cb_) {
+      cb_(*frame);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    sent_++;
+    last_latency_us_ = latency_us;
+    avg_latency_us_ = avg_latency_us_ == 0
+                          ? latency_us
+                          : (avg_latency_us_ * 15 + latency_us) / 16;
+    max_latency_us_ = std::max(max_latency_us_, latency_us);
+    free_frames_.push_back(std::move(frame));
+  }
+}
+
+VideoSendQueue::Stats VideoSendQueue::GetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats stats;
+  stats.depth = depth_;
+  stats.max_depth = max_depth_;
+  stats.enqueued = enqueued_;
+  stats.sent = sent_;
+  stats.dropped = dropped_;
+  stats.last_latency_us = last_latency_us_;
+  stats.avg_latency_us = avg_latency_us_;
+  stats.max_latency_us = max_latency_us_;
+  return stats;
+}
+}  // namespace crossdesk
\ No newline at end of file
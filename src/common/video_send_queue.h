@@ -0,0 +1,103 @@
+/*
+ * @Author: DI JUNKUN
+ * @Date: 2026-10-19
+ * Copyright (c) 2026 by DI JUNKUN, All Rights Reserved.
+ */
+
+#ifndef _VIDEO_SEND_QUEUE_H_
+#define _VIDEO_SEND_QUEUE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "metrics.h"
+
+namespace crossdesk {
+
+// Hands captured frames to a sender thread so a slow encoder or network
+// never blocks capture. Each stream keeps at most max_depth frames, the
+// oldest one is dropped when a new frame does not fit.
+class VideoSendQueue {
+ public:
+  struct Frame {
+    std::vector<uint8_t> data;
+    int width = 0;
+    int height = 0;
+    uint64_t captured_timestamp = 0;
+    uint64_t enqueue_time_us = 0;
+    std::string stream_name;
+  };
+
+  struct Stats {
+    size_t depth = 0;
+    size_t max_depth = 0;
+    uint64_t enqueued = 0;
+    uint64_t sent = 0;
+    uint64_t dropped = 0;
+    // enqueue to send, the last one and a running average
+    uint64_t last_latency_us = 0;
+    uint64_t avg_latency_us = 0;
+    uint64_t max_latency_us = 0;
+  };
+
+  // the frame belongs to the sender until it returns, it may draw into it
+  typedef std::function<int(Frame&)> send_cb;
+
+ public:
+  static constexpr size_t kMinDepth = 1;
+  static constexpr size_t kMaxDepth = 3;
+
+  explicit VideoSendQueue(size_t max_depth = 2);
+  ~VideoSendQueue();
+
+ public:
+  int Start(send_cb cb);
+  int Stop();
+
+  // copies the frame, never blocks on the sender
+  void Push(const uint8_t* data, size_t size, int width, int height,
+            uint64_t captured_timestamp, const char* stream_name);
+
+  void SetMaxDepth(size_t max_depth);
+  Stats GetStats();
+
+ private:
+  void SendLoop();
+  std::unique_ptr<Frame> AcquireFrame();
+
+ private:
+  size_t max_depth_;
+  send_cb cb_ = nullptr;
+  std::thread sender_thread_;
+  std::atomic<bool> running_{false};
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  // per stream fifo, sent in arrival order across streams
+  std::unordered_map<std::string, std::deque<std::unique_ptr<Frame>>> queues_;
+  std::deque<std::string> order_;
+  size_t depth_ = 0;
+  std::vector<std::unique_ptr<Frame>> free_frames_;
+
+  uint64_t enqueued_ = 0;
+  uint64_t sent_ = 0;
+  uint64_t dropped_ = 0;
+  uint64_t last_latency_us_ = 0;
+  uint64_t avg_latency_us_ = 0;
+  uint64_t max_latency_us_ = 0;
+
+  MetricHistogram* wait_us_metric_;
+  MetricGauge* depth_metric_;
+  MetricCounter* dropped_metric_;
+};
+}  // namespace crossdesk
+#endif
\ No newline at end of file
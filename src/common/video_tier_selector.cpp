@@ -0,0 +1,122 @@
+#include "video_tier_selector.h"
+
+#include <algorithm>
+
+namespace crossdesk {
+
+// width x height of each tier box, FULL is the capture size
+static const int kTierSizes[][2] = {{960, 540}, {1280, 720}, {1920, 1080}};
+
+const char* VideoTierSelector::TierName(Tier tier) {
+  switch (tier) {
+    case Tier::P540:
+      return "540p";
+    case Tier::P720:
+      return "720p";
+    case Tier::P1080:
+      return "1080p";
+    default:
+      return "full";
+  }
+}
+
+VideoTierSelector::Tier VideoTierSelector::TierForSize(int width, int height) {
+  if (width <= 0 || height <= 0) {
+    return Tier::FULL;
+  }
+
+  // portrait viewports are matched against rotated boxes
+  int long_side = std::max(width, height);
+  int short_side = std::min(width, height);
+  for (int i = 0; i <= (int)Tier::P1080; i++) {
+    if (long_side <= kTierSizes[i][0] && short_side <= kTierSizes[i][1]) {
+      return (Tier)i;
+    }
+  }
+  return Tier::FULL;
+}
+
+void VideoTierSelector::ScaledSize(Tier tier, int src_width, int src_height,
+                                   int* width, int* height) {
+  *width = src_width;
+  *height = src_height;
+  if (tier == Tier::FULL || src_width <= 0 || src_height <= 0) {
+    return;
+  }
+
+  int box_width = kTierSizes[(int)tier][0];
+  int box_height = kTierSizes[(int)tier][1];
+  if (src_height > src_width) {
+    std::swap(box_width, box_height);
+  }
+  if (src_width <= box_width && src_height <= box_height) {
+    return;
+  }
+
+  double scale = std::min((double)box_width / src_width,
+                          (double)box_height / src_height);
+  *width = std::max(2, (int)(src_width * scale) & ~1);
+  *height = std::max(2, (int)(src_height * scale) & ~1);
+}
+
+void VideoTierSelector::SetViewerSize(const std::string& viewer_id, int width,
+                                      int height) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  viewer_tiers_[viewer_id] = TierForSize(width, height);
+}
+
+void VideoTierSelector::RemoveViewer(const std::string& viewer_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  viewer_tiers_.erase(viewer_id);
+}
+
+void VideoTierSelector::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  viewer_tiers_.clear();
+  active_tier_ = Tier::FULL;
+  downgrade_since_ms_ = 0;
+}
+
+VideoTierSelector::Tier VideoTierSelector::RequestedTier() const {
+  if (viewer_tiers_.empty()) {
+    return Tier::FULL;
+  }
+
+  Tier tier = Tier::P540;
+  for (const auto& [_, viewer_tier] : viewer_tiers_) {
+    tier = std::max(tier, viewer_tier);
+  }
+  return tier;
+}
+
+VideoTierSelector::Tier VideoTierSelector::Select(uint64_t now_ms) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Tier requested = RequestedTier();
+  if (requested >= active_tier_) {
+    if (requested != active_tier_) {
+      active_tier_ = requested;
+      tier_changes_++;
+    }
+    downgrade_since_ms_ = 0;
+    return active_tier_;
+  }
+
+  if (downgrade_since_ms_ == 0) {
+    downgrade_since_ms_ = now_ms;
+  } else if (now_ms - downgrade_since_ms_ >= kDowngradeHoldMs) {
+    active_tier_ = requested;
+    downgrade_since_ms_ = 0;
+    tier_changes_++;
+  }
+  return active_tier_;
+}
+
+VideoTierSelector::Stats VideoTierSelector::GetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats stats;
+  stats.viewers = viewer_tiers_.size();
+  stats.tier = active_tier_;
+  stats.tier_changes = tier_changes_;
+  return stats;
+}
+}  // namespace crossdesk
\ No newline at end of file
@@ -0,0 +1,64 @@
+/*
+ * @Author: DI JUNKUN
+ * @Date: 2026-10-19
+ * Copyright (c) 2026 by DI JUNKUN, All Rights Reserved.
+ */
+
+#ifndef _VIDEO_TIER_SELECTOR_H_
+#define _VIDEO_TIER_SELECTOR_H_
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace crossdesk {
+
+// Picks the one resolution tier the host encodes for every viewer. The
+// transport sends a single rendition per video stream to all peers, so
+// this is not a per-viewer fan-out: the largest viewport any viewer asked
+// for decides, and smaller viewers get that tier too. Capture and
+// conversion happen once, the frame is scaled at most once to the tier.
+class VideoTierSelector {
+ public:
+  enum class Tier { P540 = 0, P720, P1080, FULL };
+
+  struct Stats {
+    size_t viewers = 0;
+    Tier tier = Tier::FULL;
+    uint64_t tier_changes = 0;
+  };
+
+ public:
+  // a lower tier has to be asked for this long before the host steps down,
+  // so resizing a window does not flap the encoder resolution
+  static constexpr uint64_t kDowngradeHoldMs = 2000;
+
+  static const char* TierName(Tier tier);
+  // the smallest tier that covers a width x height viewport
+  static Tier TierForSize(int width, int height);
+  // keeps the source aspect ratio, never upscales, dimensions stay even
+  static void ScaledSize(Tier tier, int src_width, int src_height,
+                         int* width, int* height);
+
+ public:
+  void SetViewerSize(const std::string& viewer_id, int width, int height);
+  void RemoveViewer(const std::string& viewer_id);
+  void Reset();
+
+  // the highest tier any viewer asked for, FULL when nobody did
+  Tier Select(uint64_t now_ms);
+  Stats GetStats();
+
+ private:
+  Tier RequestedTier() const;
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<std::string, Tier> viewer_tiers_;
+  Tier active_tier_ = Tier::FULL;
+  uint64_t downgrade_since_ms_ = 0;
+  uint64_t tier_changes_ = 0;
+};
+}  // namespace crossdesk
+#endif
\ No newline at end of file
@@ -1,5 +1,8 @@
 #include "config_center.h"
 
+#include <algorithm>
+
+#include "audio_config.h"
 #include "autostart.h"
 #include "rd_log.h"
 
@@ -55,6 +58,25 @@ int ConfigCenter::Load() {
       ini_.GetBoolValue(section_, "enable_autostart", enable_autostart_);
   enable_minimize_to_tray_ = ini_.GetBoolValue(
       section_, "enable_minimize_to_tray", enable_minimize_to_tray_);
+  enable_local_cursor_prediction_ =
+      ini_.GetBoolValue(section_, "enable_local_cursor_prediction",
+                        enable_local_cursor_prediction_);
+  audio_frame_duration_us_ = AudioConfig::ClampFrameDuration(
+      static_cast<int>(ini_.GetLongValue(section_, "audio_frame_duration_us",
+                                         audio_frame_duration_us_)));
+  audio_channels_ = AudioConfig::ClampChannels(static_cast<int>(
+      ini_.GetLongValue(section_, "audio_channels", audio_channels_)));
+  enable_latency_markers_ = ini_.GetBoolValue(
+      section_, "enable_latency_markers", enable_latency_markers_);
+  enable_latency_csv_ =
+      ini_.GetBoolValue(section_, "enable_latency_csv", enable_latency_csv_);
+  enable_metrics_server_ = ini_.GetBoolValue(
+      section_, "enable_metrics_server", enable_metrics_server_);
+  metrics_server_port_ = std::clamp(
+      static_cast<int>(ini_.GetLongValue(section_, "metrics_server_port",
+                                         metrics_server_port_)),
+      1, 65535);
+  enable_trace_ = ini_.GetBoolValue(section_, "enable_trace", enable_trace_);
 
   return 0;
 }
@@ -78,6 +100,19 @@ int ConfigCenter::Save() {
   ini_.SetBoolValue(section_, "enable_autostart", enable_autostart_);
   ini_.SetBoolValue(section_, "enable_minimize_to_tray",
                     enable_minimize_to_tray_);
+  ini_.SetBoolValue(section_, "enable_local_cursor_prediction",
+                    enable_local_cursor_prediction_);
+  ini_.SetLongValue(section_, "audio_frame_duration_us",
+                    static_cast<long>(audio_frame_duration_us_));
+  ini_.SetLongValue(section_, "audio_channels",
+                    static_cast<long>(audio_channels_));
+  ini_.SetBoolValue(section_, "enable_latency_markers",
+                    enable_latency_markers_);
+  ini_.SetBoolValue(section_, "enable_latency_csv", enable_latency_csv_);
+  ini_.SetBoolValue(section_, "enable_metrics_server", enable_metrics_server_);
+  ini_.SetLongValue(section_, "metrics_server_port",
+                    static_cast<long>(metrics_server_port_));
+  ini_.SetBoolValue(section_, "enable_trace", enable_trace_);
 
   SI_Error rc = ini_.SaveFile(config_path_.c_str());
   if (rc < 0) {
@@ -249,6 +284,93 @@ int ConfigCenter::SetAutostart(bool enable_autostart) {
   return 0;
 }
 
+int ConfigCenter::SetLocalCursorPrediction(
+    bool enable_local_cursor_prediction) {
+  enable_local_cursor_prediction_ = enable_local_cursor_prediction;
+  ini_.SetBoolValue(section_, "enable_local_cursor_prediction",
+                    enable_local_cursor_prediction_);
+  SI_Error rc = ini_.SaveFile(config_path_.c_str());
+  if (rc < 0) {
+    return -1;
+  }
+  return 0;
+}
+
+int ConfigCenter::SetAudioFrameDuration(int audio_frame_duration_us) {
+  audio_frame_duration_us_ =
+      AudioConfig::ClampFrameDuration(audio_frame_duration_us);
+  ini_.SetLongValue(section_, "audio_frame_duration_us",
+                    static_cast<long>(audio_frame_duration_us_));
+  SI_Error rc = ini_.SaveFile(config_path_.c_str());
+  if (rc < 0) {
+    return -1;
+  }
+  return 0;
+}
+
+int ConfigCenter::SetAudioChannels(int audio_channels) {
+  audio_channels_ = AudioConfig::ClampChannels(audio_channels);
+  ini_.SetLongValue(section_, "audio_channels",
+                    static_cast<long>(audio_channels_));
+  SI_Error rc = ini_.SaveFile(config_path_.c_str());
+  if (rc < 0) {
+    return -1;
+  }
+  return 0;
+}
+
+int ConfigCenter::SetLatencyMarkers(bool enable_latency_markers) {
+  enable_latency_markers_ = enable_latency_markers;
+  ini_.SetBoolValue(section_, "enable_latency_markers",
+                    enable_latency_markers_);
+  SI_Error rc = ini_.SaveFile(config_path_.c_str());
+  if (rc < 0) {
+    return -1;
+  }
+  return 0;
+}
+
+int ConfigCenter::SetLatencyCsv(bool enable_latency_csv) {
+  enable_latency_csv_ = enable_latency_csv;
+  ini_.SetBoolValue(section_, "enable_latency_csv", enable_latency_csv_);
+  SI_Error rc = ini_.SaveFile(config_path_.c_str());
+  if (rc < 0) {
+    return -1;
+  }
+  return 0;
+}
+
+int ConfigCenter::SetMetricsServer(bool enable_metrics_server) {
+  enable_metrics_server_ = enable_metrics_server;
+  ini_.SetBoolValue(section_, "enable_metrics_server", enable_metrics_server_);
+  SI_Error rc = ini_.SaveFile(config_path_.c_str());
+  if (rc < 0) {
+    return -1;
+  }
+  return 0;
+}
+
+int ConfigCenter::SetMetricsServerPort(int metrics_server_port) {
+  metrics_server_port_ = std::clamp(metrics_server_port, 1, 65535);
+  ini_.SetLongValue(section_, "metrics_server_port",
+                    static_cast<long>(metrics_server_port_));
+  SI_Error rc = ini_.SaveFile(config_path_.c_str());
+  if (rc < 0) {
+    return -1;
+  }
+  return 0;
+}
+
+int ConfigCenter::SetTrace(bool enable_trace) {
+  enable_trace_ = enable_trace;
+  ini_.SetBoolValue(section_, "enable_trace", enable_trace_);
+  SI_Error rc = ini_.SaveFile(config_path_.c_str());
+  if (rc < 0) {
+    return -1;
+  }
+  return 0;
+}
+
 // getters
 
 ConfigCenter::LANGUAGE ConfigCenter::GetLanguage() const { return language_; }
@@ -304,4 +426,28 @@ bool ConfigCenter::IsSelfHosted() const { return enable_self_hosted_; }
 bool ConfigCenter::IsMinimizeToTray() const { return enable_minimize_to_tray_; }
 
 bool ConfigCenter::IsEnableAutostart() const { return enable_autostart_; }
+
+bool ConfigCenter::IsEnableLocalCursorPrediction() const {
+  return enable_local_cursor_prediction_;
+}
+
+int ConfigCenter::GetAudioFrameDuration() const {
+  return audio_frame_duration_us_;
+}
+
+int ConfigCenter::GetAudioChannels() const { return audio_channels_; }
+
+bool ConfigCenter::IsEnableLatencyMarkers() const {
+  return enable_latency_markers_;
+}
+
+bool ConfigCenter::IsEnableLatencyCsv() const { return enable_latency_csv_; }
+
+bool ConfigCenter::IsEnableMetricsServer() const {
+  return enable_metrics_server_;
+}
+
+int ConfigCenter::GetMetricsServerPort() const { return metrics_server_port_; }
+
+bool ConfigCenter::IsEnableTrace() const { return enable_trace_; }
 }  // namespace crossdesk
\ No newline at end of file
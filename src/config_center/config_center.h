@@ -41,6 +41,14 @@ class ConfigCenter {
   int SetSelfHosted(bool enable_self_hosted);
   int SetMinimizeToTray(bool enable_minimize_to_tray);
   int SetAutostart(bool enable_autostart);
+  int SetLocalCursorPrediction(bool enable_local_cursor_prediction);
+  int SetAudioFrameDuration(int audio_frame_duration_us);
+  int SetAudioChannels(int audio_channels);
+  int SetLatencyMarkers(bool enable_latency_markers);
+  int SetLatencyCsv(bool enable_latency_csv);
+  int SetMetricsServer(bool enable_metrics_server);
+  int SetMetricsServerPort(int metrics_server_port);
+  int SetTrace(bool enable_trace);
 
   // read config
 
@@ -62,6 +70,14 @@ class ConfigCenter {
   bool IsSelfHosted() const;
   bool IsMinimizeToTray() const;
   bool IsEnableAutostart() const;
+  bool IsEnableLocalCursorPrediction() const;
+  int GetAudioFrameDuration() const;
+  int GetAudioChannels() const;
+  bool IsEnableLatencyMarkers() const;
+  bool IsEnableLatencyCsv() const;
+  bool IsEnableMetricsServer() const;
+  int GetMetricsServerPort() const;
+  bool IsEnableTrace() const;
 
   int Load();
   int Save();
@@ -89,6 +105,17 @@ class ConfigCenter {
   bool enable_self_hosted_ = false;
   bool enable_minimize_to_tray_ = false;
   bool enable_autostart_ = false;
+  bool enable_local_cursor_prediction_ = true;
+  int audio_frame_duration_us_ = 10000;  // one of the opus frame durations
+  int audio_channels_ = 1;               // 1 mono, 2 stereo
+  // glass to glass diagnostics, stamps frames and shows percentiles
+  bool enable_latency_markers_ = false;
+  bool enable_latency_csv_ = false;
+  // prometheus text on 127.0.0.1, for unattended hosts
+  bool enable_metrics_server_ = false;
+  int metrics_server_port_ = 9464;
+  // chrome trace recording from startup, written out on exit
+  bool enable_trace_ = false;
 };
 }  // namespace crossdesk
 #endif
\ No newline at end of file
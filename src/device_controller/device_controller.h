@@ -23,6 +23,13 @@ typedef enum {
   audio_capture,
   host_infomation,
   display_id,
+  cursor_info,
+  audio_config,
+  comfort_noise,
+  audio_timestamp,
+  video_size,
+  latency_marker,
+  video_loss,
 } ControlType;
 typedef enum {
   move = 0,
@@ -39,7 +46,7 @@ typedef enum { key_down = 0, key_up } KeyFlag;
 typedef struct {
   float x;
   float y;
-  int s;
+  float s;  // wheel delta in notches, may be fractional for trackpads
   MouseFlag flag;
 } Mouse;
 
@@ -48,6 +55,22 @@ typedef struct {
   KeyFlag flag;
 } Key;
 
+typedef struct {
+  float x;
+  float y;
+  int type;  // CursorType
+} Cursor;
+
+typedef struct {
+  int frame_duration_us;
+  int channels;
+} AudioParams;
+
+typedef struct {
+  int width;   // viewport the viewer renders into, in pixels
+  int height;
+} VideoSize;
+
 typedef struct {
   char host_name[64];
   size_t host_name_size;
@@ -61,12 +84,19 @@ typedef struct {
 
 struct RemoteAction {
   ControlType type;
+  // input ordering stamped by the viewer, 0 when not set
+  uint32_t seq = 0;
+  uint64_t ts = 0;
   union {
     Mouse m;
     Key k;
     HostInfo i;
     bool a;
-    int d;
+    int d;  // display id, comfort noise dbfs, video loss per mille
+    Cursor c;
+    AudioParams p;
+    uint64_t t;  // audio capture time, GetSystemTimeMicros clock
+    VideoSize v;
   };
 
   // parse
@@ -82,6 +112,10 @@ struct RemoteAction {
   static std::string ToJson(const RemoteAction& a) {
     json j;
     j["type"] = a.type;
+    if (a.seq != 0) {
+      j["seq"] = a.seq;
+      j["ts"] = a.ts;
+    }
     switch (a.type) {
       case ControlType::mouse:
         j["mouse"] = {
@@ -96,6 +130,28 @@ struct RemoteAction {
       case ControlType::display_id:
         j["display_id"] = a.d;
         break;
+      case ControlType::cursor_info:
+        j["cursor"] = {{"x", a.c.x}, {"y", a.c.y}, {"type", a.c.type}};
+        break;
+      case ControlType::audio_config:
+        j["audio_config"] = {{"frame_duration_us", a.p.frame_duration_us},
+                             {"channels", a.p.channels}};
+        break;
+      case ControlType::comfort_noise:
+        j["comfort_noise"] = a.d;
+        break;
+      case ControlType::audio_timestamp:
+        j["audio_timestamp"] = a.t;
+        break;
+      case ControlType::video_size:
+        j["video_size"] = {{"width", a.v.width}, {"height", a.v.height}};
+        break;
+      case ControlType::latency_marker:
+        j["latency_marker"] = a.a;
+        break;
+      case ControlType::video_loss:
+        j["video_loss"] = a.d;
+        break;
       case ControlType::host_infomation: {
         json displays = json::array();
         for (size_t idx = 0; idx < a.i.display_num; idx++) {
@@ -120,11 +176,13 @@ struct RemoteAction {
     try {
       json j = json::parse(json_str);
       out.type = (ControlType)j.at("type").get<int>();
+      out.seq = j.value("seq", (uint32_t)0);
+      out.ts = j.value("ts", (uint64_t)0);
       switch (out.type) {
         case ControlType::mouse:
           out.m.x = j.at("mouse").at("x").get<float>();
           out.m.y = j.at("mouse").at("y").get<float>();
-          out.m.s = j.at("mouse").at("s").get<int>();
+          out.m.s = j.at("mouse").at("s").get<float>();
           out.m.flag = (MouseFlag)j.at("mouse").at("flag").get<int>();
           break;
         case ControlType::keyboard:
@@ -137,6 +195,32 @@ struct RemoteAction {
         case ControlType::display_id:
           out.d = j.at("display_id").get<int>();
           break;
+        case ControlType::cursor_info:
+          out.c.x = j.at("cursor").at("x").get<float>();
+          out.c.y = j.at("cursor").at("y").get<float>();
+          out.c.type = j.at("cursor").at("type").get<int>();
+          break;
+        case ControlType::audio_config:
+          out.p.frame_duration_us =
+              j.at("audio_config").at("frame_duration_us").get<int>();
+          out.p.channels = j.at("audio_config").at("channels").get<int>();
+          break;
+        case ControlType::comfort_noise:
+          out.d = j.at("comfort_noise").get<int>();
+          break;
+        case ControlType::audio_timestamp:
+          out.t = j.at("audio_timestamp").get<uint64_t>();
+          break;
+        case ControlType::video_size:
+          out.v.width = j.at("video_size").at("width").get<int>();
+          out.v.height = j.at("video_size").at("height").get<int>();
+          break;
+        case ControlType::latency_marker:
+          out.a = j.at("latency_marker").get<bool>();
+          break;
+        case ControlType::video_loss:
+          out.d = j.at("video_loss").get<int>();
+          break;
         case ControlType::host_infomation: {
           std::string host_name =
               j.at("host_info").at("host_name").get<std::string>();
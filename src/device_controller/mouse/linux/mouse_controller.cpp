@@ -2,10 +2,20 @@
 
 #include <X11/extensions/XTest.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
 #include "rd_log.h"
 
 namespace crossdesk {
 
+// one click every 8 ms keeps up with a fast flick while still looking smooth
+constexpr auto kWheelClickInterval = std::chrono::milliseconds(8);
+// never queue more than this many clicks, stale scroll is worse than lost
+constexpr float kMaxPendingWheelClicks = 30.0f;
+
 MouseController::MouseController() {}
 
 MouseController::~MouseController() { Destroy(); }
@@ -28,10 +38,35 @@ int MouseController::Init(std::vector<DisplayInfo> display_info_list) {
     return -2;
   }
 
+  wheel_display_ = XOpenDisplay(NULL);
+  if (wheel_display_) {
+    wheel_running_ = true;
+    wheel_thread_ = std::thread(&MouseController::MouseWheelLoop, this);
+  } else {
+    LOG_WARN("Cannot open wheel connection, fall back to direct wheel clicks");
+  }
+
   return 0;
 }
 
 int MouseController::Destroy() {
+  if (wheel_running_) {
+    {
+      std::lock_guard<std::mutex> lock(wheel_mutex_);
+      wheel_running_ = false;
+    }
+    wheel_cv_.notify_all();
+  }
+
+  if (wheel_thread_.joinable()) {
+    wheel_thread_.join();
+  }
+
+  if (wheel_display_) {
+    XCloseDisplay(wheel_display_);
+    wheel_display_ = nullptr;
+  }
+
   if (display_) {
     XCloseDisplay(display_);
     display_ = nullptr;
@@ -77,22 +112,12 @@ int MouseController::SendMouseCommand(RemoteAction remote_action,
           XTestFakeButtonEvent(display_, 2, False, CurrentTime);
           XFlush(display_);
           break;
-        case MouseFlag::wheel_vertical: {
-          if (remote_action.m.s > 0) {
-            SimulateMouseWheel(4, remote_action.m.s);
-          } else if (remote_action.m.s < 0) {
-            SimulateMouseWheel(5, -remote_action.m.s);
-          }
+        case MouseFlag::wheel_vertical:
+          AccumulateMouseWheel(remote_action.m.s, false);
           break;
-        }
-        case MouseFlag::wheel_horizontal: {
-          if (remote_action.m.s > 0) {
-            SimulateMouseWheel(6, remote_action.m.s);
-          } else if (remote_action.m.s < 0) {
-            SimulateMouseWheel(7, -remote_action.m.s);
-          }
+        case MouseFlag::wheel_horizontal:
+          AccumulateMouseWheel(remote_action.m.s, true);
           break;
-        }
       }
       break;
     default:
@@ -117,11 +142,76 @@ void MouseController::SimulateKeyUp(int kval) {
   XFlush(display_);
 }
 
-void MouseController::SimulateMouseWheel(int direction_button, int count) {
-  for (int i = 0; i < count; ++i) {
-    XTestFakeButtonEvent(display_, direction_button, True, CurrentTime);
-    XTestFakeButtonEvent(display_, direction_button, False, CurrentTime);
+void MouseController::AccumulateMouseWheel(float delta, bool horizontal) {
+  int count = 0;
+  {
+    std::lock_guard<std::mutex> lock(wheel_mutex_);
+    float& accum = horizontal ? wheel_accum_horizontal_ : wheel_accum_vertical_;
+    // drop the leftover fraction when the scroll direction flips
+    if (accum * delta < 0) {
+      accum = 0.0f;
+    }
+    accum = std::clamp(accum + delta, -kMaxPendingWheelClicks,
+                       kMaxPendingWheelClicks);
+    if (!wheel_running_) {
+      // no pacing thread, emit the whole notches right away and keep the
+      // fraction for the next event
+      count = static_cast<int>(accum);
+      accum -= static_cast<float>(count);
+    }
+  }
+
+  if (wheel_running_) {
+    wheel_cv_.notify_one();
+    return;
+  }
+
+  if (count != 0) {
+    int button = horizontal ? (count > 0 ? 6 : 7) : (count > 0 ? 4 : 5);
+    for (int i = 0; i < std::abs(count); ++i) {
+      XTestFakeButtonEvent(display_, button, True, CurrentTime);
+      XTestFakeButtonEvent(display_, button, False, CurrentTime);
+    }
+    XFlush(display_);
+  }
+}
+
+void MouseController::MouseWheelLoop() {
+  std::unique_lock<std::mutex> lock(wheel_mutex_);
+  while (wheel_running_) {
+    wheel_cv_.wait(lock, [this]() {
+      return !wheel_running_ || std::fabs(wheel_accum_vertical_) >= 1.0f ||
+             std::fabs(wheel_accum_horizontal_) >= 1.0f;
+    });
+    if (!wheel_running_) {
+      break;
+    }
+
+    int vertical_button = 0;
+    int horizontal_button = 0;
+    if (std::fabs(wheel_accum_vertical_) >= 1.0f) {
+      vertical_button = wheel_accum_vertical_ > 0 ? 4 : 5;
+      wheel_accum_vertical_ -= wheel_accum_vertical_ > 0 ? 1.0f : -1.0f;
+    }
+    if (std::fabs(wheel_accum_horizontal_) >= 1.0f) {
+      horizontal_button = wheel_accum_horizontal_ > 0 ? 6 : 7;
+      wheel_accum_horizontal_ -= wheel_accum_horizontal_ > 0 ? 1.0f : -1.0f;
+    }
+
+    lock.unlock();
+    if (vertical_button) {
+      XTestFakeButtonEvent(wheel_display_, vertical_button, True, CurrentTime);
+      XTestFakeButtonEvent(wheel_display_, vertical_button, False, CurrentTime);
+    }
+    if (horizontal_button) {
+      XTestFakeButtonEvent(wheel_display_, horizontal_button, True,
+                           CurrentTime);
+      XTestFakeButtonEvent(wheel_display_, horizontal_button, False,
+                           CurrentTime);
+    }
+    XFlush(wheel_display_);
+    std::this_thread::sleep_for(kWheelClickInterval);
+    lock.lock();
   }
-  XFlush(display_);
 }
 }  // namespace crossdesk
\ No newline at end of file
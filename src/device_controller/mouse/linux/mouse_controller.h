@@ -11,6 +11,10 @@
 #include <X11/Xutil.h>
 #include <unistd.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include "device_controller.h"
@@ -31,13 +35,24 @@ class MouseController : public DeviceController {
   void SimulateKeyDown(int kval);
   void SimulateKeyUp(int kval);
   void SetMousePosition(int x, int y);
-  void SimulateMouseWheel(int direction_button, int count);
+  void AccumulateMouseWheel(float delta, bool horizontal);
+  void MouseWheelLoop();
 
   Display* display_ = nullptr;
   Window root_ = 0;
   std::vector<DisplayInfo> display_info_list_;
   int screen_width_ = 0;
   int screen_height_ = 0;
+
+  // wheel deltas are accumulated and replayed as evenly paced clicks on a
+  // dedicated X connection so bursts do not flood the target application
+  Display* wheel_display_ = nullptr;
+  std::thread wheel_thread_;
+  std::mutex wheel_mutex_;
+  std::condition_variable wheel_cv_;
+  std::atomic<bool> wheel_running_{false};
+  float wheel_accum_vertical_ = 0.0f;
+  float wheel_accum_horizontal_ = 0.0f;
 };
 }  // namespace crossdesk
 #endif
\ No newline at end of file
@@ -2,10 +2,15 @@
 
 #include <ApplicationServices/ApplicationServices.h>
 
+#include <cmath>
+
 #include "rd_log.h"
 
 namespace crossdesk {
 
+// pixel based scrolling keeps fractional trackpad deltas smooth
+constexpr float kScrollPixelsPerLine = 10.0f;
+
 MouseController::MouseController() {}
 
 MouseController::~MouseController() {}
@@ -70,11 +75,13 @@ int MouseController::SendMouseCommand(RemoteAction remote_action,
         break;
       case MouseFlag::wheel_vertical:
         mouse_event = CGEventCreateScrollWheelEvent(
-            NULL, kCGScrollEventUnitLine, 2, remote_action.m.s, 0);
+            NULL, kCGScrollEventUnitPixel, 2,
+            (int32_t)std::lround(remote_action.m.s * kScrollPixelsPerLine), 0);
         break;
       case MouseFlag::wheel_horizontal:
         mouse_event = CGEventCreateScrollWheelEvent(
-            NULL, kCGScrollEventUnitLine, 2, 0, remote_action.m.s);
+            NULL, kCGScrollEventUnitPixel, 2, 0,
+            (int32_t)std::lround(remote_action.m.s * kScrollPixelsPerLine));
         break;
       default:
         if (left_dragging_) {
@@ -1,5 +1,7 @@
 #include "mouse_controller.h"
 
+#include <cmath>
+
 #include "rd_log.h"
 
 namespace crossdesk {
@@ -50,11 +52,12 @@ int MouseController::SendMouseCommand(RemoteAction remote_action,
         break;
       case MouseFlag::wheel_vertical:
         ip.mi.dwFlags = MOUSEEVENTF_WHEEL;
-        ip.mi.mouseData = remote_action.m.s * 120;
+        // windows accepts sub-notch wheel deltas natively
+        ip.mi.mouseData = (DWORD)(LONG)std::lround(remote_action.m.s * 120);
         break;
       case MouseFlag::wheel_horizontal:
         ip.mi.dwFlags = MOUSEEVENTF_HWHEEL;
-        ip.mi.mouseData = remote_action.m.s * 120;
+        ip.mi.mouseData = (DWORD)(LONG)std::lround(remote_action.m.s * 120);
         break;
       default:
         ip.mi.dwFlags = MOUSEEVENTF_MOVE;
@@ -21,11 +21,11 @@
 #define SETTINGS_WINDOW_WIDTH_CN 202
 #define SETTINGS_WINDOW_WIDTH_EN 248
 #if _WIN32
-#define SETTINGS_WINDOW_HEIGHT_CN 375
-#define SETTINGS_WINDOW_HEIGHT_EN 375
+#define SETTINGS_WINDOW_HEIGHT_CN 465
+#define SETTINGS_WINDOW_HEIGHT_EN 465
 #else
-#define SETTINGS_WINDOW_HEIGHT_CN 345
-#define SETTINGS_WINDOW_HEIGHT_EN 345
+#define SETTINGS_WINDOW_HEIGHT_CN 435
+#define SETTINGS_WINDOW_HEIGHT_EN 435
 #endif
 #define SELF_HOSTED_SERVER_CONFIG_WINDOW_WIDTH_CN 228
 #define SELF_HOSTED_SERVER_CONFIG_WINDOW_WIDTH_EN 275
@@ -39,6 +39,10 @@
 #define VIDEO_FRAME_RATE_SELECT_WINDOW_PADDING_EN 167
 #define VIDEO_ENCODE_FORMAT_SELECT_WINDOW_PADDING_CN 120
 #define VIDEO_ENCODE_FORMAT_SELECT_WINDOW_PADDING_EN 167
+#define AUDIO_FRAME_DURATION_SELECT_WINDOW_PADDING_CN 120
+#define AUDIO_FRAME_DURATION_SELECT_WINDOW_PADDING_EN 167
+#define AUDIO_CHANNELS_SELECT_WINDOW_PADDING_CN 120
+#define AUDIO_CHANNELS_SELECT_WINDOW_PADDING_EN 167
 #define ENABLE_HARDWARE_VIDEO_CODEC_CHECKBOX_PADDING_CN 171
 #define ENABLE_HARDWARE_VIDEO_CODEC_CHECKBOX_PADDING_EN 218
 #define ENABLE_TURN_CHECKBOX_PADDING_CN 171
@@ -49,6 +53,8 @@
 #define ENABLE_SELF_HOSTED_SERVER_CHECKBOX_PADDING_EN 218
 #define ENABLE_AUTOSTART_PADDING_CN 171
 #define ENABLE_AUTOSTART_PADDING_EN 218
+#define ENABLE_LOCAL_CURSOR_PREDICTION_PADDING_CN 171
+#define ENABLE_LOCAL_CURSOR_PREDICTION_PADDING_EN 218
 #define ENABLE_MINIZE_TO_TRAY_PADDING_CN 171
 #define ENABLE_MINIZE_TO_TRAY_PADDING_EN 218
 #define SELF_HOSTED_SERVER_HOST_INPUT_BOX_PADDING_CN 90
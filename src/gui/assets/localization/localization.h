@@ -58,6 +58,23 @@ static std::vector<std::string> out = {reinterpret_cast<const char*>(u8"输出")
                                        "Out"};
 static std::vector<std::string> loss_rate = {
     reinterpret_cast<const char*>(u8"丢包率"), "Loss Rate"};
+static std::vector<std::string> dump_metrics = {
+    reinterpret_cast<const char*>(u8"导出指标"), "Dump Metrics"};
+static std::vector<std::string> file_transfer = {
+    reinterpret_cast<const char*>(u8"文件传输"), "File Transfer"};
+static std::vector<std::string> remote_file_path = {
+    reinterpret_cast<const char*>(u8"远端文件路径:"), "Remote File Path:"};
+static std::vector<std::string> fetch_file = {
+    reinterpret_cast<const char*>(u8"获取"), "Fetch"};
+static std::vector<std::string> drop_files_to_send = {
+    reinterpret_cast<const char*>(u8"拖放文件到窗口即可发送"),
+    "Drop files on the window to send them"};
+static std::vector<std::string> transfer_done = {
+    reinterpret_cast<const char*>(u8"完成"), "Done"};
+static std::vector<std::string> transfer_failed = {
+    reinterpret_cast<const char*>(u8"失败"), "Failed"};
+static std::vector<std::string> clear_finished = {
+    reinterpret_cast<const char*>(u8"清除已结束"), "Clear Finished"};
 static std::vector<std::string> exit_fullscreen = {
     reinterpret_cast<const char*>(u8"退出全屏"), "Exit fullscreen"};
 static std::vector<std::string> control_mouse = {
@@ -68,6 +85,8 @@ static std::vector<std::string> audio_capture = {
     reinterpret_cast<const char*>(u8"声音"), "Audio"};
 static std::vector<std::string> mute = {
     reinterpret_cast<const char*>(u8" 静音"), " Mute"};
+static std::vector<std::string> volume = {
+    reinterpret_cast<const char*>(u8"音量"), "Volume"};
 static std::vector<std::string> settings = {
     reinterpret_cast<const char*>(u8"设置"), "Settings"};
 static std::vector<std::string> language = {
@@ -93,6 +112,14 @@ static std::vector<std::string> av1 = {reinterpret_cast<const char*>(u8"AV1"),
                                        "AV1"};
 static std::vector<std::string> h264 = {
     reinterpret_cast<const char*>(u8"H.264"), "H.264"};
+static std::vector<std::string> audio_frame_duration = {
+    reinterpret_cast<const char*>(u8"音频帧长:"), "Audio Frame:"};
+static std::vector<std::string> audio_channels = {
+    reinterpret_cast<const char*>(u8"音频声道:"), "Audio Channels:"};
+static std::vector<std::string> audio_mono = {
+    reinterpret_cast<const char*>(u8"单声道"), "Mono"};
+static std::vector<std::string> audio_stereo = {
+    reinterpret_cast<const char*>(u8"立体声"), "Stereo"};
 static std::vector<std::string> enable_hardware_video_codec = {
     reinterpret_cast<const char*>(u8"启用硬件编解码器:"),
     "Enable Hardware Video Codec:"};
@@ -171,12 +198,44 @@ static std::vector<std::string> confirm_delete_connection = {
 
 static std::vector<std::string> enable_autostart = {
     reinterpret_cast<const char*>(u8"开机自启:"), "Auto Start:"};
+static std::vector<std::string> enable_local_cursor_prediction = {
+    reinterpret_cast<const char*>(u8"本地光标预测:"), "Cursor Prediction:"};
 #if _WIN32
 static std::vector<std::string> minimize_to_tray = {
     reinterpret_cast<const char*>(u8"退出时最小化到系统托盘:"),
     "Minimize to system tray when exit:"};
 static std::vector<LPCWSTR> exit_program = {L"退出", L"Exit"};
 #endif
+
+// every table the ImGui windows draw from, the font atlas is seeded with
+// their glyphs, add new tables here too
+static std::vector<const std::vector<std::string>*> all_strings = {
+    &local_desktop, &local_id, &local_id_copied_to_clipboard, &password,
+    &max_password_len, &remote_desktop, &remote_id, &connect,
+    &recent_connections, &disconnect, &fullscreen, &show_net_traffic_stats,
+    &hide_net_traffic_stats, &video, &audio, &data, &total, &in, &out,
+    &loss_rate, &dump_metrics, &file_transfer, &remote_file_path,
+    &fetch_file, &drop_files_to_send, &transfer_done, &transfer_failed,
+    &clear_finished, &exit_fullscreen, &control_mouse, &release_mouse,
+    &audio_capture, &mute, &volume, &settings, &language, &language_zh,
+    &language_en, &video_quality, &video_frame_rate, &video_quality_high,
+    &video_quality_medium, &video_quality_low, &video_encode_format, &av1,
+    &h264, &audio_frame_duration, &audio_channels, &audio_mono,
+    &audio_stereo, &enable_hardware_video_codec, &enable_turn, &enable_srtp,
+    &self_hosted_server_config, &self_hosted_server_settings,
+    &self_hosted_server_address, &self_hosted_server_port,
+    &self_hosted_server_coturn_server_port,
+    &self_hosted_server_certificate_path, &select_a_file, &ok, &cancel,
+    &new_password, &input_password, &validate_password, &reinput_password,
+    &remember_password, &signal_connected, &signal_disconnected, &p2p_connected,
+    &p2p_disconnected, &p2p_connecting, &p2p_failed, &p2p_closed, &no_such_id,
+    &about, &new_version_available, &version, &access_website,
+    &confirm_delete_connection, &enable_autostart,
+    &enable_local_cursor_prediction,
+#if _WIN32
+    &minimize_to_tray,
+#endif
+};
 }  // namespace localization
 }  // namespace crossdesk
 #endif
\ No newline at end of file
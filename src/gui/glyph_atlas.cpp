@@ -0,0 +1,391 @@
+#include "glyph_atlas.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "IconsFontAwesome6.h"
+#include "OPPOSans_Regular.h"
+#include "fa_solid_900.h"
+#include "imgui_internal.h"
+#include "rd_log.h"
+
+namespace crossdesk {
+
+namespace {
+
+constexpr float kFontSize = 32.0f;
+constexpr float kIconSize = 30.0f;
+
+constexpr uint32_t kCacheMagic = 0x41464443;  // "CDFA"
+constexpr uint32_t kCacheVersion = 1;
+constexpr int kTexLines = IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1;
+
+// followed by the glyph set words, the line uvs, the custom rects, the
+// glyphs and the alpha8 pixels
+struct CacheHeader {
+  uint32_t magic = kCacheMagic;
+  uint32_t version = kCacheVersion;
+  uint32_t imgui_version = IMGUI_VERSION_NUM;
+  uint32_t glyph_size = sizeof(ImFontGlyph);
+  uint64_t font_hash = 0;
+  float font_size = kFontSize;
+  float icon_size = kIconSize;
+  uint32_t glyph_words = 0;
+  uint32_t tex_lines = kTexLines;
+  int32_t tex_width = 0;
+  int32_t tex_height = 0;
+  float white_pixel_u = 0;
+  float white_pixel_v = 0;
+  int32_t pack_id_mouse_cursors = -1;
+  int32_t pack_id_lines = -1;
+  uint32_t custom_rect_count = 0;
+  uint32_t glyph_count = 0;
+  float ascent = 0;
+  float descent = 0;
+};
+
+struct CachedRect {
+  uint16_t width = 0;
+  uint16_t height = 0;
+  uint16_t x = 0;
+  uint16_t y = 0;
+};
+
+uint64_t Fnv1a(uint64_t hash, const unsigned char* data, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+uint64_t FontHash() {
+  static const uint64_t hash = Fnv1a(
+      Fnv1a(0xcbf29ce484222325ULL, OPPOSans_Regular_ttf,
+            OPPOSans_Regular_ttf_len),
+      fa_solid_900_ttf, fa_solid_900_ttf_len);
+  return hash;
+}
+
+// bounds checked reads over the cache file
+class CacheReader {
+ public:
+  explicit CacheReader(const std::vector<char>& data) : data_(data) {}
+
+  bool Read(void* out, size_t size) {
+    if (size > data_.size() - offset_) {
+      return false;
+    }
+    memcpy(out, data_.data() + offset_, size);
+    offset_ += size;
+    return true;
+  }
+
+ private:
+  const std::vector<char>& data_;
+  size_t offset_ = 0;
+};
+
+}  // namespace
+
+GlyphAtlas::GlyphAtlas() {
+  // latin-1 covers ascii input and the few symbols the ui draws itself
+  glyphs_.AddRanges(atlas_.GetGlyphRangesDefault());
+}
+
+GlyphAtlas::~GlyphAtlas() {}
+
+void GlyphAtlas::AddText(const char* text) {
+  if (!text) {
+    return;
+  }
+
+  const char* text_end = text + strlen(text);
+  std::lock_guard<std::mutex> lock(glyphs_mutex_);
+  while (text < text_end) {
+    unsigned int c = 0;
+    int len = ImTextCharFromUtf8(&c, text, text_end);
+    if (len <= 0) {
+      break;
+    }
+    text += len;
+    if (c > IM_UNICODE_CODEPOINT_MAX) {
+      continue;
+    }
+    if (!glyphs_.GetBit(c)) {
+      glyphs_.SetBit(c);
+      dirty_ = true;
+    }
+  }
+}
+
+bool GlyphAtlas::Update() {
+  {
+    std::lock_guard<std::mutex> lock(glyphs_mutex_);
+    if (!dirty_) {
+      return false;
+    }
+    dirty_ = false;
+  }
+
+  // a cache holding every requested glyph saves the rasterising
+  if (!cache_tried_ && !cache_file_.empty()) {
+    cache_tried_ = true;
+    if (0 == LoadCache()) {
+      return true;
+    }
+  }
+
+  // text added while building marks the atlas dirty again, the cache only
+  // claims what went into this build
+  std::vector<ImU32> built_glyphs;
+  {
+    std::lock_guard<std::mutex> lock(glyphs_mutex_);
+    ImVector<ImWchar> ranges;
+    glyphs_.BuildRanges(&ranges);
+    ranges_.swap(ranges);
+    built_glyphs.assign(glyphs_.UsedChars.begin(), glyphs_.UsedChars.end());
+  }
+
+  if (0 != Build()) {
+    return false;
+  }
+  if (!cache_file_.empty()) {
+    SaveCache(built_glyphs);
+  }
+  return true;
+}
+
+int GlyphAtlas::Build() {
+  auto start = std::chrono::steady_clock::now();
+
+  atlas_.Clear();
+  ImFontConfig config;
+  config.FontDataOwnedByAtlas = false;
+  atlas_.AddFontFromMemoryTTF(OPPOSans_Regular_ttf, OPPOSans_Regular_ttf_len,
+                              kFontSize, &config, ranges_.Data);
+  config.MergeMode = true;
+  static const ImWchar icon_ranges[] = {ICON_MIN_FA, ICON_MAX_FA, 0};
+  atlas_.AddFontFromMemoryTTF(fa_solid_900_ttf, fa_solid_900_ttf_len,
+                              kIconSize, &config, icon_ranges);
+  if (!atlas_.Build()) {
+    LOG_ERROR("Build font atlas failed");
+    return -1;
+  }
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  LOG_INFO("Font atlas built with [{}] glyphs, [{}x{}] in [{}] ms",
+           atlas_.Fonts[0]->Glyphs.Size, atlas_.TexWidth, atlas_.TexHeight,
+           elapsed);
+  return 0;
+}
+
+int GlyphAtlas::LoadCache() {
+  auto start = std::chrono::steady_clock::now();
+
+  std::ifstream file(cache_file_, std::ios::binary | std::ios::ate);
+  if (!file) {
+    return -1;
+  }
+  std::streamsize size = file.tellg();
+  if (size <= 0) {
+    return -1;
+  }
+  std::vector<char> data((size_t)size);
+  file.seekg(0);
+  if (!file.read(data.data(), size)) {
+    return -1;
+  }
+  file.close();
+
+  CacheReader reader(data);
+  CacheHeader header;
+  if (!reader.Read(&header, sizeof(header))) {
+    return -1;
+  }
+  CacheHeader expected;
+  if (header.magic != expected.magic || header.version != expected.version ||
+      header.imgui_version != expected.imgui_version ||
+      header.glyph_size != expected.glyph_size ||
+      header.font_hash != FontHash() ||
+      header.font_size != expected.font_size ||
+      header.icon_size != expected.icon_size ||
+      header.tex_lines != expected.tex_lines || header.glyph_count == 0 ||
+      header.tex_width <= 0 || header.tex_height <= 0) {
+    LOG_INFO("Font atlas cache is stale, rebuild");
+    return -1;
+  }
+  uint64_t expected_size =
+      sizeof(header) + (uint64_t)header.glyph_words * sizeof(ImU32) +
+      sizeof(ImVec4) * kTexLines +
+      (uint64_t)header.custom_rect_count * sizeof(CachedRect) +
+      (uint64_t)header.glyph_count * sizeof(ImFontGlyph) +
+      (uint64_t)header.tex_width * header.tex_height;
+  if (expected_size != data.size()) {
+    LOG_WARN("Font atlas cache is corrupted, rebuild");
+    return -1;
+  }
+
+  std::vector<ImU32> cached_glyphs(header.glyph_words);
+  ImVec4 tex_uv_lines[kTexLines];
+  std::vector<CachedRect> rects(header.custom_rect_count);
+  std::vector<ImFontGlyph> font_glyphs(header.glyph_count);
+  size_t pixel_count = (size_t)header.tex_width * header.tex_height;
+  if (!reader.Read(cached_glyphs.data(),
+                   cached_glyphs.size() * sizeof(ImU32)) ||
+      !reader.Read(tex_uv_lines, sizeof(tex_uv_lines)) ||
+      !reader.Read(rects.data(), rects.size() * sizeof(CachedRect)) ||
+      !reader.Read(font_glyphs.data(),
+                   font_glyphs.size() * sizeof(ImFontGlyph))) {
+    LOG_WARN("Font atlas cache is truncated");
+    return -1;
+  }
+  unsigned char* pixels = (unsigned char*)IM_ALLOC(pixel_count);
+  if (!reader.Read(pixels, pixel_count)) {
+    IM_FREE(pixels);
+    LOG_WARN("Font atlas cache is truncated");
+    return -1;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(glyphs_mutex_);
+    if ((int)cached_glyphs.size() != glyphs_.UsedChars.Size) {
+      IM_FREE(pixels);
+      return -1;
+    }
+    // the cache may hold more than asked for, never less
+    for (int i = 0; i < glyphs_.UsedChars.Size; i++) {
+      if (glyphs_.UsedChars[i] & ~cached_glyphs[i]) {
+        IM_FREE(pixels);
+        LOG_INFO("Font atlas cache misses glyphs, rebuild");
+        return -1;
+      }
+    }
+    for (int i = 0; i < glyphs_.UsedChars.Size; i++) {
+      glyphs_.UsedChars[i] = cached_glyphs[i];
+    }
+  }
+
+  atlas_.Clear();
+  ImFont* font = IM_NEW(ImFont);
+  font->ContainerAtlas = &atlas_;
+  font->FontSize = header.font_size;
+  font->Ascent = header.ascent;
+  font->Descent = header.descent;
+  font->Glyphs.resize((int)font_glyphs.size());
+  memcpy(font->Glyphs.Data, font_glyphs.data(),
+         font_glyphs.size() * sizeof(ImFontGlyph));
+  atlas_.Fonts.push_back(font);
+
+  // the lookup tables read the fallback and ellipsis settings from here
+  ImFontConfig config;
+  config.FontDataOwnedByAtlas = false;
+  config.SizePixels = header.font_size;
+  config.DstFont = font;
+  ImFormatString(config.Name, IM_ARRAYSIZE(config.Name), "OPPOSans, %.0fpx",
+                 header.font_size);
+  atlas_.ConfigData.push_back(config);
+  font->ConfigData = &atlas_.ConfigData.back();
+  font->ConfigDataCount = 1;
+  font->BuildLookupTable();
+
+  for (const CachedRect& cached_rect : rects) {
+    ImFontAtlasCustomRect rect;
+    rect.Width = cached_rect.width;
+    rect.Height = cached_rect.height;
+    rect.X = cached_rect.x;
+    rect.Y = cached_rect.y;
+    atlas_.CustomRects.push_back(rect);
+  }
+  atlas_.PackIdMouseCursors = header.pack_id_mouse_cursors;
+  atlas_.PackIdLines = header.pack_id_lines;
+
+  atlas_.TexWidth = header.tex_width;
+  atlas_.TexHeight = header.tex_height;
+  atlas_.TexUvScale =
+      ImVec2(1.0f / header.tex_width, 1.0f / header.tex_height);
+  atlas_.TexUvWhitePixel = ImVec2(header.white_pixel_u, header.white_pixel_v);
+  memcpy(atlas_.TexUvLines, tex_uv_lines, sizeof(tex_uv_lines));
+  atlas_.TexPixelsAlpha8 = pixels;
+  atlas_.TexPixelsUseColors = false;
+  atlas_.TexReady = true;
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  LOG_INFO("Font atlas loaded from cache with [{}] glyphs, [{}x{}] in [{}] ms",
+           font->Glyphs.Size, atlas_.TexWidth, atlas_.TexHeight, elapsed);
+  return 0;
+}
+
+int GlyphAtlas::SaveCache(const std::vector<ImU32>& built_glyphs) {
+  unsigned char* pixels = nullptr;
+  int width = 0;
+  int height = 0;
+  atlas_.GetTexDataAsAlpha8(&pixels, &width, &height);
+  if (!pixels || atlas_.Fonts.empty()) {
+    return -1;
+  }
+  const ImFont* font = atlas_.Fonts[0];
+
+  CacheHeader header;
+  header.font_hash = FontHash();
+  header.glyph_words = (uint32_t)built_glyphs.size();
+  header.tex_width = width;
+  header.tex_height = height;
+  header.white_pixel_u = atlas_.TexUvWhitePixel.x;
+  header.white_pixel_v = atlas_.TexUvWhitePixel.y;
+  header.pack_id_mouse_cursors = atlas_.PackIdMouseCursors;
+  header.pack_id_lines = atlas_.PackIdLines;
+  header.custom_rect_count = atlas_.CustomRects.Size;
+  header.glyph_count = font->Glyphs.Size;
+  header.ascent = font->Ascent;
+  header.descent = font->Descent;
+
+  std::vector<CachedRect> rects;
+  for (const ImFontAtlasCustomRect& rect : atlas_.CustomRects) {
+    CachedRect cached_rect;
+    cached_rect.width = rect.Width;
+    cached_rect.height = rect.Height;
+    cached_rect.x = rect.X;
+    cached_rect.y = rect.Y;
+    rects.push_back(cached_rect);
+  }
+
+  // written aside and renamed so a crash never leaves half a cache
+  std::string tmp_file = cache_file_ + ".tmp";
+  std::ofstream file(tmp_file, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    LOG_WARN("Open font atlas cache [{}] failed", tmp_file);
+    return -1;
+  }
+  file.write((const char*)&header, sizeof(header));
+  file.write((const char*)built_glyphs.data(),
+             built_glyphs.size() * sizeof(ImU32));
+  file.write((const char*)atlas_.TexUvLines, sizeof(atlas_.TexUvLines));
+  file.write((const char*)rects.data(), rects.size() * sizeof(CachedRect));
+  file.write((const char*)font->Glyphs.Data,
+             font->Glyphs.Size * sizeof(ImFontGlyph));
+  file.write((const char*)pixels, (size_t)width * height);
+  file.close();
+  if (!file) {
+    LOG_WARN("Write font atlas cache [{}] failed", tmp_file);
+    return -1;
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(tmp_file, cache_file_, ec);
+  if (ec) {
+    LOG_WARN("Replace font atlas cache [{}] failed: {}", cache_file_,
+             ec.message());
+    return -1;
+  }
+  return 0;
+}
+}  // namespace crossdesk
\ No newline at end of file
@@ -0,0 +1,58 @@
+/*
+ * @Author: DI JUNKUN
+ * @Date: 2026-10-19
+ * Copyright (c) 2026 by DI JUNKUN, All Rights Reserved.
+ */
+
+#ifndef _GLYPH_ATLAS_H_
+#define _GLYPH_ATLAS_H_
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "imgui.h"
+
+namespace crossdesk {
+
+// One font atlas for every ImGui context, holding only the glyphs the ui
+// has asked for instead of the full CJK range. Text can be added from any
+// thread, the atlas itself is rebuilt on the ui thread between frames.
+class GlyphAtlas {
+ public:
+  GlyphAtlas();
+  ~GlyphAtlas();
+
+ public:
+  // pass to ImGui::CreateContext so the contexts share it
+  ImFontAtlas* Atlas() { return &atlas_; }
+
+  // the first build tries this file, every build rewrites it
+  void SetCacheFile(const std::string& path) { cache_file_ = path; }
+
+  void AddText(const char* text);
+  void AddText(const std::string& text) { AddText(text.c_str()); }
+
+  // rebuilds if glyphs were added since the last build, true means every
+  // renderer has to upload the font texture again
+  bool Update();
+
+ private:
+  int Build();
+  int LoadCache();
+  int SaveCache(const std::vector<ImU32>& built_glyphs);
+
+ private:
+  std::mutex glyphs_mutex_;
+  ImFontGlyphRangesBuilder glyphs_;
+  bool dirty_ = true;
+
+  // the atlas keeps a pointer to the ranges
+  ImVector<ImWchar> ranges_;
+  ImFontAtlas atlas_;
+
+  std::string cache_file_;
+  bool cache_tried_ = false;
+};
+}  // namespace crossdesk
+#endif
\ No newline at end of file
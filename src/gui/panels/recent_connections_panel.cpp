@@ -113,6 +113,7 @@ int Render::ShowRecentConnections() {
     } else {
       it.second.remote_host_name = "unknown";
     }
+    glyph_atlas_.AddText(it.second.remote_host_name);
 
     ImVec2 image_screen_pos = ImVec2(ImGui::GetCursorScreenPos().x + 5.0f,
                                      ImGui::GetCursorScreenPos().y + 5.0f);
@@ -145,12 +145,32 @@ int Render::ConnectTo(const std::string& remote_id, const char* password,
     memcpy(&props->params_, &params_, sizeof(Params));
     props->params_.user_id = props->local_id_.c_str();
     props->peer_ = CreatePeer(&props->params_);
+    SubStreamWindowProperties* raw_props = props.get();
+    props->data_mux_.SetSender([raw_props](const char* data, size_t size) {
+      if (!raw_props->peer_) {
+        return -1;
+      }
+      return SendDataFrame(raw_props->peer_, data, size,
+                           raw_props->data_label_.c_str());
+    });
+    props->file_transfer_.SetSender(
+        [raw_props](const char* data, size_t size) {
+          if (!raw_props->peer_) {
+            return -1;
+          }
+          return SendDataFrame(raw_props->peer_, data, size,
+                               raw_props->file_label_.c_str());
+        });
+    props->file_transfer_.SetSaveDirectory(cache_path_ + "/received_files");
+    // the host may not push files, only answer what was fetched
+    props->file_transfer_.SetAcceptUnrequestedOffers(false);
 
     for (auto& display_info : display_info_list_) {
       AddVideoStream(peer_, display_info.name.c_str());
     }
     AddAudioStream(props->peer_, props->audio_label_.c_str());
     AddDataStream(props->peer_, props->data_label_.c_str());
+    AddDataStream(props->peer_, props->file_label_.c_str());
 
     if (props->peer_) {
       LOG_INFO("[{}] Create peer instance successful", props->local_id_);
@@ -160,6 +180,8 @@ int Render::ConnectTo(const std::string& remote_id, const char* password,
       LOG_INFO("Create peer [{}] instance failed", props->local_id_);
     }
 
+    props->local_cursor_prediction_ =
+        config_center_->IsEnableLocalCursorPrediction();
     props->connection_status_ = ConnectionStatus::Connecting;
   }
   int ret = -1;
@@ -2,15 +2,17 @@
 
 #include <libyuv.h>
 
+#include <algorithm>
+#include <csignal>
+#include <ctime>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <thread>
 
-#include "OPPOSans_Regular.h"
 #include "device_controller_factory.h"
 #include "fa_regular_400.h"
-#include "fa_solid_900.h"
 #include "layout.h"
 #include "localization.h"
 #include "platform.h"
@@ -22,8 +24,36 @@
 
 #define MOUSE_GRAB_PADDING 5
 
+// show the host cursor position once the local pointer has been idle this long
+#define CURSOR_RECONCILE_MS 300
+// position only updates from the host are rate limited, type changes are not
+#define CURSOR_INFO_INTERVAL_MS 50
+// refresh of the comfort noise marker while the captured audio is silent
+#define COMFORT_NOISE_INTERVAL_MS 500
+// audio capture timestamp markers, also sent right after silence
+#define AUDIO_TIMESTAMP_INTERVAL_MS 200
+// lip sync offset left alone, and the most audio is delayed to reach video
+#define AV_SYNC_TOLERANCE_MS 20
+#define AV_SYNC_MAX_AUDIO_DELAY_MS 300
+// viewport updates to the host while the stream window is being resized
+#define VIDEO_SIZE_INTERVAL_MS 500
+// glass to glass percentiles refresh, also one csv row each time
+#define GLASS_TO_GLASS_INTERVAL_MS 1000
+// headless host loop while no session is open
+#define HEADLESS_IDLE_INTERVAL_MS 200
+#define HEADLESS_RETRY_INTERVAL_MS 5000
+
 namespace crossdesk {
 
+namespace {
+
+// set from the signal handler, the headless loop polls it
+volatile std::sig_atomic_t headless_exit_requested = 0;
+
+void OnHeadlessSignal(int) { headless_exit_requested = 1; }
+
+}  // namespace
+
 std::vector<char> Render::SerializeRemoteAction(const RemoteAction& action) {
   std::vector<char> buffer;
   buffer.push_back(static_cast<char>(action.type));
@@ -256,21 +286,34 @@ int Render::LoadSettingsFromCacheFile() {
   video_frame_rate_button_value_ = (int)config_center_->GetVideoFrameRate();
   video_encode_format_button_value_ =
       (int)config_center_->GetVideoEncodeFormat();
+  audio_frame_duration_button_value_ = 0;
+  for (int i = 0; i < AudioConfig::kFrameDurationCount; i++) {
+    if (AudioConfig::kFrameDurations[i] ==
+        config_center_->GetAudioFrameDuration()) {
+      audio_frame_duration_button_value_ = i;
+    }
+  }
+  audio_channels_button_value_ = config_center_->GetAudioChannels() - 1;
   enable_hardware_video_codec_ = config_center_->IsHardwareVideoCodec();
   enable_turn_ = config_center_->IsEnableTurn();
   enable_srtp_ = config_center_->IsEnableSrtp();
   enable_self_hosted_ = config_center_->IsSelfHosted();
   enable_autostart_ = config_center_->IsEnableAutostart();
+  enable_local_cursor_prediction_ =
+      config_center_->IsEnableLocalCursorPrediction();
   enable_minimize_to_tray_ = config_center_->IsMinimizeToTray();
 
   language_button_value_last_ = language_button_value_;
   video_quality_button_value_last_ = video_quality_button_value_;
   video_encode_format_button_value_last_ = video_encode_format_button_value_;
+  audio_frame_duration_button_value_last_ = audio_frame_duration_button_value_;
+  audio_channels_button_value_last_ = audio_channels_button_value_;
   enable_hardware_video_codec_last_ = enable_hardware_video_codec_;
   enable_turn_last_ = enable_turn_;
   enable_srtp_last_ = enable_srtp_;
   enable_self_hosted_last_ = enable_self_hosted_;
   enable_autostart_last_ = enable_autostart_;
+  enable_local_cursor_prediction_last_ = enable_local_cursor_prediction_;
   enable_minimize_to_tray_last_ = enable_minimize_to_tray_;
 
   LOG_INFO("Load settings from cache file");
@@ -292,22 +335,42 @@ int Render::ScreenCapturerInit() {
                 : 60;
   LOG_INFO("Init screen capturer with {} fps", fps);
 
+  {
+    std::lock_guard<std::mutex> lock(quality_mutex_);
+    quality_controllers_.clear();
+    quality_max_fps_ = fps;
+    quality_level_ = 0;
+  }
+  capture_fps_ = fps;
+  capture_fps_metric_->Set(fps);
+  capture_scale_percent_ = 100;
+
+  // encode and network stalls stay on the sender thread
+  video_send_queue_.Start([this](VideoSendQueue::Frame& send_frame) {
+    XVideoFrame frame;
+    ScaleToActiveTier(send_frame, &frame);
+    frame.captured_timestamp = send_frame.captured_timestamp;
+    if (stamp_latency_markers_) {
+      // either the queued frame or the scaling scratch, both owned here
+      LatencyMarker::Stamp((uint8_t*)frame.data, frame.width, frame.height,
+                           send_frame.captured_timestamp);
+    }
+    ScopedMetricTimer send_timer(video_send_us_metric_);
+    TRACE_SCOPE("SendVideoFrame");
+    return SendVideoFrame(peer_, &frame, send_frame.stream_name.c_str());
+  });
+
   int screen_capturer_init_ret = screen_capturer_->Init(
       fps,
-      [this, fps](unsigned char* data, int size, int width, int height,
-                  const char* display_name) -> void {
+      [this](unsigned char* data, int size, int width, int height,
+             const char* display_name) -> void {
         auto now_time = std::chrono::duration_cast<std::chrono::milliseconds>(
                             std::chrono::steady_clock::now().time_since_epoch())
                             .count();
         auto duration = now_time - last_frame_time_;
-        if (duration * fps >= 1000) {  // ~60 FPS
-          XVideoFrame frame;
-          frame.data = (const char*)data;
-          frame.size = size;
-          frame.width = width;
-          frame.height = height;
-          frame.captured_timestamp = GetSystemTimeMicros(peer_);
-          SendVideoFrame(peer_, &frame, display_name);
+        if (duration * capture_fps_ >= 1000) {  // adaptive, at most ~60 FPS
+          video_send_queue_.Push(data, size, width, height,
+                                 GetSystemTimeMicros(peer_), display_name);
           last_frame_time_ = now_time;
         }
       });
@@ -320,6 +383,7 @@ int Render::ScreenCapturerInit() {
     return 0;
   } else {
     LOG_ERROR("Init screen capturer failed");
+    video_send_queue_.Stop();
     screen_capturer_->Destroy();
     delete screen_capturer_;
     screen_capturer_ = nullptr;
@@ -343,16 +407,260 @@ int Render::StopScreenCapturer() {
     screen_capturer_->Stop();
   }
 
+  VideoSendQueue::Stats send_stats = video_send_queue_.GetStats();
+  LOG_INFO(
+      "Video frames queued: {}, sent: {}, dropped: {}, queue latency avg: {} "
+      "us, max: {} us",
+      send_stats.enqueued, send_stats.sent, send_stats.dropped,
+      send_stats.avg_latency_us, send_stats.max_latency_us);
+
+  VideoTierSelector::Stats tier_stats = video_tier_selector_.GetStats();
+  LOG_INFO("Video tier: {}, viewers: {}, tier changes: {}",
+           VideoTierSelector::TierName(tier_stats.tier), tier_stats.viewers,
+           tier_stats.tier_changes);
+  LOG_INFO("Pipeline metrics:\n{}", MetricsRegistry::Global().Dump());
+
+  return 0;
+}
+
+int Render::ScaleToActiveTier(const VideoSendQueue::Frame& send_frame,
+                              XVideoFrame* frame) {
+  frame->data = (const char*)send_frame.data.data();
+  frame->size = send_frame.data.size();
+  frame->width = send_frame.width;
+  frame->height = send_frame.height;
+
+  uint64_t now_time =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count();
+  int width, height;
+  VideoTierSelector::ScaledSize(video_tier_selector_.Select(now_time),
+                                send_frame.width, send_frame.height, &width,
+                                &height);
+  int scale_percent = capture_scale_percent_;
+  if (scale_percent < 100) {
+    width = std::max(2, (width * scale_percent / 100) & ~1);
+    height = std::max(2, (height * scale_percent / 100) & ~1);
+  }
+  if (width == send_frame.width && height == send_frame.height) {
+    return 0;
+  }
+
+  // one conversion and one scale per frame, whatever the number of viewers
+  ScopedMetricTimer scale_timer(video_scale_us_metric_);
+  TRACE_SCOPE("ScaleToActiveTier");
+  int src_width = send_frame.width;
+  int src_height = send_frame.height;
+  int src_uv_width = (src_width + 1) / 2;
+  int src_uv_height = (src_height + 1) / 2;
+  size_t src_y_size = (size_t)src_width * src_height;
+  size_t src_uv_size = (size_t)src_uv_width * src_uv_height;
+  if (send_frame.data.size() < src_y_size + src_uv_size * 2) {
+    return -1;
+  }
+
+  int uv_width = width / 2;
+  int uv_height = height / 2;
+  size_t y_size = (size_t)width * height;
+  size_t uv_size = (size_t)uv_width * uv_height;
+  tier_i420_.resize(src_y_size + src_uv_size * 2);
+  tier_scaled_i420_.resize(y_size + uv_size * 2);
+  tier_nv12_.resize(y_size + uv_size * 2);
+
+  uint8_t* src_y = tier_i420_.data();
+  uint8_t* src_u = src_y + src_y_size;
+  uint8_t* src_v = src_u + src_uv_size;
+  libyuv::NV12ToI420(send_frame.data.data(), src_width,
+                     send_frame.data.data() + src_y_size, src_uv_width * 2,
+                     src_y, src_width, src_u, src_uv_width, src_v,
+                     src_uv_width, src_width, src_height);
+
+  uint8_t* dst_y = tier_scaled_i420_.data();
+  uint8_t* dst_u = dst_y + y_size;
+  uint8_t* dst_v = dst_u + uv_size;
+  libyuv::I420Scale(src_y, src_width, src_u, src_uv_width, src_v,
+                    src_uv_width, src_width, src_height, dst_y, width, dst_u,
+                    uv_width, dst_v, uv_width, width, height,
+                    libyuv::kFilterBilinear);
+
+  libyuv::I420ToNV12(dst_y, width, dst_u, uv_width, dst_v, uv_width,
+                     tier_nv12_.data(), width, tier_nv12_.data() + y_size,
+                     width, width, height);
+
+  frame->data = (const char*)tier_nv12_.data();
+  frame->size = tier_nv12_.size();
+  frame->width = width;
+  frame->height = height;
+  return 0;
+}
+
+void Render::SetLatencyMarkerViewer(const std::string& remote_id,
+                                    bool enable) {
+  std::lock_guard<std::mutex> lock(latency_marker_mutex_);
+  if (enable) {
+    latency_marker_viewers_.insert(remote_id);
+  } else {
+    latency_marker_viewers_.erase(remote_id);
+  }
+  stamp_latency_markers_ = !latency_marker_viewers_.empty();
+}
+
+bool Render::InjectRemoteInput(const std::string& remote_id,
+                               const RemoteAction& remote_action) {
+  bool is_move = remote_action.type == ControlType::mouse &&
+                 remote_action.m.flag == MouseFlag::move;
+  std::lock_guard<std::mutex> lock(remote_input_mutex_);
+  switch (input_filter_.Accept(remote_id, remote_action.seq, remote_action.ts,
+                               is_move, GetSystemTimeMicros(peer_))) {
+    case InputFilter::Verdict::DROP:
+      return false;
+    case InputFilter::Verdict::HOLD:
+      held_moves_[remote_id] = remote_action;
+      return false;
+    case InputFilter::Verdict::APPLY_HELD_FIRST: {
+      // a click or key lands where the pointer was meant to be
+      auto it = held_moves_.find(remote_id);
+      if (it != held_moves_.end()) {
+        ApplyRemoteInput(it->second);
+        held_moves_.erase(it);
+      }
+      break;
+    }
+    case InputFilter::Verdict::APPLY:
+      held_moves_.erase(remote_id);
+      break;
+  }
+  ApplyRemoteInput(remote_action);
+  return true;
+}
+
+void Render::ApplyRemoteInput(const RemoteAction& remote_action) {
+  if (remote_action.type == ControlType::mouse && mouse_controller_) {
+    mouse_controller_->SendMouseCommand(remote_action, selected_display_);
+  } else if (remote_action.type == ControlType::keyboard &&
+             keyboard_capturer_) {
+    keyboard_capturer_->SendKeyboardCommand(
+        (int)remote_action.k.key_value,
+        remote_action.k.flag == KeyFlag::key_down);
+  }
+}
+
+void Render::FlushHeldInput() {
+  std::lock_guard<std::mutex> lock(remote_input_mutex_);
+  if (held_moves_.empty()) {
+    return;
+  }
+  // nothing newer arrived, the last position of a stall still counts
+  uint64_t now_us = GetSystemTimeMicros(peer_);
+  for (auto it = held_moves_.begin(); it != held_moves_.end();) {
+    if (input_filter_.TakeHeldMove(it->first, now_us)) {
+      ApplyRemoteInput(it->second);
+      it = held_moves_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+int Render::UpdateQuality(const std::string& remote_id,
+                          const XNetTrafficStats& net_traffic_stats) {
+  VideoSendQueue::Stats send_stats = video_send_queue_.GetStats();
+  QualityController::Sample sample;
+  // minirtc reports no outbound loss, viewers send what their decoder saw
+  sample.bitrate = (uint64_t)net_traffic_stats.video_outbound_stats.bitrate;
+  sample.queue_depth = send_stats.depth;
+  sample.queue_max_depth = send_stats.max_depth;
+  sample.queue_dropped = send_stats.dropped;
+
+  uint64_t now_time =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count();
+
+  std::lock_guard<std::mutex> lock(quality_mutex_);
+  auto loss_it = viewer_video_loss_.find(remote_id);
+  if (loss_it != viewer_video_loss_.end()) {
+    sample.loss_rate = loss_it->second;
+  }
+
+  std::unique_ptr<QualityController>& controller =
+      quality_controllers_[remote_id];
+  if (!controller) {
+    controller = std::make_unique<QualityController>();
+    controller->Reset(quality_max_fps_);
+    controller->OpenTrace(exec_log_path_ + "/quality_trace_" + remote_id +
+                          ".jsonl");
+  }
+
+  QualityController::Decision decision = controller->Update(sample, now_time);
+  if (!decision.changed) {
+    return 0;
+  }
+  return ApplyQualityLevel(remote_id, decision.reason);
+}
+
+void Render::SetViewerVideoLoss(const std::string& remote_id,
+                                float loss_rate) {
+  std::lock_guard<std::mutex> lock(quality_mutex_);
+  viewer_video_loss_[remote_id] = std::clamp(loss_rate, 0.0f, 1.0f);
+}
+
+void Render::RemoveQualityViewer(const std::string& remote_id) {
+  std::lock_guard<std::mutex> lock(quality_mutex_);
+  viewer_video_loss_.erase(remote_id);
+  if (0 == quality_controllers_.erase(remote_id)) {
+    return;
+  }
+  // a congested viewer that left no longer holds the others down
+  ApplyQualityLevel(remote_id, "viewer_left");
+}
+
+int Render::ApplyQualityLevel(const std::string& remote_id,
+                              const char* reason) {
+  // every viewer gets the same rendition, so the worst link decides
+  int level = 0;
+  QualityController::Level settings{quality_max_fps_, 1.0f};
+  for (const auto& [_, controller] : quality_controllers_) {
+    if (controller->CurrentLevel() > level) {
+      level = controller->CurrentLevel();
+      settings = controller->Current();
+    }
+  }
+  if (level == quality_level_) {
+    return 0;
+  }
+
+  quality_level_ = level;
+  capture_fps_ = settings.fps;
+  capture_fps_metric_->Set(settings.fps);
+  capture_scale_percent_ = (int)(settings.scale * 100);
+  LOG_INFO("Quality level {} ([{}] {}): {} fps, scale {:.2f}", level,
+           remote_id, reason, settings.fps, settings.scale);
   return 0;
 }
 
 int Render::StartSpeakerCapturer() {
   if (!speaker_capturer_) {
     speaker_capturer_ = (SpeakerCapturer*)speaker_capturer_factory_->Create();
+    speaker_capturer_->SetAudioConfig(audio_config_);
     int speaker_capturer_init_ret =
         speaker_capturer_->Init([this](unsigned char* data, size_t size,
                                        const char* audio_name) -> void {
-          SendAudioFrame(peer_, (const char*)data, size, audio_label_.c_str());
+          if (silence_detector_.Process((const int16_t*)data,
+                                        size / sizeof(int16_t),
+                                        audio_config_.frame_duration_us)) {
+            // the callback fires once the whole frame is captured
+            uint64_t captured_timestamp = GetSystemTimeMicros(peer_) -
+                                          audio_config_.frame_duration_us;
+            last_comfort_noise_time_ = 0;
+            SendAudioFrame(peer_, (const char*)data, size,
+                           audio_label_.c_str());
+            SendAudioTimestamp(captured_timestamp);
+          } else {
+            last_audio_timestamp_time_ = 0;
+            SendComfortNoise();
+          }
         });
 
     if (0 != speaker_capturer_init_ret) {
@@ -373,9 +681,153 @@ int Render::StopSpeakerCapturer() {
     speaker_capturer_->Stop();
   }
 
+  SilenceDetector::Stats silence_stats = silence_detector_.GetStats();
+  LOG_INFO("Audio frames captured: {}, suppressed as silence: {}",
+           silence_stats.frames, silence_stats.silent_frames);
+  silence_detector_.Reset();
+  last_comfort_noise_time_ = 0;
+
   return 0;
 }
 
+int Render::SendAudioTimestamp(uint64_t captured_timestamp) {
+  // audio frames carry no timestamp, viewers sync on these markers
+  uint64_t now_time = SDL_GetTicks();
+  if (last_audio_timestamp_time_ != 0 &&
+      now_time - last_audio_timestamp_time_ < AUDIO_TIMESTAMP_INTERVAL_MS) {
+    return 0;
+  }
+
+  RemoteAction remote_action;
+  remote_action.type = ControlType::audio_timestamp;
+  remote_action.t = captured_timestamp;
+  std::string msg = remote_action.to_json();
+  int ret = data_mux_.Send(DataChannelMux::Priority::CONTROL, msg);
+  if (0 == ret) {
+    last_audio_timestamp_time_ = now_time;
+  }
+  return ret;
+}
+
+int Render::UpdateAvSync(std::shared_ptr<SubStreamWindowProperties>& props,
+                         uint64_t audio_captured_timestamp) {
+  if (!output_stream_ || props->video_delay_us_ <= 0) {
+    return -1;
+  }
+
+  uint64_t now_time = GetSystemTimeMicros(props->peer_);
+  if (now_time < audio_captured_timestamp) {
+    return -1;
+  }
+
+  // time until the newest audio is heard, transport, the peer's mixer input
+  // and the output queue
+  int queued = SDL_GetAudioStreamQueued(output_stream_);
+  int64_t playout_us =
+      (int64_t)audio_mixer_.QueuedMs(props->remote_id_) * 1000 +
+      (queued > 0 ? (int64_t)queued * 1000 / output_audio_config_.BytesPerMs()
+                  : 0);
+  props->audio_delay_us_ =
+      (int64_t)(now_time - audio_captured_timestamp) + playout_us;
+
+  // positive when audio is heard before the matching video is shown
+  props->av_offset_ms_ =
+      (int)((props->video_delay_us_ - props->audio_delay_us_) / 1000);
+
+  // video is shown on arrival, so only audio can be held back to meet it
+  if (std::abs(props->av_offset_ms_) > AV_SYNC_TOLERANCE_MS) {
+    props->audio_extra_delay_ms_ =
+        std::clamp(props->audio_extra_delay_ms_ + props->av_offset_ms_ / 2, 0,
+                   AV_SYNC_MAX_AUDIO_DELAY_MS);
+    audio_mixer_.SetExtraDelay(props->remote_id_,
+                               props->audio_extra_delay_ms_);
+  }
+
+  return 0;
+}
+
+int Render::SendComfortNoise() {
+  // a marker on entering silence, then a low rate refresh
+  uint64_t now_time = SDL_GetTicks();
+  if (last_comfort_noise_time_ != 0 &&
+      now_time - last_comfort_noise_time_ < COMFORT_NOISE_INTERVAL_MS) {
+    return 0;
+  }
+
+  RemoteAction remote_action;
+  remote_action.type = ControlType::comfort_noise;
+  remote_action.d = (int)silence_detector_.LevelDb();
+  std::string msg = remote_action.to_json();
+  int ret = data_mux_.Send(DataChannelMux::Priority::CONTROL, msg);
+  if (0 == ret) {
+    last_comfort_noise_time_ = now_time;
+  }
+  return ret;
+}
+
+void Render::SetViewerAudioConfig(const std::string& remote_id,
+                                  const AudioConfig& audio_config) {
+  {
+    std::lock_guard<std::mutex> lock(viewer_audio_configs_mutex_);
+    viewer_audio_configs_[remote_id] = audio_config;
+  }
+  need_to_apply_audio_config_ = true;
+}
+
+void Render::RemoveViewerAudioConfig(const std::string& remote_id) {
+  {
+    std::lock_guard<std::mutex> lock(viewer_audio_configs_mutex_);
+    if (0 == viewer_audio_configs_.erase(remote_id)) {
+      return;
+    }
+  }
+  need_to_apply_audio_config_ = true;
+}
+
+int Render::ApplyAudioConfig() {
+  AudioConfig audio_config(config_center_->GetAudioFrameDuration(),
+                           config_center_->GetAudioChannels());
+  size_t viewer_count = 0;
+  {
+    // every viewer shares the capture, so it has to suit all of them
+    std::lock_guard<std::mutex> lock(viewer_audio_configs_mutex_);
+    for (const auto& viewer_audio_config : viewer_audio_configs_) {
+      audio_config =
+          AudioConfig::Negotiate(audio_config, viewer_audio_config.second);
+    }
+    viewer_count = viewer_audio_configs_.size();
+  }
+
+  if (audio_config != audio_config_) {
+    LOG_INFO("Audio config changed to [{} us, {} channels]",
+             audio_config.frame_duration_us, audio_config.channels);
+    audio_config_ = audio_config;
+
+    // the frame layout is fixed at init, recreate the capturer
+    if (speaker_capturer_) {
+      speaker_capturer_->Stop();
+      speaker_capturer_->Destroy();
+      delete speaker_capturer_;
+      speaker_capturer_ = nullptr;
+
+      if (speaker_capturer_is_started_) {
+        StartSpeakerCapturer();
+      }
+    }
+  }
+
+  if (0 == viewer_count) {
+    return 0;
+  }
+
+  RemoteAction remote_action;
+  remote_action.type = ControlType::audio_config;
+  remote_action.p.frame_duration_us = audio_config_.frame_duration_us;
+  remote_action.p.channels = audio_config_.channels;
+  std::string msg = remote_action.to_json();
+  return data_mux_.Send(DataChannelMux::Priority::CONTROL, msg);
+}
+
 int Render::StartMouseController() {
   if (!device_controller_factory_) {
     LOG_INFO("Device controller factory is nullptr");
@@ -436,6 +888,8 @@ int Render::StopKeyboardCapturer() {
 
 int Render::CreateConnectionPeer() {
   params_.use_cfg_file = false;
+  audio_config_ = AudioConfig(config_center_->GetAudioFrameDuration(),
+                              config_center_->GetAudioChannels());
 
   std::string signal_server_ip;
   int signal_server_port;
@@ -515,6 +969,21 @@ int Render::CreateConnectionPeer() {
 
   params_.user_id = client_id_with_password_;
   params_.user_data = this;
+  data_mux_.SetSender([this](const char* data, size_t size) {
+    if (!peer_) {
+      return -1;
+    }
+    return SendDataFrame(peer_, data, size, data_label_.c_str());
+  });
+  file_transfer_.SetSender([this](const char* data, size_t size) {
+    if (!peer_) {
+      return -1;
+    }
+    return SendDataFrame(peer_, data, size, file_label_.c_str());
+  });
+  file_transfer_.SetSaveDirectory(cache_path_ + "/received_files");
+  // viewers already drive this desktop, they may fetch files from it
+  file_transfer_.SetServeRequests(true);
 
   peer_ = CreatePeer(&params_);
   if (peer_) {
@@ -532,6 +1001,7 @@ int Render::CreateConnectionPeer() {
 
     AddAudioStream(peer_, audio_label_.c_str());
     AddDataStream(peer_, data_label_.c_str());
+    AddDataStream(peer_, file_label_.c_str());
     return 0;
   } else {
     return -1;
@@ -539,10 +1009,13 @@ int Render::CreateConnectionPeer() {
 }
 
 int Render::AudioDeviceInit() {
+  output_audio_config_ = AudioConfig(config_center_->GetAudioFrameDuration(),
+                                     config_center_->GetAudioChannels());
+
   SDL_AudioSpec desired_out{};
-  desired_out.freq = 48000;
+  desired_out.freq = AudioConfig::kSampleRate;
   desired_out.format = SDL_AUDIO_S16;
-  desired_out.channels = 1;
+  desired_out.channels = output_audio_config_.channels;
 
   output_stream_ = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK,
                                              &desired_out, nullptr, nullptr);
@@ -551,6 +1024,9 @@ int Render::AudioDeviceInit() {
     return -1;
   }
 
+  audio_mixer_.SetOutputConfig(output_audio_config_);
+  SDL_SetAudioStreamGetCallback(output_stream_, OnAudioStreamGetCb, this);
+
   SDL_ResumeAudioDevice(SDL_GetAudioStreamDevice(output_stream_));
 
   return 0;
@@ -566,6 +1042,12 @@ int Render::AudioDeviceDestroy() {
 }
 
 void Render::UpdateInteractions() {
+  if (need_to_apply_audio_config_.exchange(false)) {
+    ApplyAudioConfig();
+  }
+
+  FlushHeldInput();
+
   if (start_screen_capturer_ && !screen_capturer_is_started_) {
     StartScreenCapturer();
     screen_capturer_is_started_ = true;
@@ -602,7 +1084,7 @@ void Render::UpdateInteractions() {
 }
 
 int Render::CreateMainWindow() {
-  main_ctx_ = ImGui::CreateContext();
+  main_ctx_ = ImGui::CreateContext(glyph_atlas_.Atlas());
   if (!main_ctx_) {
     LOG_ERROR("Main context is null");
     return -1;
@@ -661,7 +1143,7 @@ int Render::CreateStreamWindow() {
     return 0;
   }
 
-  stream_ctx_ = ImGui::CreateContext();
+  stream_ctx_ = ImGui::CreateContext(glyph_atlas_.Atlas());
   if (!stream_ctx_) {
     LOG_ERROR("Stream context is null");
     return -1;
@@ -725,17 +1207,14 @@ int Render::SetupFontAndStyle() {
 
   io.IniFilename = NULL;  // disable imgui.ini
 
-  // Load Fonts
-  ImFontConfig config;
-  config.FontDataOwnedByAtlas = false;
-  io.Fonts->AddFontFromMemoryTTF(OPPOSans_Regular_ttf, OPPOSans_Regular_ttf_len,
-                                 32.0f, &config,
-                                 io.Fonts->GetGlyphRangesChineseFull());
-  config.MergeMode = true;
-  static const ImWchar icon_ranges[] = {ICON_MIN_FA, ICON_MAX_FA, 0};
-  io.Fonts->AddFontFromMemoryTTF(fa_solid_900_ttf, fa_solid_900_ttf_len, 30.0f,
-                                 &config, icon_ranges);
-  io.Fonts->Build();
+  // the shared atlas is built from these before the next frame, or loaded
+  // from the cache when it already holds them
+  glyph_atlas_.SetCacheFile(cache_path_ + "/font_atlas.cache");
+  for (const auto* strings : localization::all_strings) {
+    for (const auto& text : *strings) {
+      glyph_atlas_.AddText(text);
+    }
+  }
   ImGui::StyleColorsLight();
 
   return 0;
@@ -817,10 +1296,30 @@ int Render::DestroyStreamWindowContext() {
   ImGui_ImplSDLRenderer3_Shutdown();
   ImGui_ImplSDL3_Shutdown();
   ImGui::DestroyContext(stream_ctx_);
+  stream_font_texture_ = 0;
 
   return 0;
 }
 
+int Render::UpdateFontAtlas() {
+  if (!glyph_atlas_.Update()) {
+    return 0;
+  }
+
+  // textures of the old atlas, each renderer uploads again on its next frame
+  if (main_ctx_) {
+    ImGui::SetCurrentContext(main_ctx_);
+    ImGui_ImplSDLRenderer3_DestroyFontsTexture();
+    main_font_texture_ = 0;
+  }
+  if (stream_window_inited_ && stream_ctx_) {
+    ImGui::SetCurrentContext(stream_ctx_);
+    ImGui_ImplSDLRenderer3_DestroyFontsTexture();
+    stream_font_texture_ = 0;
+  }
+  return 0;
+}
+
 int Render::DrawMainWindow() {
   if (!main_ctx_) {
     LOG_ERROR("Main context is null");
@@ -828,7 +1327,10 @@ int Render::DrawMainWindow() {
   }
 
   ImGui::SetCurrentContext(main_ctx_);
+  // the atlas is shared but each renderer uploads its own font texture
+  ImGui::GetIO().Fonts->SetTexID(main_font_texture_);
   ImGui_ImplSDLRenderer3_NewFrame();
+  main_font_texture_ = ImGui::GetIO().Fonts->TexID;
   ImGui_ImplSDL3_NewFrame();
   ImGui::NewFrame();
 
@@ -847,6 +1349,12 @@ int Render::DrawMainWindow() {
 
   MainWindow();
 
+  // both contexts drive the same OS cursor, keep it hidden while the stream
+  // window draws the predicted one
+  if (hide_os_cursor_) {
+    ImGui::SetMouseCursor(ImGuiMouseCursor_None);
+  }
+
   ImGui::End();
 
   // Rendering
@@ -855,17 +1363,28 @@ int Render::DrawMainWindow() {
   ImGui_ImplSDLRenderer3_RenderDrawData(ImGui::GetDrawData(), main_renderer_);
   SDL_RenderPresent(main_renderer_);
 
+  if (!first_frame_presented_) {
+    first_frame_presented_ = true;
+    LOG_INFO("First frame presented [{}] ms after start",
+             std::chrono::duration_cast<std::chrono::milliseconds>(
+                 std::chrono::steady_clock::now() - run_start_time_)
+                 .count());
+  }
+
   return 0;
 }
 
 int Render::DrawStreamWindow() {
+  TRACE_SCOPE("DrawStreamWindow");
   if (!stream_ctx_) {
     LOG_ERROR("Stream context is null");
     return -1;
   }
 
   ImGui::SetCurrentContext(stream_ctx_);
+  ImGui::GetIO().Fonts->SetTexID(stream_font_texture_);
   ImGui_ImplSDLRenderer3_NewFrame();
+  stream_font_texture_ = ImGui::GetIO().Fonts->TexID;
   ImGui_ImplSDL3_NewFrame();
   ImGui::NewFrame();
 
@@ -889,6 +1408,13 @@ int Render::DrawStreamWindow() {
     ImGui::End();
   }
 
+  hide_os_cursor_ = false;
+  for (auto& it : client_properties_) {
+    if (it.second->tab_selected_) {
+      DrawPredictedCursor(it.second);
+    }
+  }
+
   // Rendering
   ImGui::Render();
   SDL_RenderClear(stream_renderer_);
@@ -911,10 +1437,129 @@ int Render::DrawStreamWindow() {
   return 0;
 }
 
+static ImGuiMouseCursor ToImGuiMouseCursor(CursorType type) {
+  switch (type) {
+    case CursorType::TEXT:
+      return ImGuiMouseCursor_TextInput;
+    case CursorType::HAND:
+      return ImGuiMouseCursor_Hand;
+    case CursorType::RESIZE_EW:
+      return ImGuiMouseCursor_ResizeEW;
+    case CursorType::RESIZE_NS:
+      return ImGuiMouseCursor_ResizeNS;
+    case CursorType::RESIZE_NESW:
+      return ImGuiMouseCursor_ResizeNESW;
+    case CursorType::RESIZE_NWSE:
+      return ImGuiMouseCursor_ResizeNWSE;
+    case CursorType::RESIZE_ALL:
+      return ImGuiMouseCursor_ResizeAll;
+    case CursorType::NOT_ALLOWED:
+      return ImGuiMouseCursor_NotAllowed;
+    default:
+      return ImGuiMouseCursor_Arrow;
+  }
+}
+
+void Render::DrawPredictedCursor(
+    std::shared_ptr<SubStreamWindowProperties>& props) {
+  if (!props->local_cursor_prediction_ || !props->control_mouse_ ||
+      !props->connection_established_ || !props->streaming_) {
+    return;
+  }
+
+  if (props->control_bar_hovered_ || props->display_selectable_hovered_) {
+    return;
+  }
+
+  float mouse_x = 0;
+  float mouse_y = 0;
+  SDL_GetMouseState(&mouse_x, &mouse_y);
+  const SDL_Rect& rect = props->stream_render_rect_;
+  if (mouse_x < rect.x || mouse_x > rect.x + rect.w || mouse_y < rect.y ||
+      mouse_y > rect.y + rect.h) {
+    return;
+  }
+
+  // the local pointer is where the host cursor is going to be, draw it there
+  // right away and fall back to the reported position when the pointer rests
+  ImVec2 cursor_pos(mouse_x, mouse_y);
+  if (props->remote_cursor_received_ &&
+      SDL_GetTicks() - props->last_local_cursor_move_time_ >
+          CURSOR_RECONCILE_MS) {
+    cursor_pos = ImVec2(rect.x + props->remote_cursor_x_ * rect.w,
+                        rect.y + props->remote_cursor_y_ * rect.h);
+  }
+
+  hide_os_cursor_ = true;
+  ImGui::SetMouseCursor(ImGuiMouseCursor_None);
+
+  CursorType cursor_type = static_cast<CursorType>(props->remote_cursor_type_);
+  if (cursor_type == CursorType::HIDDEN) {
+    return;
+  }
+
+  ImGui::RenderMouseCursor(cursor_pos, 1.0f, ToImGuiMouseCursor(cursor_type),
+                           IM_COL32_WHITE, IM_COL32_BLACK,
+                           IM_COL32(0, 0, 0, 48));
+}
+
 int Render::Run() {
-  latest_version_ = CheckUpdate();
-  update_available_ = IsNewerVersion(CROSSDESK_VERSION, latest_version_);
+  run_start_time_ = std::chrono::steady_clock::now();
+
+  if (0 != InitializePaths()) {
+    return -1;
+  }
+
+  InitializeLogger();
+  InitializeSettings();
+
+  // the ui picks the result up whenever it arrives, offline hosts start as
+  // fast as connected ones
+  std::string update_cache_file = cache_path_ + "/version.json";
+  auto update_promise = std::make_shared<std::promise<UpdateInfo>>();
+  update_check_ = update_promise->get_future();
+  update_check_abandoned_ = std::make_shared<std::atomic<bool>>(false);
+  std::thread([update_promise, update_cache_file,
+               abandoned = update_check_abandoned_]() {
+    update_promise->set_value(CheckUpdate(update_cache_file, abandoned));
+  }).detach();
+
+  InitializeSDL();
+  InitializeModules();
+  InitializeMainWindow();
+
+  const int scaled_video_width_ = 160;
+  const int scaled_video_height_ = 90;
+
+  MainLoop();
+
+  Cleanup();
+
+  return 0;
+}
+
+int Render::RunHeadless() {
+  headless_ = true;
+  if (0 != InitializePaths()) {
+    return -1;
+  }
+
+  InitializeLogger();
+  InitializeSettings();
+  InitializeModules();
+  LOG_INFO("Run as headless host");
+
+  std::signal(SIGINT, OnHeadlessSignal);
+  std::signal(SIGTERM, OnHeadlessSignal);
+
+  HeadlessLoop();
+
+  Cleanup();
+
+  return 0;
+}
 
+int Render::InitializePaths() {
   path_manager_ = std::make_unique<PathManager>("CrossDesk");
   if (path_manager_) {
     cert_path_ =
@@ -939,19 +1584,6 @@ int Render::Run() {
     return -1;
   }
 
-  InitializeLogger();
-  InitializeSettings();
-  InitializeSDL();
-  InitializeModules();
-  InitializeMainWindow();
-
-  const int scaled_video_width_ = 160;
-  const int scaled_video_height_ = 90;
-
-  MainLoop();
-
-  Cleanup();
-
   return 0;
 }
 
@@ -991,13 +1623,24 @@ void Render::InitializeSDL() {
 
 void Render::InitializeModules() {
   if (!modules_inited_) {
-    AudioDeviceInit();
+    // a headless host never plays remote audio
+    if (!headless_) {
+      AudioDeviceInit();
+    }
     screen_capturer_factory_ = new ScreenCapturerFactory();
     speaker_capturer_factory_ = new SpeakerCapturerFactory();
     device_controller_factory_ = new DeviceControllerFactory();
+    // also injects the viewer's keys on the host, only the local hook
+    // waits for a focused stream window
     keyboard_capturer_ = (KeyboardCapturer*)device_controller_factory_->Create(
         DeviceControllerFactory::Device::Keyboard);
     CreateConnectionPeer();
+    if (config_center_->IsEnableMetricsServer()) {
+      metrics_server_.Start(config_center_->GetMetricsServerPort());
+    }
+#ifdef CROSSDESK_TRACE
+    TraceRecorder::Global().SetEnabled(config_center_->IsEnableTrace());
+#endif
     modules_inited_ = true;
   }
 }
@@ -1011,6 +1654,7 @@ void Render::InitializeMainWindow() {
 }
 
 void Render::MainLoop() {
+  TRACE_THREAD("ui");
   while (!exit_) {
     if (!peer_) {
       CreateConnectionPeer();
@@ -1032,7 +1676,9 @@ void Render::MainLoop() {
     UpdateLabels();
     HandleRecentConnections();
     HandleStreamWindow();
+    HandleUpdateCheck();
 
+    UpdateFontAtlas();
     DrawMainWindow();
     if (stream_window_inited_) {
       DrawStreamWindow();
@@ -1041,48 +1687,311 @@ void Render::MainLoop() {
     UpdateInteractions();
 
     if (need_to_send_host_info_) {
-      RemoteAction remote_action;
-      remote_action.i.display_num = display_info_list_.size();
-      remote_action.i.display_list =
-          (char**)malloc(remote_action.i.display_num * sizeof(char*));
-      remote_action.i.left =
-          (int*)malloc(remote_action.i.display_num * sizeof(int));
-      remote_action.i.top =
-          (int*)malloc(remote_action.i.display_num * sizeof(int));
-      remote_action.i.right =
-          (int*)malloc(remote_action.i.display_num * sizeof(int));
-      remote_action.i.bottom =
-          (int*)malloc(remote_action.i.display_num * sizeof(int));
-      for (int i = 0; i < remote_action.i.display_num; i++) {
-        LOG_INFO("Local display [{}:{}]", i + 1, display_info_list_[i].name);
-        remote_action.i.display_list[i] =
-            (char*)malloc(display_info_list_[i].name.length() + 1);
-        strncpy(remote_action.i.display_list[i],
-                display_info_list_[i].name.c_str(),
-                display_info_list_[i].name.length());
-        remote_action.i.display_list[i][display_info_list_[i].name.length()] =
-            '\0';
-        remote_action.i.left[i] = display_info_list_[i].left;
-        remote_action.i.top[i] = display_info_list_[i].top;
-        remote_action.i.right[i] = display_info_list_[i].right;
-        remote_action.i.bottom[i] = display_info_list_[i].bottom;
+      SendHostInfo();
+    }
+
+    for (auto& [_, props] : client_properties_) {
+      if (props->need_to_send_audio_config_ && props->connection_established_) {
+        SendAudioConfig(props);
       }
+      if (props->connection_established_) {
+        SendVideoSize(props);
+      }
+      if (props->need_to_send_latency_marker_ &&
+          props->connection_established_) {
+        SendLatencyMarker(props);
+      }
+      int video_loss_permille = props->video_loss_permille_.exchange(-1);
+      if (video_loss_permille >= 0 && props->connection_established_) {
+        SendVideoLoss(props, video_loss_permille);
+      }
+      props->data_mux_.Pump();
+      props->file_transfer_.Pump();
+    }
+    data_mux_.Pump();
+    file_transfer_.Pump();
+
+    if (screen_capturer_is_started_ && !connection_status_.empty()) {
+      SendCursorInfo();
+    }
+  }
+}
+
+void Render::HeadlessLoop() {
+  uint64_t last_peer_time = SDL_GetTicks();
+  std::string announced_id;
+  while (!exit_ && !headless_exit_requested) {
+    // the signal server may be unreachable, do not spin on peer creation
+    if (!peer_ &&
+        SDL_GetTicks() - last_peer_time >= HEADLESS_RETRY_INTERVAL_MS) {
+      last_peer_time = SDL_GetTicks();
+      CreateConnectionPeer();
+    }
+
+#if _WIN32
+    MSG msg;
+    while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+      TranslateMessage(&msg);
+      DispatchMessage(&msg);
+    }
+#endif
+
+    // nobody sees the main window, the log is where the id shows up. the
+    // password stays in the settings, logs get copied around
+    if (client_id_[0] != '\0' && announced_id != client_id_) {
+      announced_id = client_id_;
+      LOG_INFO("CrossDesk host id: {}", client_id_);
+    }
+
+    UpdateInteractions();
+
+    if (need_to_send_host_info_) {
+      SendHostInfo();
+    }
+
+    data_mux_.Pump();
+    file_transfer_.Pump();
+
+    if (screen_capturer_is_started_ && !connection_status_.empty()) {
+      SendCursorInfo();
+    }
+
+    // sessions need the data channel pumped, an idle host only waits
+    std::this_thread::sleep_for(std::chrono::milliseconds(
+        connection_status_.empty() ? HEADLESS_IDLE_INTERVAL_MS
+                                   : sdl_refresh_ms_));
+  }
+}
+
+int Render::SendHostInfo() {
+  RemoteAction remote_action;
+  remote_action.i.display_num = display_info_list_.size();
+  remote_action.i.display_list =
+      (char**)malloc(remote_action.i.display_num * sizeof(char*));
+  remote_action.i.left =
+      (int*)malloc(remote_action.i.display_num * sizeof(int));
+  remote_action.i.top =
+      (int*)malloc(remote_action.i.display_num * sizeof(int));
+  remote_action.i.right =
+      (int*)malloc(remote_action.i.display_num * sizeof(int));
+  remote_action.i.bottom =
+      (int*)malloc(remote_action.i.display_num * sizeof(int));
+  for (int i = 0; i < remote_action.i.display_num; i++) {
+    LOG_INFO("Local display [{}:{}]", i + 1, display_info_list_[i].name);
+    remote_action.i.display_list[i] =
+        (char*)malloc(display_info_list_[i].name.length() + 1);
+    strncpy(remote_action.i.display_list[i],
+            display_info_list_[i].name.c_str(),
+            display_info_list_[i].name.length());
+    remote_action.i.display_list[i][display_info_list_[i].name.length()] =
+        '\0';
+    remote_action.i.left[i] = display_info_list_[i].left;
+    remote_action.i.top[i] = display_info_list_[i].top;
+    remote_action.i.right[i] = display_info_list_[i].right;
+    remote_action.i.bottom[i] = display_info_list_[i].bottom;
+  }
+
+  std::string host_name = GetHostName();
+  remote_action.type = ControlType::host_infomation;
+  memcpy(&remote_action.i.host_name, host_name.data(), host_name.size());
+  remote_action.i.host_name[host_name.size()] = '\0';
+  remote_action.i.host_name_size = host_name.size();
+
+  // display lists can be large, keep them behind input
+  std::string msg = remote_action.to_json();
+  int ret = data_mux_.Send(DataChannelMux::Priority::BULK, msg);
+  FreeRemoteAction(remote_action);
+  if (0 == ret) {
+    need_to_send_host_info_ = false;
+  }
+  return ret;
+}
+
+int Render::SendAudioConfig(std::shared_ptr<SubStreamWindowProperties>& props) {
+  RemoteAction remote_action;
+  remote_action.type = ControlType::audio_config;
+  remote_action.p.frame_duration_us = config_center_->GetAudioFrameDuration();
+  remote_action.p.channels = config_center_->GetAudioChannels();
+  std::string msg = remote_action.to_json();
+
+  int ret = props->data_mux_.Send(DataChannelMux::Priority::CONTROL, msg);
+  if (0 == ret) {
+    props->need_to_send_audio_config_ = false;
+  }
+  return ret;
+}
+
+int Render::SendVideoSize(std::shared_ptr<SubStreamWindowProperties>& props) {
+  float pixel_density =
+      stream_window_ ? SDL_GetWindowPixelDensity(stream_window_) : 1.0f;
+  if (pixel_density <= 0.0f) {
+    pixel_density = 1.0f;
+  }
+  int width = (int)(props->render_window_width_ * pixel_density);
+  int height = (int)(props->render_window_height_ * pixel_density);
+  if (width <= 0 || height <= 0 || (width == props->sent_video_width_ &&
+                                    height == props->sent_video_height_)) {
+    return 0;
+  }
+
+  uint64_t now_time =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count();
+  if (now_time - props->last_video_size_send_time_ < VIDEO_SIZE_INTERVAL_MS) {
+    return 0;
+  }
+
+  RemoteAction remote_action;
+  remote_action.type = ControlType::video_size;
+  remote_action.v.width = width;
+  remote_action.v.height = height;
+  std::string msg = remote_action.to_json();
+
+  int ret = props->data_mux_.Send(DataChannelMux::Priority::CONTROL, msg);
+  props->last_video_size_send_time_ = now_time;
+  if (0 == ret) {
+    props->sent_video_width_ = width;
+    props->sent_video_height_ = height;
+  }
+  return ret;
+}
+
+int Render::SendLatencyMarker(
+    std::shared_ptr<SubStreamWindowProperties>& props) {
+  RemoteAction remote_action;
+  remote_action.type = ControlType::latency_marker;
+  remote_action.a = props->latency_markers_;
+  std::string msg = remote_action.to_json();
+
+  int ret = props->data_mux_.Send(DataChannelMux::Priority::CONTROL, msg);
+  if (0 == ret) {
+    props->need_to_send_latency_marker_ = false;
+  }
+  return ret;
+}
+
+int Render::SendVideoLoss(std::shared_ptr<SubStreamWindowProperties>& props,
+                          int loss_permille) {
+  RemoteAction remote_action;
+  remote_action.type = ControlType::video_loss;
+  remote_action.d = loss_permille;
+  std::string msg = remote_action.to_json();
+  return props->data_mux_.Send(DataChannelMux::Priority::CONTROL, msg);
+}
+
+int Render::UpdateGlassToGlassLatency(SubStreamWindowProperties* props) {
+  // read back right after the upload, the present follows in this frame
+  uint64_t now_us = GetSystemTimeMicros(props->peer_);
+  uint64_t captured_us = 0;
+  if (!LatencyMarker::Detect(props->dst_buffer_, props->video_width_,
+                             props->video_height_, now_us, &captured_us)) {
+    return -1;
+  }
+  // the same frame can be uploaded again before a new one arrives
+  if (captured_us == props->last_marker_timestamp_ || captured_us > now_us) {
+    return 0;
+  }
+  props->last_marker_timestamp_ = captured_us;
+  props->glass_to_glass_.Add(now_us - captured_us);
 
-      std::string host_name = GetHostName();
-      remote_action.type = ControlType::host_infomation;
-      memcpy(&remote_action.i.host_name, host_name.data(), host_name.size());
-      remote_action.i.host_name[host_name.size()] = '\0';
-      remote_action.i.host_name_size = host_name.size();
-
-      std::string msg = remote_action.to_json();
-      int ret =
-          SendDataFrame(peer_, msg.data(), msg.size(), data_label_.c_str());
-      FreeRemoteAction(remote_action);
-      if (0 == ret) {
-        need_to_send_host_info_ = false;
+  uint64_t now_time = SDL_GetTicks();
+  if (now_time - props->last_glass_to_glass_update_time_ <
+      GLASS_TO_GLASS_INTERVAL_MS) {
+    return 0;
+  }
+  props->last_glass_to_glass_update_time_ = now_time;
+  props->glass_to_glass_percentiles_ = props->glass_to_glass_.Get();
+
+  if (config_center_->IsEnableLatencyCsv()) {
+    if (!props->latency_csv_.is_open()) {
+      std::string path =
+          exec_log_path_ + "/latency_" + props->remote_id_ + ".csv";
+      props->latency_csv_.open(path, std::ios::out | std::ios::app);
+      if (!props->latency_csv_.is_open()) {
+        LOG_WARN("Open latency csv [{}] failed", path);
+        return -1;
       }
+      props->latency_csv_ << "time_us,samples,p50_us,p95_us,p99_us\n";
     }
+    const LatencyWindow::Percentiles& p = props->glass_to_glass_percentiles_;
+    props->latency_csv_ << now_us << "," << p.count << "," << p.p50_us << ","
+                        << p.p95_us << "," << p.p99_us << "\n";
+    props->latency_csv_.flush();
+  }
+  return 0;
+}
+
+int Render::DumpMetrics() {
+  std::string metrics = MetricsRegistry::Global().Dump();
+  std::string path = exec_log_path_ + "/metrics.txt";
+  std::ofstream metrics_file(path, std::ios::out | std::ios::trunc);
+  if (!metrics_file) {
+    LOG_WARN("Open metrics file [{}] failed", path);
+    return -1;
   }
+  metrics_file << metrics;
+  LOG_INFO("Metrics written to [{}]", path);
+  return 0;
+}
+
+int Render::DumpTrace() {
+  std::string path = exec_log_path_ + "/trace_" +
+                     std::to_string((long long)std::time(nullptr)) + ".json";
+  if (TraceRecorder::Global().Dump(path) != 0) {
+    LOG_WARN("Write trace [{}] failed", path);
+    return -1;
+  }
+  LOG_INFO("Trace written to [{}]", path);
+  return 0;
+}
+
+int Render::SendCursorInfo() {
+  if (!screen_capturer_ || !peer_) {
+    return -1;
+  }
+
+  CursorInfo cursor_info;
+  if (0 != screen_capturer_->GetCursorInfo(cursor_info)) {
+    return -1;
+  }
+
+  uint64_t now_time = SDL_GetTicks();
+  if (cursor_info_sent_ && cursor_info.type == last_sent_cursor_info_.type) {
+    if (cursor_info.x == last_sent_cursor_info_.x &&
+        cursor_info.y == last_sent_cursor_info_.y) {
+      return 0;
+    }
+    if (now_time - last_cursor_info_send_time_ < CURSOR_INFO_INTERVAL_MS) {
+      return 0;
+    }
+  }
+
+  if (selected_display_ < 0 ||
+      selected_display_ >= (int)display_info_list_.size()) {
+    return -1;
+  }
+
+  const DisplayInfo& display = display_info_list_[selected_display_];
+  if (display.width <= 0 || display.height <= 0) {
+    return -1;
+  }
+
+  RemoteAction remote_action;
+  remote_action.type = ControlType::cursor_info;
+  remote_action.c.x = (float)(cursor_info.x - display.left) / display.width;
+  remote_action.c.y = (float)(cursor_info.y - display.top) / display.height;
+  remote_action.c.type = (int)cursor_info.type;
+
+  std::string msg = remote_action.to_json();
+  int ret = data_mux_.Send(DataChannelMux::Priority::CONTROL, msg);
+  if (0 == ret) {
+    last_sent_cursor_info_ = cursor_info;
+    last_cursor_info_send_time_ = now_time;
+    cursor_info_sent_ = true;
+  }
+
+  return ret;
 }
 
 void Render::UpdateLabels() {
@@ -1130,12 +2039,60 @@ void Render::HandleStreamWindow() {
   }
 }
 
+void Render::HandleUpdateCheck() {
+  if (!update_check_.valid() ||
+      update_check_.wait_for(std::chrono::seconds(0)) !=
+          std::future_status::ready) {
+    return;
+  }
+
+  UpdateInfo latest = update_check_.get();
+  switch (latest.source) {
+    case UpdateInfo::Source::CACHE:
+      LOG_INFO("Latest version [{}] from update cache", latest.version);
+      break;
+    case UpdateInfo::Source::SERVER:
+      LOG_INFO("Latest version [{}] from update server", latest.version);
+      break;
+    case UpdateInfo::Source::EXPIRED_CACHE:
+      LOG_INFO("Update check failed, use cached version [{}]",
+               latest.version);
+      break;
+    default:
+      LOG_INFO("Update check failed");
+      return;
+  }
+  if (latest.cache_write_failed) {
+    LOG_WARN("Write update cache [{}/version.json] failed", cache_path_);
+  }
+
+  latest_version_ = latest.version;
+  update_available_ = IsNewerVersion(CROSSDESK_VERSION, latest);
+  if (update_available_) {
+    LOG_INFO("New version [{}] available", latest_version_);
+  }
+}
+
 void Render::Cleanup() {
+  if (update_check_abandoned_) {
+    update_check_abandoned_->store(true);
+  }
   if (screen_capturer_) {
     screen_capturer_->Destroy();
     delete screen_capturer_;
     screen_capturer_ = nullptr;
   }
+  video_send_queue_.Stop();
+  {
+    std::lock_guard<std::mutex> lock(quality_mutex_);
+    quality_controllers_.clear();
+  }
+  metrics_server_.Stop();
+#ifdef CROSSDESK_TRACE
+  if (TraceRecorder::Global().IsEnabled()) {
+    DumpTrace();
+  }
+#endif
 
   if (speaker_capturer_) {
     speaker_capturer_->Destroy();
@@ -1156,8 +2113,13 @@ void Render::Cleanup() {
 
   CleanupFactories();
   CleanupPeers();
-  AudioDeviceDestroy();
-  DestroyMainWindowContext();
+  // headless never opened the playback device
+  if (!headless_) {
+    AudioDeviceDestroy();
+  }
+  if (main_ctx_) {
+    DestroyMainWindowContext();
+  }
   DestroyMainWindow();
   SDL_Quit();
 }
@@ -1380,6 +2342,40 @@ void Render::ProcessSdlEvent(const SDL_Event& event) {
       }
       break;
 
+    case SDL_EVENT_TEXT_INPUT:
+      // typed text may need glyphs the atlas does not hold yet
+      glyph_atlas_.AddText(event.text.text);
+      break;
+
+    case SDL_EVENT_DROP_FILE:
+      // files dropped on a stream tab go to that remote host
+      if (stream_window_ &&
+          SDL_GetWindowID(stream_window_) == event.drop.windowID &&
+          event.drop.data) {
+        auto it = client_properties_.find(focused_remote_id_);
+        if (it != client_properties_.end() &&
+            it->second->connection_established_) {
+          it->second->file_transfer_.SendFile(event.drop.data);
+        }
+      }
+      break;
+
+#ifdef CROSSDESK_TRACE
+    case SDL_EVENT_KEY_DOWN:
+      // ctrl+shift+f12 starts recording, pressed again it writes the trace
+      if (event.key.key == SDLK_F12 && (event.key.mod & SDL_KMOD_CTRL) &&
+          (event.key.mod & SDL_KMOD_SHIFT) && !event.key.repeat) {
+        if (TraceRecorder::Global().IsEnabled()) {
+          DumpTrace();
+          TraceRecorder::Global().SetEnabled(config_center_->IsEnableTrace());
+        } else {
+          TraceRecorder::Global().SetEnabled(true);
+          LOG_INFO("Trace recording started");
+        }
+      }
+      break;
+#endif
+
     case SDL_EVENT_MOUSE_MOTION:
     case SDL_EVENT_MOUSE_BUTTON_DOWN:
     case SDL_EVENT_MOUSE_BUTTON_UP:
@@ -1391,6 +2387,7 @@ void Render::ProcessSdlEvent(const SDL_Event& event) {
 
     default:
       if (event.type == STREAM_REFRESH_EVENT) {
+        TRACE_SCOPE("STREAM_REFRESH_EVENT");
         auto* props = static_cast<SubStreamWindowProperties*>(event.user.data1);
         if (!props) {
           break;
@@ -1453,8 +2450,19 @@ void Render::ProcessSdlEvent(const SDL_Event& event) {
           SDL_DestroyProperties(nvProps);
         }
 
+        uint64_t upload_start_us = MetricsRegistry::NowMicros();
+        uint64_t receive_time_us = props->receive_time_us_;
+        if (receive_time_us != 0 && upload_start_us > receive_time_us) {
+          receive_to_upload_us_metric_->Record(upload_start_us -
+                                               receive_time_us);
+        }
         SDL_UpdateTexture(props->stream_texture_, NULL, props->dst_buffer_,
                           props->texture_width_);
+        texture_upload_us_metric_->Record(MetricsRegistry::NowMicros() -
+                                          upload_start_us);
+        if (props->latency_markers_) {
+          UpdateGlassToGlassLatency(props);
+        }
       }
       break;
   }
@@ -12,23 +12,39 @@
 #include <atomic>
 #include <chrono>
 #include <fstream>
+#include <future>
 #include <mutex>
 #include <optional>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "IconsFontAwesome6.h"
+#include "audio_mixer.h"
 #include "config_center.h"
+#include "data_channel_mux.h"
 #include "device_controller_factory.h"
+#include "file_transfer.h"
+#include "glyph_atlas.h"
 #include "imgui.h"
 #include "imgui_impl_sdl3.h"
 #include "imgui_impl_sdlrenderer3.h"
 #include "imgui_internal.h"
+#include "input_filter.h"
+#include "latency_marker.h"
+#include "metrics.h"
+#include "metrics_server.h"
 #include "minirtc.h"
 #include "path_manager.h"
+#include "quality_controller.h"
 #include "screen_capturer_factory.h"
+#include "silence_detector.h"
 #include "speaker_capturer_factory.h"
 #include "thumbnail.h"
+#include "trace_recorder.h"
+#include "version_checker.h"
+#include "video_send_queue.h"
+#include "video_tier_selector.h"
 #if _WIN32
 #include "win_tray.h"
 #endif
@@ -41,6 +57,7 @@ class Render {
     PeerPtr* peer_ = nullptr;
     std::string audio_label_ = "control_audio";
     std::string data_label_ = "control_data";
+    std::string file_label_ = "control_file";
     std::string local_id_ = "";
     std::string remote_id_ = "";
     bool exit_ = false;
@@ -67,10 +84,10 @@ class Render {
     float sub_stream_window_width_ = 1280;
     float sub_stream_window_height_ = 720;
     float control_window_min_width_ = 20;
-    float control_window_max_width_ = 230;
+    float control_window_max_width_ = 263;
     float control_window_min_height_ = 40;
-    float control_window_max_height_ = 170;
-    float control_window_width_ = 230;
+    float control_window_max_height_ = 230;
+    float control_window_width_ = 263;
     float control_window_height_ = 40;
     float control_bar_pos_x_ = 0;
     float control_bar_pos_y_ = 30;
@@ -118,6 +135,43 @@ class Render {
     int frame_count_ = 0;
     std::chrono::steady_clock::time_point last_time_;
     XNetTrafficStats net_traffic_stats_;
+    // local cursor prediction, remote cursor is normalized to the display
+    bool local_cursor_prediction_ = true;
+    uint64_t last_local_cursor_move_time_ = 0;
+    bool remote_cursor_received_ = false;
+    float remote_cursor_x_ = 0;
+    float remote_cursor_y_ = 0;
+    int remote_cursor_type_ = 0;
+    uint32_t input_seq_ = 0;
+    bool need_to_send_audio_config_ = false;
+    // capture to presentation delays, GetSystemTimeMicros clock
+    int64_t video_delay_us_ = 0;
+    int64_t audio_delay_us_ = 0;
+    int av_offset_ms_ = 0;
+    int audio_extra_delay_ms_ = 0;
+    // this stream's volume in the local mix, right click the audio button
+    float audio_gain_ = 1.0f;
+    // viewport last reported to the host for its resolution tier
+    int sent_video_width_ = 0;
+    int sent_video_height_ = 0;
+    uint64_t last_video_size_send_time_ = 0;
+    // glass to glass latency read back from the host's frame markers
+    bool latency_markers_ = false;
+    bool need_to_send_latency_marker_ = false;
+    uint64_t last_marker_timestamp_ = 0;
+    LatencyWindow glass_to_glass_;
+    LatencyWindow::Percentiles glass_to_glass_percentiles_;
+    uint64_t last_glass_to_glass_update_time_ = 0;
+    std::ofstream latency_csv_;
+    // set by the network thread, read when the frame is uploaded
+    std::atomic<uint64_t> receive_time_us_{0};
+    // video loss from the latest net report, per mille, -1 once sent
+    std::atomic<int> video_loss_permille_{-1};
+    DataChannelMux data_mux_;
+    FileTransfer file_transfer_;
+    // what the file popup lists, kept after the transfer forgets them
+    std::vector<FileTransfer::Progress> file_transfers_;
+    char fetch_file_path_[1024] = "";
   };
 
  public:
@@ -126,18 +180,23 @@ class Render {
 
  public:
   int Run();
+  // host only, no windows, renderers or ImGui, stops on SIGINT or SIGTERM
+  int RunHeadless();
 
  private:
+  int InitializePaths();
   void InitializeLogger();
   void InitializeSettings();
   void InitializeSDL();
   void InitializeModules();
   void InitializeMainWindow();
   void MainLoop();
+  void HeadlessLoop();
   void UpdateLabels();
   void UpdateInteractions();
   void HandleRecentConnections();
   void HandleStreamWindow();
+  void HandleUpdateCheck();
   void Cleanup();
   void CleanupFactories();
   void CleanupPeer(std::shared_ptr<SubStreamWindowProperties> props);
@@ -178,12 +237,16 @@ class Render {
   int DestroyMainWindowContext();
   int SetupStreamWindow();
   int DestroyStreamWindowContext();
+  int UpdateFontAtlas();
   int DrawMainWindow();
   int DrawStreamWindow();
   int ConfirmDeleteConnection();
   int NetTrafficStats(std::shared_ptr<SubStreamWindowProperties>& props);
+  int FileTransferPopup(std::shared_ptr<SubStreamWindowProperties>& props);
+  void UpdateFileTransfers(std::shared_ptr<SubStreamWindowProperties>& props);
   void DrawConnectionStatusText(
       std::shared_ptr<SubStreamWindowProperties>& props);
+  void DrawPredictedCursor(std::shared_ptr<SubStreamWindowProperties>& props);
 
  public:
   static void OnReceiveVideoBufferCb(const XVideoFrame* video_frame,
@@ -194,6 +257,11 @@ class Render {
                                      const char* user_id, size_t user_id_size,
                                      void* user_data);
 
+  static void SDLCALL OnAudioStreamGetCb(void* userdata,
+                                         SDL_AudioStream* stream,
+                                         int additional_amount,
+                                         int total_amount);
+
   static void OnReceiveDataBufferCb(const char* data, size_t size,
                                     const char* user_id, size_t user_id_size,
                                     void* user_data);
@@ -222,6 +290,18 @@ class Render {
 
  private:
   int SendKeyCommand(int key_code, bool is_down);
+  int SendRemoteInput(std::shared_ptr<SubStreamWindowProperties>& props,
+                      RemoteAction& remote_action);
+  int SendCursorInfo();
+  int SendHostInfo();
+  int SendAudioConfig(std::shared_ptr<SubStreamWindowProperties>& props);
+  int SendVideoSize(std::shared_ptr<SubStreamWindowProperties>& props);
+  int SendLatencyMarker(std::shared_ptr<SubStreamWindowProperties>& props);
+  int SendVideoLoss(std::shared_ptr<SubStreamWindowProperties>& props,
+                    int loss_permille);
+  int UpdateGlassToGlassLatency(SubStreamWindowProperties* props);
+  int DumpMetrics();
+  int DumpTrace();
   int ProcessMouseEvent(const SDL_Event& event);
 
   static void SdlCaptureAudioIn(void* userdata, Uint8* stream, int len);
@@ -234,9 +314,29 @@ class Render {
   int ScreenCapturerInit();
   int StartScreenCapturer();
   int StopScreenCapturer();
+  int ScaleToActiveTier(const VideoSendQueue::Frame& send_frame,
+                        XVideoFrame* frame);
+  int UpdateQuality(const std::string& remote_id,
+                    const XNetTrafficStats& net_traffic_stats);
+  void SetViewerVideoLoss(const std::string& remote_id, float loss_rate);
+  void RemoveQualityViewer(const std::string& remote_id);
+  int ApplyQualityLevel(const std::string& remote_id, const char* reason);
+  void SetLatencyMarkerViewer(const std::string& remote_id, bool enable);
+  bool InjectRemoteInput(const std::string& remote_id,
+                         const RemoteAction& remote_action);
+  void ApplyRemoteInput(const RemoteAction& remote_action);
+  void FlushHeldInput();
 
   int StartSpeakerCapturer();
   int StopSpeakerCapturer();
+  void SetViewerAudioConfig(const std::string& remote_id,
+                            const AudioConfig& audio_config);
+  void RemoveViewerAudioConfig(const std::string& remote_id);
+  int ApplyAudioConfig();
+  int SendComfortNoise();
+  int SendAudioTimestamp(uint64_t captured_timestamp);
+  int UpdateAvSync(std::shared_ptr<SubStreamWindowProperties>& props,
+                   uint64_t audio_captured_timestamp);
 
   int StartMouseController();
   int StopMouseController();
@@ -278,7 +378,10 @@ class Render {
   int localization_language_index_ = -1;
   int localization_language_index_last_ = -1;
   bool modules_inited_ = false;
+  bool headless_ = false;
   /* ------ all windows property start ------ */
+  // shared by the main and stream contexts
+  GlyphAtlas glyph_atlas_;
   float title_bar_width_ = 640;
   float title_bar_height_ = 30;
   /* ------ all windows property end ------ */
@@ -300,6 +403,10 @@ class Render {
   SDL_Window* main_window_ = nullptr;
   SDL_Renderer* main_renderer_ = nullptr;
   ImGuiContext* main_ctx_ = nullptr;
+  ImTextureID main_font_texture_ = 0;
+  // startup timing
+  std::chrono::steady_clock::time_point run_start_time_;
+  bool first_frame_presented_ = false;
   bool exit_ = false;
   const int sdl_refresh_ms_ = 16;  // ~60 FPS
 #if _WIN32
@@ -309,6 +416,11 @@ class Render {
   // main window properties
   std::string latest_version_ = "";
   bool update_available_ = false;
+  // fed by a detached thread, dropping it at exit does not wait for a
+  // slow name lookup the way an std::async future would
+  std::future<UpdateInfo> update_check_;
+  // set on cleanup, the worker then leaves the cache file alone
+  std::shared_ptr<std::atomic<bool>> update_check_abandoned_;
   bool start_mouse_controller_ = false;
   bool mouse_controller_is_started_ = false;
   bool start_screen_capturer_ = false;
@@ -366,14 +478,32 @@ class Render {
   std::string controlled_remote_id_ = "";
   std::string focused_remote_id_ = "";
   bool need_to_send_host_info_ = false;
+  CursorInfo last_sent_cursor_info_;
+  bool cursor_info_sent_ = false;
+  uint64_t last_cursor_info_send_time_ = 0;
+  bool hide_os_cursor_ = false;
   SDL_Event last_mouse_event;
-  SDL_AudioStream* output_stream_;
+  SDL_AudioStream* output_stream_ = nullptr;
+  // viewer playback layout and host capture layout, both negotiated
+  AudioConfig output_audio_config_;
+  AudioMixer audio_mixer_;
+  std::vector<uint8_t> audio_mix_buffer_;
+  AudioConfig audio_config_;
+  // what each viewer asked for, stored by the data callback and applied on
+  // the main loop where the capturer lives
+  std::mutex viewer_audio_configs_mutex_;
+  std::unordered_map<std::string, AudioConfig> viewer_audio_configs_;
+  std::atomic<bool> need_to_apply_audio_config_{false};
+  SilenceDetector silence_detector_;
+  uint64_t last_comfort_noise_time_ = 0;
+  uint64_t last_audio_timestamp_time_ = 0;
   uint32_t STREAM_REFRESH_EVENT = 0;
 
   // stream window render
   SDL_Window* stream_window_ = nullptr;
   SDL_Renderer* stream_renderer_ = nullptr;
   ImGuiContext* stream_ctx_ = nullptr;
+  ImTextureID stream_font_texture_ = 0;
 
   // stream window properties
   bool need_to_create_stream_window_ = false;
@@ -423,11 +553,58 @@ class Render {
   std::string video_secondary_label_ = "secondary_display";
   std::string audio_label_ = "audio";
   std::string data_label_ = "data";
+  std::string file_label_ = "file";
   Params params_;
   SDL_AudioDeviceID input_dev_;
   SDL_AudioDeviceID output_dev_;
   ScreenCapturerFactory* screen_capturer_factory_ = nullptr;
   ScreenCapturer* screen_capturer_ = nullptr;
+  VideoSendQueue video_send_queue_;
+  VideoTierSelector video_tier_selector_;
+  // one controller per viewer, the most congested of them sets the shared
+  // capture
+  std::mutex quality_mutex_;
+  std::unordered_map<std::string, std::unique_ptr<QualityController>>
+      quality_controllers_;
+  std::unordered_map<std::string, float> viewer_video_loss_;
+  int quality_max_fps_ = 60;
+  int quality_level_ = 0;
+  // host side data channel, chunks are rebuilt per sender
+  DataChannelMux data_mux_;
+  std::mutex data_chunk_mutex_;
+  std::unordered_map<std::string, DataChunkAssembler> data_chunk_assemblers_;
+  FileTransfer file_transfer_;
+  // applied on the capture and sender threads
+  std::atomic<int> capture_fps_{60};
+  std::atomic<int> capture_scale_percent_{100};
+  // scaling scratch, only touched on the video sender thread
+  std::vector<uint8_t> tier_i420_;
+  std::vector<uint8_t> tier_scaled_i420_;
+  std::vector<uint8_t> tier_nv12_;
+  // viewers that asked for glass to glass markers in the video
+  std::mutex latency_marker_mutex_;
+  std::unordered_set<std::string> latency_marker_viewers_;
+  std::atomic<bool> stamp_latency_markers_{false};
+  // pipeline stages, recorded from whichever thread runs them
+  MetricHistogram* video_scale_us_metric_ =
+      MetricsRegistry::Global().Histogram("video_scale_us");
+  MetricHistogram* video_send_us_metric_ =
+      MetricsRegistry::Global().Histogram("video_send_us");
+  MetricHistogram* receive_to_upload_us_metric_ =
+      MetricsRegistry::Global().Histogram("video_receive_to_upload_us");
+  MetricHistogram* texture_upload_us_metric_ =
+      MetricsRegistry::Global().Histogram("video_texture_upload_us");
+  MetricHistogram* input_inject_us_metric_ =
+      MetricsRegistry::Global().Histogram("input_inject_us");
+  MetricCounter* video_frames_received_metric_ =
+      MetricsRegistry::Global().Counter("video_frames_received");
+  MetricCounter* input_events_metric_ =
+      MetricsRegistry::Global().Counter("input_events");
+  MetricGauge* connections_metric_ =
+      MetricsRegistry::Global().Gauge("connections_active");
+  MetricGauge* capture_fps_metric_ =
+      MetricsRegistry::Global().Gauge("capture_fps");
+  MetricsServer metrics_server_;
   SpeakerCapturerFactory* speaker_capturer_factory_ = nullptr;
   SpeakerCapturer* speaker_capturer_ = nullptr;
   DeviceControllerFactory* device_controller_factory_ = nullptr;
@@ -447,6 +624,8 @@ class Render {
   int video_quality_button_value_ = 0;
   int video_frame_rate_button_value_ = 1;
   int video_encode_format_button_value_ = 0;
+  int audio_frame_duration_button_value_ = 2;
+  int audio_channels_button_value_ = 0;
   bool enable_hardware_video_codec_ = false;
   bool enable_turn_ = false;
   bool enable_srtp_ = false;
@@ -459,12 +638,16 @@ class Render {
   int video_quality_button_value_last_ = 0;
   int video_frame_rate_button_value_last_ = 0;
   int video_encode_format_button_value_last_ = 0;
+  int audio_frame_duration_button_value_last_ = 2;
+  int audio_channels_button_value_last_ = 0;
   bool enable_hardware_video_codec_last_ = false;
   bool enable_turn_last_ = false;
   bool enable_srtp_last_ = false;
   bool enable_self_hosted_last_ = false;
   bool enable_autostart_ = false;
   bool enable_autostart_last_ = false;
+  bool enable_local_cursor_prediction_ = true;
+  bool enable_local_cursor_prediction_last_ = true;
   bool enable_minimize_to_tray_ = false;
   bool enable_minimize_to_tray_last_ = false;
   char signal_server_ip_self_[256] = "";
@@ -485,6 +668,11 @@ class Render {
 
   /* ------ server mode ------ */
   std::unordered_map<std::string, ConnectionStatus> connection_status_;
+  InputFilter input_filter_;
+  // late moves waiting for a newer one, also serializes input injection
+  // between the data callback and the main loop
+  std::mutex remote_input_mutex_;
+  std::unordered_map<std::string, RemoteAction> held_moves_;
 };
 }  // namespace crossdesk
 #endif
\ No newline at end of file
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "device_controller.h"
 #include "localization.h"
 #include "platform.h"
@@ -8,6 +10,42 @@
 
 namespace crossdesk {
 
+static MetricsServer::PeerStats ToPeerStats(
+    const XNetTrafficStats& net_traffic_stats) {
+  auto to_stream = [](const auto& inbound, const auto& outbound) {
+    MetricsServer::StreamStats stream;
+    stream.inbound_bitrate = (float)inbound.bitrate;
+    stream.outbound_bitrate = (float)outbound.bitrate;
+    stream.inbound_loss_rate = inbound.loss_rate;
+    return stream;
+  };
+  MetricsServer::PeerStats stats;
+  stats.video = to_stream(net_traffic_stats.video_inbound_stats,
+                          net_traffic_stats.video_outbound_stats);
+  stats.audio = to_stream(net_traffic_stats.audio_inbound_stats,
+                          net_traffic_stats.audio_outbound_stats);
+  stats.data = to_stream(net_traffic_stats.data_inbound_stats,
+                         net_traffic_stats.data_outbound_stats);
+  stats.total = to_stream(net_traffic_stats.total_inbound_stats,
+                          net_traffic_stats.total_outbound_stats);
+  return stats;
+}
+
+static void LogDataChannelStats(const std::string& remote_id,
+                                DataChannelMux& data_mux) {
+  DataChannelMux::Stats stats = data_mux.GetStats();
+  for (int i = 0; i < DataChannelMux::kPriorityCount; i++) {
+    const DataChannelMux::ClassStats& class_stats = stats.classes[i];
+    LOG_INFO(
+        "[{}] data {}: sent: {}, bytes: {}, dropped: {}, queued: {}, latency "
+        "avg: {} us, max: {} us",
+        remote_id, DataChannelMux::PriorityName((DataChannelMux::Priority)i),
+        class_stats.sent, class_stats.bytes, class_stats.dropped,
+        class_stats.depth, class_stats.avg_latency_us,
+        class_stats.max_latency_us);
+  }
+}
+
 int Render::SendKeyCommand(int key_code, bool is_down) {
   RemoteAction remote_action;
   remote_action.type = ControlType::keyboard;
@@ -23,9 +61,7 @@ int Render::SendKeyCommand(int key_code, bool is_down) {
         client_properties_.end()) {
       auto props = client_properties_[controlled_remote_id_];
       if (props->connection_status_ == ConnectionStatus::Connected) {
-        std::string msg = remote_action.to_json();
-        SendDataFrame(props->peer_, msg.c_str(), msg.size(),
-                      props->data_label_.c_str());
+        SendRemoteInput(props, remote_action);
       }
     }
   }
@@ -33,6 +69,19 @@ int Render::SendKeyCommand(int key_code, bool is_down) {
   return 0;
 }
 
+int Render::SendRemoteInput(std::shared_ptr<SubStreamWindowProperties>& props,
+                            RemoteAction& remote_action) {
+  // 0 is reserved for unnumbered input
+  if (++props->input_seq_ == 0) {
+    props->input_seq_ = 1;
+  }
+  remote_action.seq = props->input_seq_;
+  remote_action.ts = GetSystemTimeMicros(props->peer_);
+
+  std::string msg = remote_action.to_json();
+  return props->data_mux_.Send(DataChannelMux::Priority::INPUT, msg);
+}
+
 int Render::ProcessMouseEvent(const SDL_Event& event) {
   controlled_remote_id_ = "";
   int video_width, video_height = 0;
@@ -46,7 +95,8 @@ int Render::ProcessMouseEvent(const SDL_Event& event) {
       continue;
     }
 
-    if (event.button.x >= props->stream_render_rect_.x &&
+    if (SDL_EVENT_MOUSE_WHEEL != event.type &&
+        event.button.x >= props->stream_render_rect_.x &&
         event.button.x <=
             props->stream_render_rect_.x + props->stream_render_rect_.w &&
         event.button.y >= props->stream_render_rect_.y &&
@@ -85,15 +135,14 @@ int Render::ProcessMouseEvent(const SDL_Event& event) {
       } else if (SDL_EVENT_MOUSE_MOTION == event.type) {
         remote_action.type = ControlType::mouse;
         remote_action.m.flag = MouseFlag::move;
+        props->last_local_cursor_move_time_ = SDL_GetTicks();
       }
 
       if (props->control_bar_hovered_ || props->display_selectable_hovered_) {
         remote_action.m.flag = MouseFlag::move;
       }
 
-      std::string msg = remote_action.to_json();
-      SendDataFrame(props->peer_, msg.c_str(), msg.size(),
-                    props->data_label_.c_str());
+      SendRemoteInput(props, remote_action);
     } else if (SDL_EVENT_MOUSE_WHEEL == event.type &&
                last_mouse_event.button.x >= props->stream_render_rect_.x &&
                last_mouse_event.button.x <= props->stream_render_rect_.x +
@@ -101,33 +150,36 @@ int Render::ProcessMouseEvent(const SDL_Event& event) {
                last_mouse_event.button.y >= props->stream_render_rect_.y &&
                last_mouse_event.button.y <= props->stream_render_rect_.y +
                                                 props->stream_render_rect_.h) {
-      int scroll_x = event.wheel.x;
-      int scroll_y = event.wheel.y;
+      float scroll_x = event.wheel.x;
+      float scroll_y = event.wheel.y;
       if (event.wheel.direction == SDL_MOUSEWHEEL_FLIPPED) {
         scroll_x = -scroll_x;
         scroll_y = -scroll_y;
       }
 
-      remote_action.type = ControlType::mouse;
-      if (scroll_x == 0) {
-        remote_action.m.flag = MouseFlag::wheel_vertical;
-        remote_action.m.s = scroll_y;
-      } else if (scroll_y == 0) {
-        remote_action.m.flag = MouseFlag::wheel_horizontal;
-        remote_action.m.s = scroll_x;
-      }
-
       render_width = props->stream_render_rect_.w;
       render_height = props->stream_render_rect_.h;
+      remote_action.type = ControlType::mouse;
       remote_action.m.x =
-          (float)(event.button.x - props->stream_render_rect_.x) / render_width;
+          (float)(last_mouse_event.button.x - props->stream_render_rect_.x) /
+          render_width;
       remote_action.m.y =
-          (float)(event.button.y - props->stream_render_rect_.y) /
+          (float)(last_mouse_event.button.y - props->stream_render_rect_.y) /
           render_height;
 
-      std::string msg = remote_action.to_json();
-      SendDataFrame(props->peer_, msg.c_str(), msg.size(),
-                    props->data_label_.c_str());
+      // trackpads report both axes with fractional deltas, forward them as is
+      // and let the host accumulate them
+      if (scroll_y != 0.0f) {
+        remote_action.m.flag = MouseFlag::wheel_vertical;
+        remote_action.m.s = scroll_y;
+        SendRemoteInput(props, remote_action);
+      }
+
+      if (scroll_x != 0.0f) {
+        remote_action.m.flag = MouseFlag::wheel_horizontal;
+        remote_action.m.s = scroll_x;
+        SendRemoteInput(props, remote_action);
+      }
     }
   }
 
@@ -188,6 +240,7 @@ void Render::SdlCaptureAudioOut([[maybe_unused]] void* userdata,
 void Render::OnReceiveVideoBufferCb(const XVideoFrame* video_frame,
                                     const char* user_id, size_t user_id_size,
                                     void* user_data) {
+  TRACE_SCOPE("OnReceiveVideoBufferCb");
   Render* render = (Render*)user_data;
   if (!render) {
     return;
@@ -214,6 +267,8 @@ void Render::OnReceiveVideoBufferCb(const XVideoFrame* video_frame,
     }
 
     memcpy(props->dst_buffer_, video_frame->data, video_frame->size);
+    props->receive_time_us_ = MetricsRegistry::NowMicros();
+    render->video_frames_received_metric_->Add();
     bool need_to_update_render_rect = false;
     if (props->video_width_ != props->video_width_last_ ||
         props->video_height_ != props->video_height_last_) {
@@ -225,6 +280,17 @@ void Render::OnReceiveVideoBufferCb(const XVideoFrame* video_frame,
     props->video_height_ = video_frame->height;
     props->video_size_ = video_frame->size;
 
+    uint64_t now_time = GetSystemTimeMicros(props->peer_);
+    if (video_frame->captured_timestamp != 0 &&
+        now_time > video_frame->captured_timestamp) {
+      int64_t video_delay_us =
+          (int64_t)(now_time - video_frame->captured_timestamp);
+      props->video_delay_us_ =
+          props->video_delay_us_ == 0
+              ? video_delay_us
+              : (props->video_delay_us_ * 7 + video_delay_us) / 8;
+    }
+
     LOG_ERROR("receive: {}x{}", props->video_width_, props->video_height_);
 
     if (need_to_update_render_rect) {
@@ -263,12 +329,26 @@ void Render::OnReceiveAudioBufferCb(const char* data, size_t size,
 
   render->audio_buffer_fresh_ = true;
 
-  if (render->output_stream_) {
-    int pushed = SDL_PutAudioStreamData(
-        render->output_stream_, (const Uint8*)data, static_cast<int>(size));
-    if (pushed < 0) {
-      LOG_ERROR("Failed to push audio data: {}", SDL_GetError());
-    }
+  // every peer has its own mixer input, the output pulls the mix
+  render->audio_mixer_.Put(std::string(user_id, user_id_size),
+                           (const uint8_t*)data, size,
+                           SDL_GetTicksNS() / 1000);
+}
+
+void SDLCALL Render::OnAudioStreamGetCb(void* userdata, SDL_AudioStream* stream,
+                                        int additional_amount,
+                                        int total_amount) {
+  Render* render = (Render*)userdata;
+  if (!render || additional_amount <= 0) {
+    return;
+  }
+
+  render->audio_mix_buffer_.clear();
+  render->audio_mixer_.Mix((size_t)additional_amount,
+                           render->audio_mix_buffer_);
+  if (!render->audio_mix_buffer_.empty()) {
+    SDL_PutAudioStreamData(stream, render->audio_mix_buffer_.data(),
+                           static_cast<int>(render->audio_mix_buffer_.size()));
   }
 }
 
@@ -280,6 +360,33 @@ void Render::OnReceiveDataBufferCb(const char* data, size_t size,
     return;
   }
 
+  if (FileTransfer::IsFileMessage(data, size)) {
+    std::string sender_id(user_id, user_id_size);
+    auto it = render->client_properties_.find(sender_id);
+    if (it != render->client_properties_.end()) {
+      it->second->file_transfer_.OnMessage(data, size);
+    } else {
+      render->file_transfer_.OnMessage(data, size);
+    }
+    return;
+  }
+
+  if (DataChannelMux::IsChunk(data, size)) {
+    std::string message;
+    std::string sender_id(user_id, user_id_size);
+    bool complete = false;
+    {
+      std::lock_guard<std::mutex> lock(render->data_chunk_mutex_);
+      complete =
+          render->data_chunk_assemblers_[sender_id].Add(data, size, &message);
+    }
+    if (complete) {
+      OnReceiveDataBufferCb(message.data(), message.size(), user_id,
+                            user_id_size, user_data);
+    }
+    return;
+  }
+
   std::string json_str(data, size);
   RemoteAction remote_action;
 
@@ -300,35 +407,70 @@ void Render::OnReceiveDataBufferCb(const char* data, size_t size,
       props->remote_host_name_ = std::string(remote_action.i.host_name,
                                              remote_action.i.host_name_size);
       LOG_INFO("Remote hostname: [{}]", props->remote_host_name_);
+      render->glyph_atlas_.AddText(props->remote_host_name_);
 
       for (int i = 0; i < remote_action.i.display_num; i++) {
+        render->glyph_atlas_.AddText(remote_action.i.display_list[i]);
         props->display_info_list_.push_back(
             DisplayInfo(remote_action.i.display_list[i],
                         remote_action.i.left[i], remote_action.i.top[i],
                         remote_action.i.right[i], remote_action.i.bottom[i]));
       }
+    } else if (remote_action.type == ControlType::cursor_info) {
+      props->remote_cursor_x_ = remote_action.c.x;
+      props->remote_cursor_y_ = remote_action.c.y;
+      props->remote_cursor_type_ = remote_action.c.type;
+      props->remote_cursor_received_ = true;
+    } else if (remote_action.type == ControlType::audio_timestamp) {
+      render->UpdateAvSync(props, remote_action.t);
+    } else if (remote_action.type == ControlType::comfort_noise) {
+      render->audio_mixer_.SetComfortNoise(remote_id, remote_action.d);
+    } else if (remote_action.type == ControlType::audio_config) {
+      render->audio_mixer_.SetSourceConfig(
+          remote_id, AudioConfig(remote_action.p.frame_duration_us,
+                                 remote_action.p.channels));
     }
     FreeRemoteAction(remote_action);
   } else {
     // remote
-    if (remote_action.type == ControlType::mouse && render->mouse_controller_) {
-      render->mouse_controller_->SendMouseCommand(remote_action,
-                                                  render->selected_display_);
-    } else if (remote_action.type == ControlType::audio_capture) {
+    if ((remote_action.type == ControlType::mouse ||
+         remote_action.type == ControlType::keyboard) &&
+        !render->InjectRemoteInput(remote_id, remote_action)) {
+      return;
+    }
+
+    if (remote_action.type == ControlType::audio_capture) {
       if (remote_action.a && !render->start_speaker_capturer_)
         render->StartSpeakerCapturer();
       else if (!remote_action.a && render->start_speaker_capturer_)
         render->StopSpeakerCapturer();
-    } else if (remote_action.type == ControlType::keyboard &&
-               render->keyboard_capturer_) {
-      render->keyboard_capturer_->SendKeyboardCommand(
-          (int)remote_action.k.key_value,
-          remote_action.k.flag == KeyFlag::key_down);
+    } else if (remote_action.type == ControlType::video_size) {
+      render->video_tier_selector_.SetViewerSize(
+          remote_id, remote_action.v.width, remote_action.v.height);
+    } else if (remote_action.type == ControlType::latency_marker) {
+      render->SetLatencyMarkerViewer(remote_id, remote_action.a);
+    } else if (remote_action.type == ControlType::video_loss) {
+      render->SetViewerVideoLoss(remote_id, remote_action.d / 1000.0f);
+    } else if (remote_action.type == ControlType::audio_config) {
+      render->SetViewerAudioConfig(
+          remote_id, AudioConfig(remote_action.p.frame_duration_us,
+                                 remote_action.p.channels));
     } else if (remote_action.type == ControlType::display_id &&
                render->screen_capturer_) {
       render->selected_display_ = remote_action.d;
       render->screen_capturer_->SwitchTo(remote_action.d);
     }
+
+    if ((remote_action.type == ControlType::mouse ||
+         remote_action.type == ControlType::keyboard) &&
+        remote_action.ts != 0) {
+      // viewer stamp to injected, on the synchronised clock
+      uint64_t now_us = GetSystemTimeMicros(render->peer_);
+      if (now_us > remote_action.ts) {
+        render->input_inject_us_metric_->Record(now_us - remote_action.ts);
+      }
+      render->input_events_metric_->Add();
+    }
   }
 }
 
@@ -406,6 +548,19 @@ void Render::OnConnectionStatusCb(ConnectionStatus status, const char* user_id,
           render->need_to_create_stream_window_ = true;
         }
         props->connection_established_ = true;
+        props->need_to_send_audio_config_ = true;
+        props->sent_video_width_ = 0;
+        props->sent_video_height_ = 0;
+        props->latency_markers_ =
+            render->config_center_->IsEnableLatencyMarkers();
+        props->need_to_send_latency_marker_ = props->latency_markers_;
+        props->last_marker_timestamp_ = 0;
+        props->glass_to_glass_.Reset();
+        props->glass_to_glass_percentiles_ = LatencyWindow::Percentiles();
+        if (props->latency_markers_) {
+          // room for the glass to glass row in the stats table
+          props->control_window_max_height_ = 250;
+        }
         props->stream_render_rect_ = {
             0, (int)render->title_bar_height_,
             (int)render->stream_window_width_,
@@ -415,6 +570,34 @@ void Render::OnConnectionStatusCb(ConnectionStatus status, const char* user_id,
       case ConnectionStatus::Disconnected:
       case ConnectionStatus::Failed:
       case ConnectionStatus::Closed: {
+        AudioJitterBuffer::Stats audio_stats =
+            render->audio_mixer_.GetStats(remote_id);
+        LOG_INFO(
+            "[{}] audio frames received: {}, dropped: {}, compressed: {}, "
+            "concealed: {}, comfort noise: {} ms, target: {} ms, jitter: {} "
+            "ms",
+            remote_id, audio_stats.received_frames, audio_stats.dropped_frames,
+            audio_stats.compressed_frames, audio_stats.concealed_frames,
+            audio_stats.comfort_noise_ms, audio_stats.target_ms,
+            audio_stats.jitter_ms);
+        LOG_INFO("[{}] a/v offset: {} ms, audio held back: {} ms", remote_id,
+                 props->av_offset_ms_, props->audio_extra_delay_ms_);
+        LogDataChannelStats(remote_id, props->data_mux_);
+        props->data_mux_.Clear();
+        if (props->latency_markers_) {
+          LatencyWindow::Percentiles g2g = props->glass_to_glass_.Get();
+          LOG_INFO(
+              "[{}] glass to glass samples: {}, p50: {} us, p95: {} us, p99: "
+              "{} us",
+              remote_id, g2g.count, g2g.p50_us, g2g.p95_us, g2g.p99_us);
+          props->latency_csv_.close();
+        }
+        render->audio_mixer_.RemoveSource(remote_id);
+        props->audio_extra_delay_ms_ = 0;
+        props->video_delay_us_ = 0;
+        props->audio_delay_us_ = 0;
+        props->av_offset_ms_ = 0;
+
         props->connection_established_ = false;
         props->mouse_control_button_pressed_ = false;
         if (props->dst_buffer_) {
@@ -455,7 +638,16 @@ void Render::OnConnectionStatusCb(ConnectionStatus status, const char* user_id,
 
     switch (status) {
       case ConnectionStatus::Connected: {
+        // the viewer numbers its input from 1 again in every session
+        {
+          std::lock_guard<std::mutex> lock(render->remote_input_mutex_);
+          render->held_moves_.erase(remote_id);
+          render->input_filter_.Reset(remote_id);
+        }
         render->need_to_send_host_info_ = true;
+        render->cursor_info_sent_ = false;
+        // full resolution until the viewer reports its viewport
+        render->video_tier_selector_.SetViewerSize(remote_id, 0, 0);
         render->start_screen_capturer_ = true;
         render->start_speaker_capturer_ = true;
 #ifdef CROSSDESK_DEBUG
@@ -485,6 +677,7 @@ void Render::OnConnectionStatusCb(ConnectionStatus status, const char* user_id,
           render->start_mouse_controller_ = false;
           render->start_keyboard_capturer_ = false;
           render->need_to_send_host_info_ = false;
+          render->data_mux_.Clear();
           if (props) props->connection_established_ = false;
           if (render->audio_capture_) {
             render->StopSpeakerCapturer();
@@ -506,7 +699,62 @@ void Render::OnConnectionStatusCb(ConnectionStatus status, const char* user_id,
       default:
         break;
     }
+
+    // a viewer that dropped comes back under the same id, so its state goes
+    // with any teardown, not just an orderly close
+    if (status == ConnectionStatus::Closed ||
+        status == ConnectionStatus::Failed ||
+        status == ConnectionStatus::Disconnected) {
+      InputFilter::Stats input_stats =
+          render->input_filter_.GetStats(remote_id);
+      LOG_INFO(
+          "[{}] input received: {}, stale moves dropped: {}, late events: {}",
+          remote_id, input_stats.received, input_stats.dropped_moves,
+          input_stats.late_events);
+      {
+        std::lock_guard<std::mutex> lock(render->remote_input_mutex_);
+        render->held_moves_.erase(remote_id);
+        render->input_filter_.Reset(remote_id);
+      }
+      render->video_tier_selector_.RemoveViewer(remote_id);
+      render->SetLatencyMarkerViewer(remote_id, false);
+      render->RemoveViewerAudioConfig(remote_id);
+      render->RemoveQualityViewer(remote_id);
+      // the host mux is shared by all viewers, its totals only mean
+      // something once the last one is gone
+      bool viewers_left = std::any_of(
+          render->connection_status_.begin(),
+          render->connection_status_.end(), [](const auto& connection) {
+            return connection.second == ConnectionStatus::Connected;
+          });
+      if (!viewers_left) {
+        LogDataChannelStats("host total", render->data_mux_);
+      }
+    }
+  }
+
+  if (status == ConnectionStatus::Closed ||
+      status == ConnectionStatus::Failed ||
+      status == ConnectionStatus::Disconnected) {
+    render->metrics_server_.RemovePeer(remote_id);
+    {
+      // a sender that dropped mid message leaves a partial one behind
+      std::lock_guard<std::mutex> lock(render->data_chunk_mutex_);
+      render->data_chunk_assemblers_.erase(remote_id);
+    }
   }
+  // host sessions plus viewer sessions
+  int64_t connections =
+      std::count_if(render->connection_status_.begin(),
+                    render->connection_status_.end(),
+                    [](const auto& kv) {
+                      return kv.second == ConnectionStatus::Connected;
+                    }) +
+      std::count_if(render->client_properties_.begin(),
+                    render->client_properties_.end(), [](const auto& kv) {
+                      return kv.second->connection_established_;
+                    });
+  render->connections_metric_->Set(connections);
 }
 
 void Render::NetStatusReport(const char* client_id, size_t client_id_size,
@@ -551,8 +799,18 @@ void Render::NetStatusReport(const char* client_id, size_t client_id_size,
   }
 
   std::string remote_id(user_id, user_id_size);
+  if (net_traffic_stats && render->metrics_server_.IsRunning()) {
+    render->metrics_server_.SetPeerStats(remote_id,
+                                         ToPeerStats(*net_traffic_stats));
+  }
+
   if (render->client_properties_.find(remote_id) ==
       render->client_properties_.end()) {
+    // host side, each viewer report feeds that viewer's controller
+    if (net_traffic_stats && render->screen_capturer_is_started_ &&
+        render->connection_status_.count(remote_id)) {
+      render->UpdateQuality(remote_id, *net_traffic_stats);
+    }
     return;
   }
   auto props = render->client_properties_.find(remote_id)->second;
@@ -565,6 +823,10 @@ void Render::NetStatusReport(const char* client_id, size_t client_id_size,
     return;
   }
 
+  // the host has no outbound loss of its own, tell it what arrived here
+  props->video_loss_permille_ =
+      (int)(net_traffic_stats->video_inbound_stats.loss_rate * 1000);
+
   // only display client side net status if connected to itself
   if (!(render->peer_reserved_ && !strstr(client_id, "C-"))) {
     props->net_traffic_stats_ = *net_traffic_stats;
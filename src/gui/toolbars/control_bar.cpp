@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "layout.h"
 #include "localization.h"
 #include "rd_log.h"
@@ -31,7 +33,22 @@ int LossRateDisplay(float loss_rate) {
   return 0;
 }
 
+// one stats row of stage percentiles, in milliseconds
+int StageDisplay(const char* name, const MetricHistogram* histogram) {
+  MetricHistogram::Summary summary = histogram->Summarize();
+  ImGui::TableNextColumn();
+  ImGui::Text("%s", name);
+  ImGui::TableNextColumn();
+  ImGui::Text("p50 %.1f", summary.p50 / 1000.0f);
+  ImGui::TableNextColumn();
+  ImGui::Text("p95 %.1f", summary.p95 / 1000.0f);
+  ImGui::TableNextColumn();
+  ImGui::Text("p99 %.1f", summary.p99 / 1000.0f);
+  return 0;
+}
+
 int Render::ControlBar(std::shared_ptr<SubStreamWindowProperties>& props) {
+  UpdateFileTransfers(props);
   ImGui::PushStyleVar(ImGuiStyleVar_FrameRounding, 3.0f);
 
   if (props->control_bar_expand_) {
@@ -69,8 +86,7 @@ int Render::ControlBar(std::shared_ptr<SubStreamWindowProperties>& props) {
           remote_action.d = i;
           if (props->connection_status_ == ConnectionStatus::Connected) {
             std::string msg = remote_action.to_json();
-            SendDataFrame(props->peer_, msg.c_str(), msg.size(),
-                          props->data_label_.c_str());
+            props->data_mux_.Send(DataChannelMux::Priority::CONTROL, msg);
           }
         }
         props->display_selectable_hovered_ = ImGui::IsWindowHovered();
@@ -140,14 +156,22 @@ int Render::ControlBar(std::shared_ptr<SubStreamWindowProperties>& props) {
                 ? localization::audio_capture[localization_language_index_]
                 : localization::mute[localization_language_index_];
 
+        // silence the tab right away, the host stops capturing later
+        audio_mixer_.SetMute(props->remote_id_,
+                             !props->audio_capture_button_pressed_);
+        audio_mixer_.SetGain(props->remote_id_, props->audio_gain_);
+
         RemoteAction remote_action;
         remote_action.type = ControlType::audio_capture;
         remote_action.a = props->audio_capture_button_pressed_;
         std::string msg = remote_action.to_json();
-        SendDataFrame(props->peer_, msg.c_str(), msg.size(),
-                      props->data_label_.c_str());
+        props->data_mux_.Send(DataChannelMux::Priority::CONTROL, msg);
       }
     }
+    // right click sets this stream's volume in the local mix
+    if (ImGui::IsItemClicked(ImGuiMouseButton_Right)) {
+      ImGui::OpenPopup("audio_volume");
+    }
     if (!props->audio_capture_button_pressed_) {
       draw_list->AddLine(
           ImVec2(disable_audio_x, disable_audio_y),
@@ -161,6 +185,40 @@ int Render::ControlBar(std::shared_ptr<SubStreamWindowProperties>& props) {
           2.0f);
     }
 
+    if (ImGui::BeginPopup("audio_volume")) {
+      ImGui::SetWindowFontScale(0.5f);
+      ImGui::Text("%s",
+                  localization::volume[localization_language_index_].c_str());
+      int volume = static_cast<int>(props->audio_gain_ * 100.0f + 0.5f);
+      ImGui::SetNextItemWidth(120.0f);
+      if (ImGui::SliderInt("##audio_volume", &volume, 0, 200, "%d%%")) {
+        props->audio_gain_ = volume / 100.0f;
+        audio_mixer_.SetGain(props->remote_id_, props->audio_gain_);
+      }
+      ImGui::SetWindowFontScale(1.0f);
+      ImGui::EndPopup();
+    }
+
+    ImGui::SameLine();
+    // file transfer button, highlighted while anything is moving
+    bool file_transfer_active = std::any_of(
+        props->file_transfers_.begin(), props->file_transfers_.end(),
+        [](const FileTransfer::Progress& progress) {
+          return !progress.finished && !progress.failed;
+        });
+    if (file_transfer_active) {
+      ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(66 / 255.0f, 150 / 255.0f,
+                                                    250 / 255.0f, 1.0f));
+    }
+    std::string file_transfer = ICON_FA_FILE_ARROW_DOWN;
+    if (ImGui::Button(file_transfer.c_str(), ImVec2(25, 25))) {
+      ImGui::OpenPopup("file_transfer");
+    }
+    if (file_transfer_active) {
+      ImGui::PopStyleColor();
+    }
+    FileTransferPopup(props);
+
     ImGui::SameLine();
     // net traffic stats button
     bool button_color_style_pushed = false;
@@ -255,6 +313,94 @@ int Render::ControlBar(std::shared_ptr<SubStreamWindowProperties>& props) {
   return 0;
 }
 
+void Render::UpdateFileTransfers(
+    std::shared_ptr<SubStreamWindowProperties>& props) {
+  for (const FileTransfer::Progress& progress :
+       props->file_transfer_.GetProgress()) {
+    auto it = std::find_if(props->file_transfers_.begin(),
+                           props->file_transfers_.end(),
+                           [&progress](const FileTransfer::Progress& known) {
+                             return known.id == progress.id;
+                           });
+    if (it == props->file_transfers_.end()) {
+      props->file_transfers_.push_back(progress);
+    } else {
+      *it = progress;
+    }
+  }
+}
+
+int Render::FileTransferPopup(
+    std::shared_ptr<SubStreamWindowProperties>& props) {
+  if (!ImGui::BeginPopup("file_transfer")) {
+    return 0;
+  }
+  ImGui::SetWindowFontScale(0.5f);
+  ImGui::Text(
+      "%s", localization::file_transfer[localization_language_index_].c_str());
+  ImGui::Separator();
+
+  // pulls a file from the host, the host serves any path it can read
+  ImGui::Text("%s", localization::remote_file_path[localization_language_index_]
+                        .c_str());
+  ImGui::SetNextItemWidth(260.0f);
+  ImGui::InputText("##fetch_file_path", props->fetch_file_path_,
+                   sizeof(props->fetch_file_path_));
+  ImGui::SameLine();
+  if (ImGui::Button(
+          localization::fetch_file[localization_language_index_].c_str()) &&
+      props->fetch_file_path_[0] != '\0' && props->connection_established_) {
+    props->file_transfer_.RequestFile(props->fetch_file_path_);
+    props->fetch_file_path_[0] = '\0';
+  }
+
+  ImGui::Separator();
+  if (props->file_transfers_.empty()) {
+    ImGui::TextDisabled(
+        "%s",
+        localization::drop_files_to_send[localization_language_index_].c_str());
+  }
+
+  for (const FileTransfer::Progress& progress : props->file_transfers_) {
+    ImGui::Text("%s %s",
+                progress.outgoing ? ICON_FA_ARROW_UP : ICON_FA_ARROW_DOWN,
+                progress.name.c_str());
+    float fraction =
+        progress.size > 0 ? (float)progress.done_bytes / progress.size
+                          : (progress.finished ? 1.0f : 0.0f);
+    char overlay[64];
+    if (progress.failed) {
+      snprintf(overlay, sizeof(overlay), "%s",
+               localization::transfer_failed[localization_language_index_]
+                   .c_str());
+    } else if (progress.finished) {
+      snprintf(overlay, sizeof(overlay), "%s",
+               localization::transfer_done[localization_language_index_]
+                   .c_str());
+    } else {
+      snprintf(overlay, sizeof(overlay), "%.0f%%  %.1f MB/s", fraction * 100,
+               progress.bytes_per_second / 1e6);
+    }
+    ImGui::ProgressBar(fraction, ImVec2(320.0f, 0), overlay);
+  }
+
+  if (!props->file_transfers_.empty() &&
+      ImGui::Button(
+          localization::clear_finished[localization_language_index_].c_str())) {
+    props->file_transfers_.erase(
+        std::remove_if(props->file_transfers_.begin(),
+                       props->file_transfers_.end(),
+                       [](const FileTransfer::Progress& progress) {
+                         return progress.finished || progress.failed;
+                       }),
+        props->file_transfers_.end());
+  }
+
+  ImGui::SetWindowFontScale(1.0f);
+  ImGui::EndPopup();
+  return 0;
+}
+
 int Render::NetTrafficStats(std::shared_ptr<SubStreamWindowProperties>& props) {
   ImGui::SetCursorPos(ImVec2(props->is_control_bar_in_left_
                                  ? (props->control_window_width_ + 5.0f)
@@ -322,6 +468,33 @@ int Render::NetTrafficStats(std::shared_ptr<SubStreamWindowProperties>& props) {
     ImGui::Text("FPS");
     ImGui::TableNextColumn();
     ImGui::Text("%d", props->fps_);
+    ImGui::TableNextColumn();
+    ImGui::Text("A/V");
+    ImGui::TableNextColumn();
+    ImGui::Text("%d ms", props->av_offset_ms_);
+
+    if (props->latency_markers_) {
+      // glass to glass from the host's frame markers, in milliseconds
+      const LatencyWindow::Percentiles& g2g =
+          props->glass_to_glass_percentiles_;
+      ImGui::TableNextColumn();
+      ImGui::Text("G2G");
+      ImGui::TableNextColumn();
+      ImGui::Text("p50 %.1f", g2g.p50_us / 1000.0f);
+      ImGui::TableNextColumn();
+      ImGui::Text("p95 %.1f", g2g.p95_us / 1000.0f);
+      ImGui::TableNextColumn();
+      ImGui::Text("p99 %.1f", g2g.p99_us / 1000.0f);
+    }
+
+    StageDisplay("Recv", receive_to_upload_us_metric_);
+    StageDisplay("Tex", texture_upload_us_metric_);
+
+    ImGui::TableNextColumn();
+    if (ImGui::SmallButton(
+            localization::dump_metrics[localization_language_index_].c_str())) {
+      DumpMetrics();
+    }
 
     ImGui::EndTable();
   }
@@ -160,6 +160,58 @@ int Render::SettingWindow() {
 
       ImGui::Separator();
 
+      {
+        const char* audio_frame_duration_items[] = {
+            "2.5 ms", "5 ms", "10 ms", "20 ms", "40 ms", "60 ms"};
+
+        settings_items_offset += settings_items_padding;
+        ImGui::SetCursorPosY(settings_items_offset + 4);
+        ImGui::Text(
+            "%s",
+            localization::audio_frame_duration[localization_language_index_]
+                .c_str());
+
+        if (ConfigCenter::LANGUAGE::CHINESE == localization_language_) {
+          ImGui::SetCursorPosX(AUDIO_FRAME_DURATION_SELECT_WINDOW_PADDING_CN);
+        } else {
+          ImGui::SetCursorPosX(AUDIO_FRAME_DURATION_SELECT_WINDOW_PADDING_EN);
+        }
+        ImGui::SetCursorPosY(settings_items_offset);
+        ImGui::SetNextItemWidth(SETTINGS_SELECT_WINDOW_WIDTH);
+
+        ImGui::Combo("##audio_frame_duration",
+                     &audio_frame_duration_button_value_,
+                     audio_frame_duration_items,
+                     IM_ARRAYSIZE(audio_frame_duration_items));
+      }
+
+      ImGui::Separator();
+
+      {
+        const char* audio_channels_items[] = {
+            localization::audio_mono[localization_language_index_].c_str(),
+            localization::audio_stereo[localization_language_index_].c_str()};
+
+        settings_items_offset += settings_items_padding;
+        ImGui::SetCursorPosY(settings_items_offset + 4);
+        ImGui::Text(
+            "%s",
+            localization::audio_channels[localization_language_index_].c_str());
+
+        if (ConfigCenter::LANGUAGE::CHINESE == localization_language_) {
+          ImGui::SetCursorPosX(AUDIO_CHANNELS_SELECT_WINDOW_PADDING_CN);
+        } else {
+          ImGui::SetCursorPosX(AUDIO_CHANNELS_SELECT_WINDOW_PADDING_EN);
+        }
+        ImGui::SetCursorPosY(settings_items_offset);
+        ImGui::SetNextItemWidth(SETTINGS_SELECT_WINDOW_WIDTH);
+
+        ImGui::Combo("##audio_channels", &audio_channels_button_value_,
+                     audio_channels_items, IM_ARRAYSIZE(audio_channels_items));
+      }
+
+      ImGui::Separator();
+
       {
         settings_items_offset += settings_items_padding;
         ImGui::SetCursorPosY(settings_items_offset + 4);
@@ -252,6 +304,26 @@ int Render::SettingWindow() {
         ImGui::SetCursorPosY(settings_items_offset);
         ImGui::Checkbox("##enable_autostart_", &enable_autostart_);
       }
+
+      ImGui::Separator();
+
+      {
+        settings_items_offset += settings_items_padding;
+        ImGui::SetCursorPosY(settings_items_offset + 4);
+
+        ImGui::Text("%s", localization::enable_local_cursor_prediction
+                              [localization_language_index_]
+                                  .c_str());
+
+        if (ConfigCenter::LANGUAGE::CHINESE == localization_language_) {
+          ImGui::SetCursorPosX(ENABLE_LOCAL_CURSOR_PREDICTION_PADDING_CN);
+        } else {
+          ImGui::SetCursorPosX(ENABLE_LOCAL_CURSOR_PREDICTION_PADDING_EN);
+        }
+        ImGui::SetCursorPosY(settings_items_offset);
+        ImGui::Checkbox("##enable_local_cursor_prediction_",
+                        &enable_local_cursor_prediction_);
+      }
 #if _WIN32
       ImGui::Separator();
 
@@ -335,6 +407,14 @@ int Render::SettingWindow() {
         video_encode_format_button_value_last_ =
             video_encode_format_button_value_;
 
+        // Audio frame duration and channels
+        config_center_->SetAudioFrameDuration(
+            AudioConfig::kFrameDurations[audio_frame_duration_button_value_]);
+        audio_frame_duration_button_value_last_ =
+            audio_frame_duration_button_value_;
+        config_center_->SetAudioChannels(audio_channels_button_value_ + 1);
+        audio_channels_button_value_last_ = audio_channels_button_value_;
+
         // Hardware video codec
         if (enable_hardware_video_codec_) {
           config_center_->SetHardwareVideoCodec(true);
@@ -373,6 +453,13 @@ int Render::SettingWindow() {
         }
         enable_autostart_last_ = enable_autostart_;
 
+        if (enable_local_cursor_prediction_) {
+          config_center_->SetLocalCursorPrediction(true);
+        } else {
+          config_center_->SetLocalCursorPrediction(false);
+        }
+        enable_local_cursor_prediction_last_ = enable_local_cursor_prediction_;
+
 #if _WIN32
         if (enable_minimize_to_tray_) {
           config_center_->SetMinimizeToTray(true);
@@ -421,6 +508,17 @@ int Render::SettingWindow() {
               video_encode_format_button_value_last_;
         }
 
+        if (audio_frame_duration_button_value_ !=
+            audio_frame_duration_button_value_last_) {
+          audio_frame_duration_button_value_ =
+              audio_frame_duration_button_value_last_;
+        }
+
+        if (audio_channels_button_value_ !=
+            audio_channels_button_value_last_) {
+          audio_channels_button_value_ = audio_channels_button_value_last_;
+        }
+
         if (enable_hardware_video_codec_ != enable_hardware_video_codec_last_) {
           enable_hardware_video_codec_ = enable_hardware_video_codec_last_;
         }
@@ -429,6 +527,12 @@ int Render::SettingWindow() {
           enable_turn_ = enable_turn_last_;
         }
 
+        if (enable_local_cursor_prediction_ !=
+            enable_local_cursor_prediction_last_) {
+          enable_local_cursor_prediction_ =
+              enable_local_cursor_prediction_last_;
+        }
+
         settings_window_pos_reset_ = true;
       }
       ImGui::SetWindowFontScale(1.0f);
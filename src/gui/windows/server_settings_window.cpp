@@ -91,6 +91,7 @@ int Render::ShowSimpleFileBrowser() {
           for (const auto& entry : std::filesystem::directory_iterator(
                    selected_current_file_path_)) {
             std::string name = entry.path().filename().string();
+            glyph_atlas_.AddText(name);
             if (entry.is_directory()) {
               if (ImGui::Selectable(name.c_str())) {
                 selected_current_file_path_ = entry.path().string();
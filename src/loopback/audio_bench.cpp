@@ -0,0 +1,355 @@
+// Audio cost benchmarks without devices or signalling, each mode runs
+// synthetic pcm through the same classes the host and viewer use.
+//   frames  per-frame overhead at every negotiable frame duration and
+//           channel layout, capture framing to viewer playout over
+//           LoopbackLink
+//   mixer   AudioMixer with 1 to 16 peers feeding one stereo output
+//   dsp     format conversion, remixing, resampling and the whole
+//           AudioConverter path for each capture backend format
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio_config.h"
+#include "audio_dsp.h"
+#include "audio_jitter_buffer.h"
+#include "audio_mixer.h"
+#include "loopback_link.h"
+#include "silence_detector.h"
+
+using namespace crossdesk;
+
+namespace {
+
+// ipv4, udp and rtp, srtp adds its auth tag on top
+constexpr int kPacketHeaderBytes = 20 + 8 + 12;
+
+struct Options {
+  // seconds of audio pushed through per setting, not wall time
+  int seconds = 20;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+double ElapsedUs(Clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(Clock::now() - start)
+      .count();
+}
+
+// a 440 Hz tone loud enough to pass the silence detector
+std::vector<int16_t> Tone(size_t frames, int channels) {
+  std::vector<int16_t> pcm(frames * channels);
+  for (size_t i = 0; i < frames; i++) {
+    int16_t value = (int16_t)(8000 * std::sin(2 * 3.14159265358979 * 440 * i /
+                                              AudioConfig::kSampleRate));
+    for (int c = 0; c < channels; c++) {
+      pcm[i * channels + c] = value;
+    }
+  }
+  return pcm;
+}
+
+struct FrameViewer {
+  AudioJitterBuffer jitter_buffer;
+  std::vector<uint8_t> playout;
+  uint64_t arrival_us = 0;
+  uint64_t frame_duration_us = 0;
+  size_t queued_bytes = 0;
+  std::atomic<uint64_t> frames{0};
+};
+
+void OnFrameViewerAudio(const char* data, size_t size, const char* user_id,
+                        size_t user_id_size, void* user_data) {
+  FrameViewer* viewer = (FrameViewer*)user_data;
+  // steady arrivals, the output holds two frames like a settled session
+  viewer->arrival_us += viewer->frame_duration_us;
+  viewer->playout.clear();
+  viewer->jitter_buffer.Put((const uint8_t*)data, size, viewer->queued_bytes,
+                            viewer->arrival_us, viewer->playout);
+  viewer->frames++;
+}
+
+int RunFrames(const Options& options) {
+  printf("%-9s %3s %7s %7s %11s %9s %10s %8s\n", "frame ms", "ch", "bytes",
+         "pkt/s", "hdr kbit/s", "hdr/pcm", "us/frame", "ms/s");
+
+  for (int channels = 1; channels <= AudioConfig::kMaxChannels; channels++) {
+    for (int duration_us : AudioConfig::kFrameDurations) {
+      AudioConfig config(duration_us, channels);
+      uint64_t frame_count = (uint64_t)options.seconds * 1000000 / duration_us;
+
+      // capture hands out 10 ms blocks whatever the frame duration is
+      size_t block_frames = AudioConfig::kSampleRate / 100;
+      std::vector<int16_t> block = Tone(block_frames, channels);
+      AudioConverter converter;
+      converter.Init(AudioConverter::SampleFormat::S16,
+                     AudioConfig::kSampleRate, channels, config);
+      SilenceDetector silence_detector;
+
+      FrameViewer viewer;
+      viewer.jitter_buffer.SetAudioConfig(config);
+      viewer.frame_duration_us = duration_us;
+      viewer.queued_bytes = config.FrameSizeBytes() * 2;
+
+      Params host_params;
+      memset(&host_params, 0, sizeof(Params));
+      host_params.user_id = "loopback-host";
+      Params viewer_params;
+      memset(&viewer_params, 0, sizeof(Params));
+      viewer_params.user_id = "C-loopback-viewer";
+      viewer_params.user_data = &viewer;
+      viewer_params.on_receive_audio_buffer = OnFrameViewerAudio;
+
+      LoopbackLink link(&host_params, &viewer_params,
+                        LoopbackLink::Conditions());
+      link.Start();
+
+      uint64_t sent = 0;
+      auto start = Clock::now();
+      while (sent < frame_count) {
+        converter.Process(
+            block.data(), block_frames,
+            [&](const uint8_t* frame, size_t size) {
+              if (sent >= frame_count) {
+                return;
+              }
+              silence_detector.Process((const int16_t*)frame,
+                                       size / sizeof(int16_t), duration_us);
+              link.SendAudioFrame(LoopbackLink::Side::A, (const char*)frame,
+                                  size, "audio");
+              sent++;
+            });
+      }
+      while (viewer.frames < sent) {
+        std::this_thread::yield();
+      }
+      double elapsed_us = ElapsedUs(start);
+      link.Stop();
+
+      double packets_per_s = 1000000.0 / duration_us;
+      double header_kbps = packets_per_s * kPacketHeaderBytes * 8 / 1000;
+      double pcm_kbps = config.BytesPerMs() * 8.0;
+      double us_per_frame = elapsed_us / sent;
+      printf("%-9.1f %3d %7zu %7.0f %11.1f %8.1f%% %10.2f %8.3f\n",
+             duration_us / 1000.0, channels, config.FrameSizeBytes(),
+             packets_per_s, header_kbps, header_kbps * 100 / pcm_kbps,
+             us_per_frame, us_per_frame * packets_per_s / 1000);
+    }
+  }
+  printf("\nhdr counts %d bytes of ipv4/udp/rtp per packet, ms/s is the cost "
+         "of one second of audio\n",
+         kPacketHeaderBytes);
+  return 0;
+}
+
+int RunMixer(const Options& options) {
+  AudioConfig output_config(AudioMixer::kMixBlockMs * 1000, 2);
+  AudioConfig source_config(AudioMixer::kMixBlockMs * 1000, 1);
+  uint64_t block_count =
+      (uint64_t)options.seconds * 1000 / AudioMixer::kMixBlockMs;
+  std::vector<int16_t> frame =
+      Tone(source_config.SamplesPerFrame(), source_config.channels);
+  std::vector<uint8_t> out;
+
+  printf("%-6s %12s %12s %10s\n", "peers", "put us/blk", "mix us/blk", "ms/s");
+  for (int peers = 1; peers <= 16; peers++) {
+    AudioMixer mixer;
+    mixer.SetOutputConfig(output_config);
+    std::vector<std::string> ids;
+    for (int i = 0; i < peers; i++) {
+      ids.push_back("peer-" + std::to_string(i));
+      mixer.SetSourceConfig(ids.back(), source_config);
+      // every other peer goes through the gain path
+      if (i % 2) {
+        mixer.SetGain(ids.back(), 0.8f);
+      }
+    }
+
+    double put_us = 0;
+    double mix_us = 0;
+    for (uint64_t block = 0; block < block_count; block++) {
+      uint64_t now_us = block * AudioMixer::kMixBlockMs * 1000;
+      auto start = Clock::now();
+      for (const std::string& id : ids) {
+        mixer.Put(id, (const uint8_t*)frame.data(),
+                  frame.size() * sizeof(int16_t), now_us);
+      }
+      put_us += ElapsedUs(start);
+
+      start = Clock::now();
+      out.clear();
+      mixer.Mix(output_config.FrameSizeBytes(), out);
+      mix_us += ElapsedUs(start);
+    }
+
+    double blocks_per_s = 1000.0 / AudioMixer::kMixBlockMs;
+    printf("%-6d %12.2f %12.2f %10.3f\n", peers, put_us / block_count,
+           mix_us / block_count,
+           (put_us + mix_us) / block_count * blocks_per_s / 1000);
+  }
+  printf("\nmono %d ms peers into stereo, ms/s is the cost of one second of "
+         "output\n",
+         AudioMixer::kMixBlockMs);
+  return 0;
+}
+
+// runs body over seconds of input in 10 ms blocks and prints the cost
+template <typename Body>
+void TimeDsp(const char* name, int rate, int channels, const Options& options,
+             Body body) {
+  size_t block_frames = rate / 100;
+  uint64_t block_count = (uint64_t)options.seconds * 100;
+  auto start = Clock::now();
+  for (uint64_t block = 0; block < block_count; block++) {
+    body(block_frames);
+  }
+  double elapsed_us = ElapsedUs(start);
+  double samples = (double)block_count * block_frames * channels;
+  printf("%-34s %10.2f %12.1f %10.0fx\n", name, elapsed_us * 1000 / samples,
+         samples / elapsed_us, options.seconds * 1e6 / elapsed_us);
+}
+
+int RunDsp(const Options& options) {
+  const int rate = AudioConfig::kSampleRate;
+  const int cd_rate = 44100;
+  size_t max_frames = rate / 100;
+  std::vector<int16_t> pcm = Tone(max_frames, 2);
+  std::vector<float> samples(max_frames * 2);
+  std::vector<float> remixed(max_frames * 2);
+  std::vector<float> resampled;
+  std::vector<int16_t> converted(max_frames * 2);
+  S16ToF32(pcm.data(), samples.data(), samples.size());
+
+  // keeps the results alive so nothing is optimised out
+  volatile uint64_t sink = 0;
+
+  printf("%-34s %10s %12s %11s\n", "stage", "ns/sample", "Msamples/s",
+         "realtime");
+  TimeDsp("s16 -> f32", rate, 2, options, [&](size_t frames) {
+    S16ToF32(pcm.data(), samples.data(), frames * 2);
+    sink = sink + (uint64_t)samples[frames];
+  });
+  TimeDsp("f32 -> s16", rate, 2, options, [&](size_t frames) {
+    F32ToS16(samples.data(), converted.data(), frames * 2);
+    sink = sink + converted[frames];
+  });
+  TimeDsp("remix 1 -> 2", rate, 1, options, [&](size_t frames) {
+    RemixChannels(samples.data(), 1, remixed.data(), 2, frames);
+    sink = sink + (uint64_t)remixed[frames];
+  });
+  TimeDsp("remix 2 -> 1", rate, 2, options, [&](size_t frames) {
+    RemixChannels(samples.data(), 2, remixed.data(), 1, frames);
+    sink = sink + (uint64_t)remixed[frames / 2];
+  });
+
+  const int resample_rates[][2] = {{cd_rate, rate}, {rate, cd_rate}};
+  for (const auto& rates : resample_rates) {
+    for (int channels = 1; channels <= 2; channels++) {
+      PolyphaseResampler resampler;
+      resampler.Init(rates[0], rates[1], channels);
+      std::string name = "resample " + std::to_string(rates[0]) + " -> " +
+                         std::to_string(rates[1]) + " ch" +
+                         std::to_string(channels);
+      TimeDsp(name.c_str(), rates[0], channels, options, [&](size_t frames) {
+        resampled.clear();
+        resampler.Process(samples.data(), frames, resampled);
+        sink = sink + resampled.size();
+      });
+    }
+  }
+
+  // what each capture backend hands to its converter
+  struct Backend {
+    const char* name;
+    AudioConverter::SampleFormat format;
+    int rate;
+    int channels;
+  };
+  const Backend backends[] = {
+      {"pulse s16 48k mono", AudioConverter::SampleFormat::S16, rate, 1},
+      {"wasapi f32 48k stereo", AudioConverter::SampleFormat::F32, rate, 2},
+      {"coreaudio f32 44.1k stereo", AudioConverter::SampleFormat::F32,
+       cd_rate, 2},
+  };
+  AudioConfig out_config;
+  for (const Backend& backend : backends) {
+    AudioConverter converter;
+    converter.Init(backend.format, backend.rate, backend.channels, out_config);
+    const void* input = backend.format == AudioConverter::SampleFormat::S16
+                            ? (const void*)pcm.data()
+                            : (const void*)samples.data();
+    std::string name = std::string("convert ") + backend.name;
+    TimeDsp(name.c_str(), backend.rate, backend.channels, options,
+            [&](size_t frames) {
+              converter.Process(input, frames,
+                                [&](const uint8_t* frame, size_t size) {
+                                  sink = sink + size;
+                                });
+            });
+  }
+
+  printf("\nconverters produce the canonical %d Hz, %d ms, %d channel s16, "
+         "realtime is seconds of input per second of cpu\n",
+         rate, out_config.frame_duration_us / 1000, out_config.channels);
+  return 0;
+}
+
+struct Mode {
+  const char* name;
+  int (*run)(const Options& options);
+};
+
+const Mode kModes[] = {
+    {"frames", RunFrames},
+    {"mixer", RunMixer},
+    {"dsp", RunDsp},
+};
+
+void Usage(const char* name) {
+  printf("usage: %s <mode> [--seconds N]\nmodes:", name);
+  for (const Mode& mode : kModes) {
+    printf(" %s", mode.name);
+  }
+  printf("\n");
+}
+
+bool ParseOptions(int argc, char* argv[], Options* options) {
+  for (int i = 2; i < argc; i++) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      return false;
+    }
+    const char* value = argv[++i];
+    if (arg == "--seconds") {
+      options->seconds = atoi(value);
+    } else {
+      return false;
+    }
+  }
+  return options->seconds > 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Options options;
+  if (argc < 2 || !ParseOptions(argc, argv, &options)) {
+    Usage(argv[0]);
+    return -1;
+  }
+
+  for (const Mode& mode : kModes) {
+    if (argv[1] == std::string(mode.name)) {
+      return mode.run(options);
+    }
+  }
+  Usage(argv[0]);
+  return -1;
+}
\ No newline at end of file
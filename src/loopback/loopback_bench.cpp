@@ -0,0 +1,461 @@
+// Headless capture -> send -> receive -> present run over LoopbackLink.
+// Synthetic NV12 frames go through the same VideoSendQueue the host uses,
+// input events through the viewer's DataChannelMux, and the receive side
+// copies frames out the way the stream window does before presenting.
+// With --mode file two FileTransfer instances move a generated file over
+// the link's data stream instead and the throughput is reported.
+// Only this repo's components are measured, the link calls replace the
+// minirtc peer, so results say nothing about minirtc's own overhead.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "data_channel_mux.h"
+#include "file_transfer.h"
+#include "loopback_link.h"
+#include "metrics.h"
+#include "video_send_queue.h"
+
+using namespace crossdesk;
+
+namespace {
+
+struct Options {
+  std::string mode = "pipeline";
+  int seconds = 10;
+  int width = 1920;
+  int height = 1080;
+  int fps = 60;
+  int input_hz = 125;
+  int file_mb = 256;
+  LoopbackLink::Conditions conditions;
+};
+
+class Samples {
+ public:
+  void Add(uint64_t value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    values_.push_back(value);
+  }
+
+  void Print(const char* name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (values_.empty()) {
+      printf("%-20s %8s\n", name, "-");
+      return;
+    }
+    std::sort(values_.begin(), values_.end());
+    auto at = [this](double q) {
+      return values_[std::min(values_.size() - 1,
+                              (size_t)(q * (values_.size() - 1) + 0.5))];
+    };
+    printf("%-20s %8zu %9.2f %9.2f %9.2f %9.2f\n", name, values_.size(),
+           at(0.5) / 1000.0, at(0.95) / 1000.0, at(0.99) / 1000.0,
+           values_.back() / 1000.0);
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<uint64_t> values_;
+};
+
+struct Viewer {
+  std::vector<unsigned char> present_buffer;
+  Samples receive_to_present;
+  Samples end_to_end;
+  Samples input;
+  std::atomic<uint64_t> frames{0};
+  std::atomic<uint64_t> bytes{0};
+};
+
+Viewer viewer;
+
+void OnViewerVideo(const XVideoFrame* video_frame, const char* user_id,
+                   size_t user_id_size, void* user_data) {
+  uint64_t receive_us = LoopbackLink::GetSystemTimeMicros();
+  // what the stream window does before it uploads the texture
+  if (viewer.present_buffer.size() < video_frame->size) {
+    viewer.present_buffer.resize(video_frame->size);
+  }
+  memcpy(viewer.present_buffer.data(), video_frame->data, video_frame->size);
+
+  uint64_t present_us = LoopbackLink::GetSystemTimeMicros();
+  viewer.receive_to_present.Add(present_us - receive_us);
+  viewer.end_to_end.Add(present_us - video_frame->captured_timestamp);
+  viewer.frames++;
+  viewer.bytes += video_frame->size;
+}
+
+void OnHostData(const char* data, size_t size, const char* user_id,
+                size_t user_id_size, void* user_data) {
+  // input events carry their send time
+  if (size < sizeof(uint64_t) + 1 || data[0] != 'i') {
+    return;
+  }
+  uint64_t sent_us;
+  memcpy(&sent_us, data + 1, sizeof(sent_us));
+  viewer.input.Add(LoopbackLink::GetSystemTimeMicros() - sent_us);
+}
+
+void Usage(const char* name) {
+  printf(
+      "usage: %s [--mode pipeline|file] [--seconds N] [--width W] "
+      "[--height H] [--fps N] [--input-hz N] [--file-mb N] [--delay MS] "
+      "[--jitter MS] [--loss RATE] [--bitrate BPS]\n",
+      name);
+}
+
+bool ParseOptions(int argc, char* argv[], Options* options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      return false;
+    }
+    const char* value = argv[++i];
+    if (arg == "--mode") {
+      options->mode = value;
+    } else if (arg == "--seconds") {
+      options->seconds = atoi(value);
+    } else if (arg == "--width") {
+      options->width = atoi(value) & ~1;
+    } else if (arg == "--height") {
+      options->height = atoi(value) & ~1;
+    } else if (arg == "--fps") {
+      options->fps = std::max(1, atoi(value));
+    } else if (arg == "--input-hz") {
+      options->input_hz = std::max(1, atoi(value));
+    } else if (arg == "--file-mb") {
+      options->file_mb = std::max(1, atoi(value));
+    } else if (arg == "--delay") {
+      options->conditions.delay_ms = atoi(value);
+    } else if (arg == "--jitter") {
+      options->conditions.jitter_ms = atoi(value);
+    } else if (arg == "--loss") {
+      options->conditions.loss_rate = (float)atof(value);
+    } else if (arg == "--bitrate") {
+      options->conditions.bitrate_bps = strtoull(value, nullptr, 10);
+    } else {
+      return false;
+    }
+  }
+  return (options->mode == "pipeline" || options->mode == "file") &&
+         options->width > 0 && options->height > 0 && options->seconds > 0;
+}
+
+int RunPipeline(const Options& options) {
+  Params host_params;
+  memset(&host_params, 0, sizeof(Params));
+  host_params.user_id = "loopback-host";
+  host_params.on_receive_data_buffer = OnHostData;
+
+  Params viewer_params;
+  memset(&viewer_params, 0, sizeof(Params));
+  viewer_params.user_id = "C-loopback-viewer";
+  viewer_params.on_receive_video_buffer = OnViewerVideo;
+
+  LoopbackLink link(&host_params, &viewer_params, options.conditions);
+  link.Start();
+
+  VideoSendQueue send_queue;
+  send_queue.Start([&link](const VideoSendQueue::Frame& send_frame) {
+    XVideoFrame frame;
+    frame.data = (const char*)send_frame.data.data();
+    frame.size = send_frame.data.size();
+    frame.width = send_frame.width;
+    frame.height = send_frame.height;
+    frame.captured_timestamp = send_frame.captured_timestamp;
+    return link.SendVideoFrame(LoopbackLink::Side::A, &frame,
+                               send_frame.stream_name.c_str());
+  });
+
+  DataChannelMux input_mux;
+  input_mux.SetSender([&link](const char* data, size_t size) {
+    return link.SendDataFrame(LoopbackLink::Side::B, data, size, "data");
+  });
+
+  std::atomic<bool> running{true};
+  Samples capture_to_queue;
+
+  // capture stand-in, a moving gradient so every frame differs
+  std::thread capture_thread([&]() {
+    std::vector<unsigned char> nv12(options.width * options.height * 3 / 2);
+    auto frame_interval = std::chrono::microseconds(1000000 / options.fps);
+    auto next_frame = std::chrono::steady_clock::now();
+    int frame_index = 0;
+    while (running) {
+      uint64_t captured_us = LoopbackLink::GetSystemTimeMicros();
+      for (int y = 0; y < options.height; y++) {
+        memset(nv12.data() + (size_t)y * options.width,
+               (y + frame_index) & 0xFF, options.width);
+      }
+      memset(nv12.data() + (size_t)options.width * options.height, 128,
+             nv12.size() - (size_t)options.width * options.height);
+
+      send_queue.Push(nv12.data(), nv12.size(), options.width, options.height,
+                      captured_us, "display");
+      capture_to_queue.Add(LoopbackLink::GetSystemTimeMicros() - captured_us);
+      frame_index++;
+
+      next_frame += frame_interval;
+      std::this_thread::sleep_until(next_frame);
+    }
+  });
+
+  std::thread input_thread([&]() {
+    auto input_interval = std::chrono::microseconds(1000000 / options.input_hz);
+    auto next_input = std::chrono::steady_clock::now();
+    while (running) {
+      std::string msg(1 + sizeof(uint64_t), 'i');
+      uint64_t sent_us = LoopbackLink::GetSystemTimeMicros();
+      memcpy(&msg[1], &sent_us, sizeof(sent_us));
+      input_mux.Send(DataChannelMux::Priority::INPUT, msg);
+      input_mux.Pump();
+
+      next_input += input_interval;
+      std::this_thread::sleep_until(next_input);
+    }
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  std::this_thread::sleep_for(std::chrono::seconds(options.seconds));
+  running = false;
+  capture_thread.join();
+  input_thread.join();
+  send_queue.Stop();
+  // let frames still on the simulated wire arrive
+  std::this_thread::sleep_for(std::chrono::milliseconds(
+      options.conditions.delay_ms + options.conditions.jitter_ms + 100));
+  link.Stop();
+  double elapsed_s = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+  VideoSendQueue::Stats queue_stats = send_queue.GetStats();
+  LoopbackLink::Stats link_stats = link.GetStats();
+  const LoopbackLink::StreamStats& video = link_stats.streams[0];
+
+  printf("%dx%d @ %d fps, delay %d ms, jitter %d ms, loss %.3f, bitrate %llu\n",
+         options.width, options.height, options.fps,
+         options.conditions.delay_ms, options.conditions.jitter_ms,
+         options.conditions.loss_rate,
+         (unsigned long long)options.conditions.bitrate_bps);
+  printf("\n%-20s %8s %9s %9s %9s %9s\n", "stage (ms)", "count", "p50", "p95",
+         "p99", "max");
+  capture_to_queue.Print("capture->queue");
+  printf("%-20s %8llu %9.2f %9s %9s %9.2f\n", "queue->send (avg)",
+         (unsigned long long)queue_stats.sent,
+         queue_stats.avg_latency_us / 1000.0, "-", "-",
+         queue_stats.max_latency_us / 1000.0);
+  printf("%-20s %8llu %9.2f %9s %9s %9.2f\n", "send->receive (avg)",
+         (unsigned long long)video.delivered, video.avg_transit_us / 1000.0,
+         "-", "-", video.max_transit_us / 1000.0);
+  viewer.receive_to_present.Print("receive->present");
+  viewer.end_to_end.Print("end to end");
+  viewer.input.Print("input");
+
+  printf("\nframes captured %llu, dropped in queue %llu, lost on link %llu, "
+         "presented %llu\n",
+         (unsigned long long)queue_stats.enqueued,
+         (unsigned long long)queue_stats.dropped,
+         (unsigned long long)video.lost,
+         (unsigned long long)viewer.frames.load());
+  printf("throughput %.1f fps, %.1f Mbit/s\n", viewer.frames / elapsed_s,
+         viewer.bytes * 8 / elapsed_s / 1e6);
+  printf("\n%s", MetricsRegistry::Global().Dump().c_str());
+  return 0;
+}
+
+// the link keeps the data stream reliable like minirtc does, file frames
+// are dropped here instead so --loss exercises the retransmit path
+class LossyFileSender {
+ public:
+  LossyFileSender(LoopbackLink& link, LoopbackLink::Side from, float loss_rate)
+      : link_(link), from_(from), loss_rate_(loss_rate) {}
+
+  int Send(const char* data, size_t size) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (std::uniform_real_distribution<float>(0, 1)(random_) < loss_rate_) {
+        dropped_++;
+        return 0;
+      }
+    }
+    return link_.SendDataFrame(from_, data, size, "file");
+  }
+
+  uint64_t Dropped() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dropped_;
+  }
+
+ private:
+  LoopbackLink& link_;
+  LoopbackLink::Side from_;
+  float loss_rate_;
+  std::mutex mutex_;
+  std::mt19937 random_{7};
+  uint64_t dropped_ = 0;
+};
+
+FileTransfer* host_file_transfer = nullptr;
+FileTransfer* viewer_file_transfer = nullptr;
+
+void OnHostFileData(const char* data, size_t size, const char* user_id,
+                    size_t user_id_size, void* user_data) {
+  host_file_transfer->OnMessage(data, size);
+}
+
+void OnViewerFileData(const char* data, size_t size, const char* user_id,
+                      size_t user_id_size, void* user_data) {
+  viewer_file_transfer->OnMessage(data, size);
+}
+
+bool SameContent(const std::filesystem::path& a,
+                 const std::filesystem::path& b) {
+  std::ifstream file_a(a, std::ios::binary);
+  std::ifstream file_b(b, std::ios::binary);
+  std::vector<char> buffer_a(1 << 20);
+  std::vector<char> buffer_b(1 << 20);
+  while (file_a && file_b) {
+    file_a.read(buffer_a.data(), buffer_a.size());
+    file_b.read(buffer_b.data(), buffer_b.size());
+    if (file_a.gcount() != file_b.gcount() ||
+        memcmp(buffer_a.data(), buffer_b.data(), file_a.gcount()) != 0) {
+      return false;
+    }
+  }
+  return !file_a && !file_b;
+}
+
+int RunFileTransfer(const Options& options) {
+  std::error_code ec;
+  std::filesystem::path work_dir =
+      std::filesystem::temp_directory_path() / "loopback_bench_files";
+  std::filesystem::remove_all(work_dir, ec);
+  std::filesystem::create_directories(work_dir / "received", ec);
+
+  std::filesystem::path source = work_dir / "payload.bin";
+  uint64_t file_size = (uint64_t)options.file_mb << 20;
+  {
+    std::ofstream out(source, std::ios::binary);
+    std::vector<char> block(1 << 20);
+    for (int i = 0; i < options.file_mb; i++) {
+      for (size_t j = 0; j < block.size(); j++) {
+        block[j] = (char)((j * 31 + i) & 0xFF);
+      }
+      out.write(block.data(), block.size());
+    }
+    if (!out) {
+      printf("write %s failed\n", source.u8string().c_str());
+      return -1;
+    }
+  }
+
+  Params host_params;
+  memset(&host_params, 0, sizeof(Params));
+  host_params.user_id = "loopback-host";
+  host_params.on_receive_data_buffer = OnHostFileData;
+
+  Params viewer_params;
+  memset(&viewer_params, 0, sizeof(Params));
+  viewer_params.user_id = "C-loopback-viewer";
+  viewer_params.on_receive_data_buffer = OnViewerFileData;
+
+  // the link is lossless for data, loss is applied by the senders
+  LoopbackLink::Conditions conditions = options.conditions;
+  conditions.loss_rate = 0;
+  LoopbackLink link(&host_params, &viewer_params, conditions);
+
+  FileTransfer host_transfer;
+  FileTransfer viewer_transfer;
+  host_file_transfer = &host_transfer;
+  viewer_file_transfer = &viewer_transfer;
+  LossyFileSender host_sender(link, LoopbackLink::Side::A,
+                              options.conditions.loss_rate);
+  LossyFileSender viewer_sender(link, LoopbackLink::Side::B,
+                                options.conditions.loss_rate);
+  host_transfer.SetSender([&host_sender](const char* data, size_t size) {
+    return host_sender.Send(data, size);
+  });
+  viewer_transfer.SetSender([&viewer_sender](const char* data, size_t size) {
+    return viewer_sender.Send(data, size);
+  });
+  viewer_transfer.SetSaveDirectory((work_dir / "received").u8string());
+  link.Start();
+
+  auto start = std::chrono::steady_clock::now();
+  auto deadline = start + std::chrono::seconds(options.seconds);
+  uint64_t id = host_transfer.SendFile(source.u8string());
+  if (id == 0) {
+    link.Stop();
+    return -1;
+  }
+
+  // pumped like the main loop does, every few milliseconds
+  FileTransfer::Progress result;
+  bool done = false;
+  while (!done && std::chrono::steady_clock::now() < deadline) {
+    host_transfer.Pump();
+    viewer_transfer.Pump();
+    for (const FileTransfer::Progress& progress : host_transfer.GetProgress()) {
+      if (progress.id == id) {
+        result = progress;
+        done = progress.finished || progress.failed;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  double elapsed_s = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+  link.Stop();
+
+  LoopbackLink::Stats link_stats = link.GetStats();
+  const LoopbackLink::StreamStats& data = link_stats.streams[2];
+  std::filesystem::path received = work_dir / "received" / "payload.bin";
+  bool verified = result.finished && SameContent(source, received);
+
+  printf("file %d MB, delay %d ms, jitter %d ms, loss %.3f, bitrate %llu\n",
+         options.file_mb, options.conditions.delay_ms,
+         options.conditions.jitter_ms, options.conditions.loss_rate,
+         (unsigned long long)options.conditions.bitrate_bps);
+  printf("\n%s in %.2f s, %llu of %llu bytes acknowledged, content %s\n",
+         result.finished ? "finished" : (result.failed ? "failed" : "timed out"),
+         elapsed_s, (unsigned long long)result.done_bytes,
+         (unsigned long long)file_size, verified ? "verified" : "mismatch");
+  printf("throughput %.2f MB/s\n", result.done_bytes / elapsed_s / 1e6);
+  printf("frames sent %llu, dropped %llu, delivered %llu, %.1f MB on the "
+         "wire\n",
+         (unsigned long long)(data.sent + host_sender.Dropped() +
+                              viewer_sender.Dropped()),
+         (unsigned long long)(host_sender.Dropped() + viewer_sender.Dropped()),
+         (unsigned long long)data.delivered, data.bytes / 1e6);
+
+  std::filesystem::remove_all(work_dir, ec);
+  return verified ? 0 : -1;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Options options;
+  if (!ParseOptions(argc, argv, &options)) {
+    Usage(argv[0]);
+    return -1;
+  }
+  if (options.mode == "file") {
+    return RunFileTransfer(options);
+  }
+  return RunPipeline(options);
+}
\ No newline at end of file
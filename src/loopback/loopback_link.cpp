@@ -0,0 +1,225 @@
+#include "loopback_link.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace crossdesk {
+
+static const char* UserId(const Params* params) {
+  return params->user_id ? params->user_id : "";
+}
+
+LoopbackLink::LoopbackLink(const Params* a, const Params* b,
+                           const Conditions& conditions)
+    : params_{a, b}, conditions_(conditions), random_(std::random_device{}()) {}
+
+LoopbackLink::~LoopbackLink() { Stop(); }
+
+uint64_t LoopbackLink::GetSystemTimeMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+int LoopbackLink::Start() {
+  if (running_) {
+    return 0;
+  }
+
+  running_ = true;
+  deliver_thread_ = std::thread(&LoopbackLink::DeliverLoop, this);
+
+  for (int i = 0; i < 2; i++) {
+    const Params* self = params_[i];
+    const Params* other = params_[1 - i];
+    if (self->on_connection_status) {
+      self->on_connection_status(ConnectionStatus::Connected, UserId(other),
+                                 strlen(UserId(other)), self->user_data);
+    }
+  }
+  return 0;
+}
+
+int LoopbackLink::Stop() {
+  if (!running_) {
+    return 0;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  cond_.notify_all();
+  if (deliver_thread_.joinable()) {
+    deliver_thread_.join();
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  packets_ = {};
+  for (int i = 0; i < 2; i++) {
+    const Params* self = params_[i];
+    const Params* other = params_[1 - i];
+    if (self->on_connection_status) {
+      self->on_connection_status(ConnectionStatus::Closed, UserId(other),
+                                 strlen(UserId(other)), self->user_data);
+    }
+  }
+  return 0;
+}
+
+void LoopbackLink::SetConditions(const Conditions& conditions) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  conditions_ = conditions;
+}
+
+int LoopbackLink::SendVideoFrame(Side from, const XVideoFrame* video_frame,
+                                 const char* stream_id) {
+  if (!video_frame || !video_frame->data) {
+    return -1;
+  }
+
+  Packet packet;
+  packet.width = video_frame->width;
+  packet.height = video_frame->height;
+  packet.captured_timestamp = video_frame->captured_timestamp;
+  return Enqueue(from, Stream::VIDEO, (const char*)video_frame->data,
+                 video_frame->size, std::move(packet));
+}
+
+int LoopbackLink::SendAudioFrame(Side from, const char* data, size_t size,
+                                 const char* stream_id) {
+  return Enqueue(from, Stream::AUDIO, data, size, Packet());
+}
+
+int LoopbackLink::SendDataFrame(Side from, const char* data, size_t size,
+                                const char* stream_id) {
+  return Enqueue(from, Stream::DATA, data, size, Packet());
+}
+
+int LoopbackLink::Enqueue(Side from, Stream stream, const char* data,
+                          size_t size, Packet packet) {
+  if (!running_ || !data) {
+    return -1;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  StreamStats& stats = stats_[(int)stream];
+  stats.sent++;
+  if (stream != Stream::DATA && conditions_.loss_rate > 0 &&
+      std::uniform_real_distribution<float>(0.0f, 1.0f)(random_) <
+          conditions_.loss_rate) {
+    stats.lost++;
+    return 0;
+  }
+
+  int direction = (int)from;
+  uint64_t now_us = GetSystemTimeMicros();
+  uint64_t due_us = now_us;
+  if (conditions_.bitrate_bps > 0) {
+    // serialization on a shared wire, big frames delay whatever follows
+    uint64_t wire_us = (uint64_t)size * 8 * 1000000 / conditions_.bitrate_bps;
+    wire_free_us_[direction] =
+        std::max(wire_free_us_[direction], now_us) + wire_us;
+    due_us = wire_free_us_[direction];
+  }
+  due_us += (uint64_t)conditions_.delay_ms * 1000;
+  if (conditions_.jitter_ms > 0) {
+    due_us += std::uniform_int_distribution<uint64_t>(
+        0, (uint64_t)conditions_.jitter_ms * 1000)(random_);
+  }
+  uint64_t& last_due_us = last_due_us_[direction][(int)stream];
+  due_us = std::max(due_us, last_due_us);
+  last_due_us = due_us;
+
+  packet.due_us = due_us;
+  packet.seq = seq_++;
+  packet.send_us = now_us;
+  packet.to = from == Side::A ? Side::B : Side::A;
+  packet.stream = stream;
+  packet.payload.assign(data, data + size);
+  packets_.push(std::move(packet));
+  cond_.notify_one();
+  return 0;
+}
+
+void LoopbackLink::DeliverLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (running_) {
+    if (packets_.empty()) {
+      cond_.wait(lock);
+      continue;
+    }
+
+    uint64_t now_us = GetSystemTimeMicros();
+    if (packets_.top().due_us > now_us) {
+      cond_.wait_for(lock,
+                     std::chrono::microseconds(packets_.top().due_us - now_us));
+      continue;
+    }
+
+    Packet packet = std::move(const_cast<Packet&>(packets_.top()));
+    packets_.pop();
+
+    StreamStats& stats = stats_[(int)packet.stream];
+    uint64_t transit_us = now_us - packet.send_us;
+    stats.delivered++;
+    stats.bytes += packet.payload.size();
+    stats.avg_transit_us =
+        stats.delivered == 1
+            ? transit_us
+            : (stats.avg_transit_us * 15 + transit_us) / 16;
+    stats.max_transit_us = std::max(stats.max_transit_us, transit_us);
+
+    // callbacks may send back into the link
+    lock.unlock();
+    Deliver(packet);
+    lock.lock();
+  }
+}
+
+void LoopbackLink::Deliver(const Packet& packet) {
+  const Params* receiver = params_[(int)packet.to];
+  const Params* sender = params_[1 - (int)packet.to];
+  const char* user_id = UserId(sender);
+  size_t user_id_size = strlen(user_id);
+
+  switch (packet.stream) {
+    case Stream::VIDEO:
+      if (receiver->on_receive_video_buffer) {
+        XVideoFrame video_frame;
+        video_frame.data = packet.payload.data();
+        video_frame.size = packet.payload.size();
+        video_frame.width = packet.width;
+        video_frame.height = packet.height;
+        video_frame.captured_timestamp = packet.captured_timestamp;
+        receiver->on_receive_video_buffer(&video_frame, user_id, user_id_size,
+                                          receiver->user_data);
+      }
+      break;
+    case Stream::AUDIO:
+      if (receiver->on_receive_audio_buffer) {
+        receiver->on_receive_audio_buffer(packet.payload.data(),
+                                          packet.payload.size(), user_id,
+                                          user_id_size, receiver->user_data);
+      }
+      break;
+    case Stream::DATA:
+      if (receiver->on_receive_data_buffer) {
+        receiver->on_receive_data_buffer(packet.payload.data(),
+                                         packet.payload.size(), user_id,
+                                         user_id_size, receiver->user_data);
+      }
+      break;
+  }
+}
+
+LoopbackLink::Stats LoopbackLink::GetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats stats;
+  for (int i = 0; i < kStreamCount; i++) {
+    stats.streams[i] = stats_[i];
+  }
+  return stats;
+}
+}  // namespace crossdesk
\ No newline at end of file
@@ -0,0 +1,123 @@
+/*
+ * @Author: DI JUNKUN
+ * @Date: 2026-10-19
+ * Copyright (c) 2026 by DI JUNKUN, All Rights Reserved.
+ */
+
+#ifndef _LOOPBACK_LINK_H_
+#define _LOOPBACK_LINK_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "minirtc.h"
+
+namespace crossdesk {
+
+// In-process stand-in for a minirtc connection between two Params. Frames
+// sent from one side reach the other side's on_receive_* callbacks after
+// the configured delay, jitter and loss, on a delivery thread like the
+// network callbacks of a real peer. No signalling server is involved.
+// It is not the minirtc peer api, there is no PeerPtr, so code written
+// against CreatePeer and friends can not run over it unchanged. Nothing
+// of minirtc itself, its transport, pacing or codecs, is exercised.
+class LoopbackLink {
+ public:
+  enum class Side { A = 0, B = 1 };
+  enum class Stream { VIDEO = 0, AUDIO = 1, DATA = 2 };
+  static constexpr int kStreamCount = 3;
+
+  struct Conditions {
+    int delay_ms = 0;
+    // uniform extra delay, streams stay in order like behind a jitter buffer
+    int jitter_ms = 0;
+    // media only, the data channel is reliable
+    float loss_rate = 0;
+    // 0 is unlimited, otherwise frames queue behind each other on the wire
+    uint64_t bitrate_bps = 0;
+  };
+
+  struct StreamStats {
+    uint64_t sent = 0;
+    uint64_t delivered = 0;
+    uint64_t lost = 0;
+    uint64_t bytes = 0;
+    uint64_t avg_transit_us = 0;
+    uint64_t max_transit_us = 0;
+  };
+
+  struct Stats {
+    StreamStats streams[kStreamCount];
+  };
+
+ public:
+  LoopbackLink(const Params* a, const Params* b, const Conditions& conditions);
+  ~LoopbackLink();
+
+ public:
+  // reports Connected to both sides, then delivers until Stop
+  int Start();
+  int Stop();
+  void SetConditions(const Conditions& conditions);
+
+  // the minirtc calls' arguments with a side instead of a PeerPtr
+  int SendVideoFrame(Side from, const XVideoFrame* video_frame,
+                     const char* stream_id);
+  int SendAudioFrame(Side from, const char* data, size_t size,
+                     const char* stream_id);
+  int SendDataFrame(Side from, const char* data, size_t size,
+                    const char* stream_id);
+
+  // the clock captured_timestamp is stamped with on both sides
+  static uint64_t GetSystemTimeMicros();
+  Stats GetStats();
+
+ private:
+  struct Packet {
+    uint64_t due_us = 0;
+    uint64_t seq = 0;
+    uint64_t send_us = 0;
+    Side to = Side::A;
+    Stream stream = Stream::VIDEO;
+    std::vector<char> payload;
+    int width = 0;
+    int height = 0;
+    uint64_t captured_timestamp = 0;
+
+    bool operator>(const Packet& other) const {
+      return due_us != other.due_us ? due_us > other.due_us : seq > other.seq;
+    }
+  };
+
+  int Enqueue(Side from, Stream stream, const char* data, size_t size,
+              Packet packet);
+  void DeliverLoop();
+  void Deliver(const Packet& packet);
+
+ private:
+  const Params* params_[2];
+  Conditions conditions_;
+  std::mt19937 random_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::priority_queue<Packet, std::vector<Packet>, std::greater<Packet>>
+      packets_;
+  uint64_t seq_ = 0;
+  // per direction and stream, keeps each stream in order
+  uint64_t last_due_us_[2][kStreamCount] = {};
+  uint64_t wire_free_us_[2] = {};
+  StreamStats stats_[kStreamCount];
+
+  std::thread deliver_thread_;
+  std::atomic<bool> running_{false};
+};
+}  // namespace crossdesk
+#endif
\ No newline at end of file
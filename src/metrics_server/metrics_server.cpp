@@ -0,0 +1,240 @@
+#include "metrics_server.h"
+
+#include <httplib.h>
+
+#include <cstdio>
+
+#include "metrics.h"
+#include "rd_log.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <psapi.h>
+#elif __APPLE__
+#include <mach/mach.h>
+#include <sys/resource.h>
+#elif __linux__
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace crossdesk {
+
+namespace {
+
+struct ProcessUsage {
+  uint64_t resident_bytes = 0;
+  double cpu_seconds = 0;
+};
+
+bool ReadProcessUsage(ProcessUsage* usage) {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                               sizeof(counters))) {
+    return false;
+  }
+  usage->resident_bytes = counters.WorkingSetSize;
+
+  FILETIME creation_time, exit_time, kernel_time, user_time;
+  if (!GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time,
+                       &kernel_time, &user_time)) {
+    return false;
+  }
+  auto to_100ns = [](const FILETIME& time) {
+    return ((uint64_t)time.dwHighDateTime << 32) | time.dwLowDateTime;
+  };
+  usage->cpu_seconds = (to_100ns(kernel_time) + to_100ns(user_time)) / 1e7;
+  return true;
+#elif __APPLE__
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info,
+                &count) != KERN_SUCCESS) {
+    return false;
+  }
+  usage->resident_bytes = info.resident_size;
+#elif __linux__
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (!statm) {
+    return false;
+  }
+  unsigned long long size_pages = 0, resident_pages = 0;
+  int fields = fscanf(statm, "%llu %llu", &size_pages, &resident_pages);
+  fclose(statm);
+  if (fields != 2) {
+    return false;
+  }
+  usage->resident_bytes = resident_pages * (uint64_t)sysconf(_SC_PAGESIZE);
+#endif
+
+#if defined(__APPLE__) || defined(__linux__)
+  struct rusage rusage;
+  if (getrusage(RUSAGE_SELF, &rusage) != 0) {
+    return false;
+  }
+  usage->cpu_seconds =
+      rusage.ru_utime.tv_sec + rusage.ru_stime.tv_sec +
+      (rusage.ru_utime.tv_usec + rusage.ru_stime.tv_usec) / 1e6;
+  return true;
+#endif
+}
+
+std::string EscapeLabel(const std::string& value) {
+  std::string escaped;
+  escaped.reserve(value.size());
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      escaped += '\\';
+      escaped += c;
+    } else if (c == '\n') {
+      escaped += "\\n";
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+void AppendType(std::string& text, const std::string& name,
+                const char* type) {
+  text += "# TYPE " + name + " " + type + "\n";
+}
+
+void AppendSample(std::string& text, const std::string& name,
+                  const std::string& labels, double value) {
+  char number[64];
+  snprintf(number, sizeof(number), "%.17g", value);
+  text += name;
+  if (!labels.empty()) {
+    text += "{" + labels + "}";
+  }
+  text += " ";
+  text += number;
+  text += "\n";
+}
+
+}  // namespace
+
+MetricsServer::MetricsServer() {}
+
+MetricsServer::~MetricsServer() { Stop(); }
+
+int MetricsServer::Start(int port) {
+  if (running_) {
+    return 0;
+  }
+
+  server_ = std::make_unique<httplib::Server>();
+  // one worker is plenty for a scraper
+  server_->new_task_queue = [] { return new httplib::ThreadPool(1); };
+  server_->Get("/metrics",
+               [this](const httplib::Request&, httplib::Response& res) {
+                 res.set_content(Exposition(),
+                                 "text/plain; version=0.0.4; charset=utf-8");
+               });
+
+  // never reachable from other machines
+  if (!server_->bind_to_port("127.0.0.1", port)) {
+    LOG_ERROR("Metrics server bind to 127.0.0.1:{} failed", port);
+    server_.reset();
+    return -1;
+  }
+
+  port_ = port;
+  running_ = true;
+  server_thread_ = std::thread([this]() { server_->listen_after_bind(); });
+  LOG_INFO("Metrics server listening on 127.0.0.1:{}", port_);
+  return 0;
+}
+
+int MetricsServer::Stop() {
+  if (!running_) {
+    return 0;
+  }
+
+  server_->stop();
+  if (server_thread_.joinable()) {
+    server_thread_.join();
+  }
+  server_.reset();
+  running_ = false;
+  LOG_INFO("Metrics server on port {} stopped", port_);
+  return 0;
+}
+
+void MetricsServer::SetPeerStats(const std::string& peer,
+                                 const PeerStats& stats) {
+  std::lock_guard<std::mutex> lock(peers_mutex_);
+  peers_[peer] = stats;
+}
+
+void MetricsServer::RemovePeer(const std::string& peer) {
+  std::lock_guard<std::mutex> lock(peers_mutex_);
+  peers_.erase(peer);
+}
+
+std::string MetricsServer::Exposition() {
+  std::string text;
+
+  for (const MetricsRegistry::Entry& entry :
+       MetricsRegistry::Global().Collect()) {
+    std::string name = "crossdesk_" + entry.name;
+    if (entry.type == MetricsRegistry::Type::COUNTER) {
+      name += "_total";
+      AppendType(text, name, "counter");
+      AppendSample(text, name, "", (double)entry.value);
+    } else if (entry.type == MetricsRegistry::Type::GAUGE) {
+      AppendType(text, name, "gauge");
+      AppendSample(text, name, "", (double)entry.value);
+    } else {
+      const MetricHistogram::Summary& summary = entry.summary;
+      AppendType(text, name, "summary");
+      AppendSample(text, name, "quantile=\"0.5\"", (double)summary.p50);
+      AppendSample(text, name, "quantile=\"0.95\"", (double)summary.p95);
+      AppendSample(text, name, "quantile=\"0.99\"", (double)summary.p99);
+      AppendSample(text, name + "_sum", "", (double)summary.sum);
+      AppendSample(text, name + "_count", "", (double)summary.count);
+    }
+  }
+
+  std::string bitrate_text;
+  std::string loss_text;
+  {
+    std::lock_guard<std::mutex> lock(peers_mutex_);
+    for (const auto& [peer, stats] : peers_) {
+      const std::pair<const char*, const StreamStats*> streams[] = {
+          {"video", &stats.video},
+          {"audio", &stats.audio},
+          {"data", &stats.data},
+          {"total", &stats.total}};
+      for (const auto& [stream, stream_stats] : streams) {
+        std::string labels = "peer=\"" + EscapeLabel(peer) + "\",stream=\"" +
+                             stream + "\"";
+        AppendSample(bitrate_text, "crossdesk_peer_bitrate_bps",
+                     labels + ",direction=\"in\"",
+                     stream_stats->inbound_bitrate);
+        AppendSample(bitrate_text, "crossdesk_peer_bitrate_bps",
+                     labels + ",direction=\"out\"",
+                     stream_stats->outbound_bitrate);
+        AppendSample(loss_text, "crossdesk_peer_loss_ratio", labels,
+                     stream_stats->inbound_loss_rate);
+      }
+    }
+  }
+  AppendType(text, "crossdesk_peer_bitrate_bps", "gauge");
+  text += bitrate_text;
+  AppendType(text, "crossdesk_peer_loss_ratio", "gauge");
+  text += loss_text;
+
+  ProcessUsage usage;
+  if (ReadProcessUsage(&usage)) {
+    AppendType(text, "process_resident_memory_bytes", "gauge");
+    AppendSample(text, "process_resident_memory_bytes", "",
+                 (double)usage.resident_bytes);
+    AppendType(text, "process_cpu_seconds_total", "counter");
+    AppendSample(text, "process_cpu_seconds_total", "", usage.cpu_seconds);
+  }
+  return text;
+}
+}  // namespace crossdesk
\ No newline at end of file
@@ -0,0 +1,68 @@
+/*
+ * @Author: DI JUNKUN
+ * @Date: 2026-10-19
+ * Copyright (c) 2026 by DI JUNKUN, All Rights Reserved.
+ */
+
+#ifndef _METRICS_SERVER_H_
+#define _METRICS_SERVER_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace httplib {
+class Server;
+}
+
+namespace crossdesk {
+
+// Serves the metrics registry, per peer network stats and process usage
+// in the Prometheus text format on 127.0.0.1. Requests are answered on
+// the server's own thread and never wait on the ui loop.
+class MetricsServer {
+ public:
+  struct StreamStats {
+    float inbound_bitrate = 0;
+    float outbound_bitrate = 0;
+    float inbound_loss_rate = 0;
+  };
+
+  struct PeerStats {
+    StreamStats video;
+    StreamStats audio;
+    StreamStats data;
+    StreamStats total;
+  };
+
+  static constexpr int kDefaultPort = 9464;
+
+ public:
+  MetricsServer();
+  ~MetricsServer();
+
+ public:
+  int Start(int port);
+  int Stop();
+  bool IsRunning() const { return running_; }
+
+  void SetPeerStats(const std::string& peer, const PeerStats& stats);
+  void RemovePeer(const std::string& peer);
+
+  // the exposition text, also what GET /metrics returns
+  std::string Exposition();
+
+ private:
+  std::unique_ptr<httplib::Server> server_;
+  std::thread server_thread_;
+  std::atomic<bool> running_{false};
+  int port_ = 0;
+
+  std::mutex peers_mutex_;
+  std::unordered_map<std::string, PeerStats> peers_;
+};
+}  // namespace crossdesk
+#endif
\ No newline at end of file
@@ -1,10 +1,13 @@
 #include "screen_capturer_x11.h"
 
 #include <chrono>
+#include <cstring>
 #include <thread>
 
 #include "libyuv.h"
+#include "metrics.h"
 #include "rd_log.h"
+#include "trace_recorder.h"
 
 namespace crossdesk {
 
@@ -60,6 +63,15 @@ int ScreenCapturerX11::Init(const int fps, cb_desktop_data cb) {
     }
   }
 
+  int xfixes_error_base = 0;
+  if (XFixesQueryExtension(display_, &xfixes_event_base_,
+                           &xfixes_error_base)) {
+    XFixesSelectCursorInput(display_, root_, XFixesDisplayCursorNotifyMask);
+    xfixes_available_ = true;
+  } else {
+    LOG_WARN("XFixes extension not available, cursor type is not reported");
+  }
+
   XWindowAttributes attr;
   XGetWindowAttributes(display_, root_, &attr);
 
@@ -103,6 +115,7 @@ int ScreenCapturerX11::Start(bool show_cursor) {
   running_ = true;
   paused_ = false;
   thread_ = std::thread([this]() {
+    TRACE_THREAD("capture");
     while (running_) {
       if (!paused_) OnFrame();
     }
@@ -137,6 +150,7 @@ std::vector<DisplayInfo> ScreenCapturerX11::GetDisplayInfoList() {
 }
 
 void ScreenCapturerX11::OnFrame() {
+  TRACE_SCOPE("ScreenCapturerX11::OnFrame");
   if (!display_) {
     LOG_ERROR("Display is not initialized");
     return;
@@ -147,14 +161,26 @@ void ScreenCapturerX11::OnFrame() {
     return;
   }
 
+  UpdateCursorInfo();
+
   left_ = display_info_list_[monitor_index_].left;
   top_ = display_info_list_[monitor_index_].top;
   width_ = display_info_list_[monitor_index_].width;
   height_ = display_info_list_[monitor_index_].height;
 
+  static MetricHistogram* grab_us =
+      MetricsRegistry::Global().Histogram("capture_grab_us");
+  static MetricHistogram* convert_us =
+      MetricsRegistry::Global().Histogram("capture_convert_us");
+  static MetricCounter* frames =
+      MetricsRegistry::Global().Counter("capture_frames");
+
+  uint64_t grab_start_us = MetricsRegistry::NowMicros();
   XImage* image = XGetImage(display_, root_, left_, top_, width_, height_,
                             AllPlanes, ZPixmap);
   if (!image) return;
+  uint64_t convert_start_us = MetricsRegistry::NowMicros();
+  grab_us->Record(convert_start_us - grab_start_us);
 
   bool needs_copy = image->bytes_per_line != width_ * 4;
   std::vector<uint8_t> argb_buf;
@@ -171,13 +197,18 @@ void ScreenCapturerX11::OnFrame() {
     src_argb = reinterpret_cast<uint8_t*>(image->data);
   }
 
-  libyuv::ARGBToNV12(src_argb, width_ * 4, y_plane_.data(), width_,
-                     uv_plane_.data(), width_, width_, height_);
+  {
+    TRACE_SCOPE("ARGBToNV12");
+    libyuv::ARGBToNV12(src_argb, width_ * 4, y_plane_.data(), width_,
+                       uv_plane_.data(), width_, width_, height_);
+  }
 
   std::vector<uint8_t> nv12;
   nv12.reserve(y_plane_.size() + uv_plane_.size());
   nv12.insert(nv12.end(), y_plane_.begin(), y_plane_.end());
   nv12.insert(nv12.end(), uv_plane_.begin(), uv_plane_.end());
+  convert_us->Record(MetricsRegistry::NowMicros() - convert_start_us);
+  frames->Add();
 
   if (callback_) {
     callback_(nv12.data(), width_ * height_ * 3 / 2, width_, height_,
@@ -186,4 +217,97 @@ void ScreenCapturerX11::OnFrame() {
 
   XDestroyImage(image);
 }
+
+int ScreenCapturerX11::GetCursorInfo(CursorInfo& cursor_info) {
+  if (!running_) {
+    return -1;
+  }
+
+  cursor_info.x = cursor_x_;
+  cursor_info.y = cursor_y_;
+  cursor_info.type = cursor_type_;
+  return 0;
+}
+
+void ScreenCapturerX11::UpdateCursorInfo() {
+  Window root_return, child_return;
+  int root_x = 0, root_y = 0, win_x = 0, win_y = 0;
+  unsigned int mask = 0;
+  if (XQueryPointer(display_, root_, &root_return, &child_return, &root_x,
+                    &root_y, &win_x, &win_y, &mask)) {
+    cursor_x_ = root_x;
+    cursor_y_ = root_y;
+  }
+
+  // cursor changes arrive as XFixes events, only the latest one matters
+  while (xfixes_available_ && XPending(display_) > 0) {
+    XEvent event;
+    XNextEvent(display_, &event);
+    if (event.type == xfixes_event_base_ + XFixesCursorNotify) {
+      auto* cursor_event = reinterpret_cast<XFixesCursorNotifyEvent*>(&event);
+      cursor_type_ = CursorTypeFromAtom(cursor_event->cursor_name);
+    }
+  }
+}
+
+CursorType ScreenCapturerX11::CursorTypeFromAtom(Atom cursor_name) {
+  if (cursor_name == None) {
+    return CursorType::ARROW;
+  }
+
+  char* name = XGetAtomName(display_, cursor_name);
+  if (!name) {
+    return CursorType::ARROW;
+  }
+
+  static const struct {
+    const char* name;
+    CursorType type;
+  } kCursorNames[] = {
+      {"xterm", CursorType::TEXT},
+      {"text", CursorType::TEXT},
+      {"ibeam", CursorType::TEXT},
+      {"hand1", CursorType::HAND},
+      {"hand2", CursorType::HAND},
+      {"pointer", CursorType::HAND},
+      {"pointing_hand", CursorType::HAND},
+      {"crosshair", CursorType::CROSSHAIR},
+      {"cross", CursorType::CROSSHAIR},
+      {"tcross", CursorType::CROSSHAIR},
+      {"sb_h_double_arrow", CursorType::RESIZE_EW},
+      {"h_double_arrow", CursorType::RESIZE_EW},
+      {"ew-resize", CursorType::RESIZE_EW},
+      {"col-resize", CursorType::RESIZE_EW},
+      {"size_hor", CursorType::RESIZE_EW},
+      {"sb_v_double_arrow", CursorType::RESIZE_NS},
+      {"v_double_arrow", CursorType::RESIZE_NS},
+      {"ns-resize", CursorType::RESIZE_NS},
+      {"row-resize", CursorType::RESIZE_NS},
+      {"size_ver", CursorType::RESIZE_NS},
+      {"fd_double_arrow", CursorType::RESIZE_NESW},
+      {"nesw-resize", CursorType::RESIZE_NESW},
+      {"size_bdiag", CursorType::RESIZE_NESW},
+      {"bd_double_arrow", CursorType::RESIZE_NWSE},
+      {"nwse-resize", CursorType::RESIZE_NWSE},
+      {"size_fdiag", CursorType::RESIZE_NWSE},
+      {"fleur", CursorType::RESIZE_ALL},
+      {"move", CursorType::RESIZE_ALL},
+      {"all-scroll", CursorType::RESIZE_ALL},
+      {"size_all", CursorType::RESIZE_ALL},
+      {"not-allowed", CursorType::NOT_ALLOWED},
+      {"crossed_circle", CursorType::NOT_ALLOWED},
+      {"forbidden", CursorType::NOT_ALLOWED},
+  };
+
+  CursorType type = CursorType::ARROW;
+  for (const auto& cursor : kCursorNames) {
+    if (strcmp(name, cursor.name) == 0) {
+      type = cursor.type;
+      break;
+    }
+  }
+
+  XFree(name);
+  return type;
+}
 }  // namespace crossdesk
\ No newline at end of file
@@ -41,8 +41,14 @@ class ScreenCapturerX11 : public ScreenCapturer {
 
   std::vector<DisplayInfo> GetDisplayInfoList() override;
 
+  int GetCursorInfo(CursorInfo& cursor_info) override;
+
   void OnFrame();
 
+ private:
+  void UpdateCursorInfo();
+  CursorType CursorTypeFromAtom(Atom cursor_name);
+
  private:
   Display* display_ = nullptr;
   Window root_ = 0;
@@ -66,6 +72,11 @@ class ScreenCapturerX11 : public ScreenCapturer {
   
   // 鼠标光标相关
   void DrawCursor(XImage* image, int x, int y);
+  bool xfixes_available_ = false;
+  int xfixes_event_base_ = 0;
+  std::atomic<int> cursor_x_{0};
+  std::atomic<int> cursor_y_{0};
+  std::atomic<CursorType> cursor_type_{CursorType::ARROW};
 };
 }  // namespace crossdesk
 #endif
\ No newline at end of file
@@ -9,6 +9,7 @@
 
 #include <functional>
 
+#include "cursor_info.h"
 #include "display_info.h"
 
 namespace crossdesk {
@@ -31,6 +32,9 @@ class ScreenCapturer {
 
   virtual std::vector<DisplayInfo> GetDisplayInfoList() = 0;
   virtual int SwitchTo(int monitor_index) = 0;
+
+  // latest cursor state seen by the capturer, -1 if not supported
+  virtual int GetCursorInfo(CursorInfo& cursor_info) { return -1; }
 };
 }  // namespace crossdesk
 #endif
\ No newline at end of file
@@ -8,7 +8,9 @@
 #include <iostream>
 
 #include "libyuv.h"
+#include "metrics.h"
 #include "rd_log.h"
+#include "trace_recorder.h"
 
 namespace crossdesk {
 
@@ -256,15 +258,26 @@ int ScreenCapturerWgc::SwitchTo(int monitor_index) {
 
 void ScreenCapturerWgc::OnFrame(const WgcSession::wgc_session_frame& frame,
                                 int id) {
+  static MetricHistogram* convert_us =
+      MetricsRegistry::Global().Histogram("capture_convert_us");
+  static MetricCounter* frames =
+      MetricsRegistry::Global().Counter("capture_frames");
+
   if (on_data_) {
     if (!nv12_frame_) {
       nv12_frame_ = new unsigned char[frame.width * frame.height * 3 / 2];
     }
 
-    libyuv::ARGBToNV12((const uint8_t*)frame.data, frame.width * 4,
-                       (uint8_t*)nv12_frame_, frame.width,
-                       (uint8_t*)(nv12_frame_ + frame.width * frame.height),
-                       frame.width, frame.width, frame.height);
+    uint64_t convert_start_us = MetricsRegistry::NowMicros();
+    {
+      TRACE_SCOPE("ARGBToNV12");
+      libyuv::ARGBToNV12((const uint8_t*)frame.data, frame.width * 4,
+                         (uint8_t*)nv12_frame_, frame.width,
+                         (uint8_t*)(nv12_frame_ + frame.width * frame.height),
+                         frame.width, frame.width, frame.height);
+    }
+    convert_us->Record(MetricsRegistry::NowMicros() - convert_start_us);
+    frames->Add();
 
     on_data_(nv12_frame_, frame.width * frame.height * 3 / 2, frame.width,
              frame.height, display_info_list_[id].name.c_str());
@@ -3,21 +3,19 @@
 #include <pulse/error.h>
 #include <pulse/introspect.h>
 
-#include <condition_variable>
-#include <iostream>
-#include <thread>
+#include <algorithm>
 
 #include "rd_log.h"
 
 namespace crossdesk {
 
-constexpr int kSampleRate = 48000;
 constexpr pa_sample_format_t kFormat = PA_SAMPLE_S16LE;
-constexpr int kChannels = 1;
-constexpr size_t kFrameSizeBytes = 480 * sizeof(int16_t);
 
 SpeakerCapturerLinux::SpeakerCapturerLinux()
-    : inited_(false), paused_(false), stop_flag_(false) {}
+    : inited_(false),
+      paused_(false),
+      frame_cache_(AudioConfig::MaxFrameSizeBytes()),
+      frame_buffer_(AudioConfig::MaxFrameSizeBytes()) {}
 SpeakerCapturerLinux::~SpeakerCapturerLinux() {
   Stop();
   Destroy();
@@ -26,224 +24,236 @@ SpeakerCapturerLinux::~SpeakerCapturerLinux() {
 int SpeakerCapturerLinux::Init(speaker_data_cb cb) {
   if (inited_) return 0;
   cb_ = cb;
-  inited_ = true;
-  return 0;
-}
-
-int SpeakerCapturerLinux::Destroy() {
-  inited_ = false;
-  return 0;
-}
-
-std::string SpeakerCapturerLinux::GetDefaultMonitorSourceName() {
-  std::string monitor_name;
-  std::mutex mtx;
-  std::condition_variable cv;
-  bool ready = false;
 
-  pa_mainloop* mainloop = pa_mainloop_new();
-  pa_mainloop_api* api = pa_mainloop_get_api(mainloop);
-  pa_context* context = pa_context_new(api, "GetMonitor");
-
-  struct CallbackState {
-    std::string* name;
-    std::mutex* mtx;
-    std::condition_variable* cv;
-    bool* ready;
-  } state{&monitor_name, &mtx, &cv, &ready};
+  mainloop_ = pa_threaded_mainloop_new();
+  if (!mainloop_) {
+    LOG_ERROR("Failed to create mainloop");
+    return -1;
+  }
 
+  context_ = pa_context_new(pa_threaded_mainloop_get_api(mainloop_),
+                            "SpeakerCapturer");
   pa_context_set_state_callback(
-      context,
+      context_,
       [](pa_context* c, void* userdata) {
-        auto* state = static_cast<CallbackState*>(userdata);
-        if (pa_context_get_state(c) == PA_CONTEXT_READY) {
-          pa_operation* operation = pa_context_get_server_info(
-              c,
-              [](pa_context*, const pa_server_info* info, void* userdata) {
-                auto* state = static_cast<CallbackState*>(userdata);
-                if (info && info->default_sink_name) {
-                  *(state->name) =
-                      std::string(info->default_sink_name) + ".monitor";
-                }
-                {
-                  std::lock_guard<std::mutex> lock(*(state->mtx));
-                  *(state->ready) = true;
-                }
-                state->cv->notify_one();
-              },
-              userdata);
-          if (operation) {
-            pa_operation_unref(operation);
-          }
+        auto self = static_cast<SpeakerCapturerLinux*>(userdata);
+        pa_context_state_t state = pa_context_get_state(c);
+        if (state == PA_CONTEXT_READY || state == PA_CONTEXT_FAILED ||
+            state == PA_CONTEXT_TERMINATED) {
+          pa_threaded_mainloop_signal(self->mainloop_, 0);
+        }
+      },
+      this);
+
+  // follow the default sink, the monitor source changes with it
+  pa_context_set_subscribe_callback(
+      context_,
+      [](pa_context*, pa_subscription_event_type_t type, uint32_t,
+         void* userdata) {
+        auto self = static_cast<SpeakerCapturerLinux*>(userdata);
+        int facility = type & PA_SUBSCRIPTION_EVENT_FACILITY_MASK;
+        if (facility == PA_SUBSCRIPTION_EVENT_SERVER ||
+            facility == PA_SUBSCRIPTION_EVENT_SINK) {
+          self->RequestServerInfo();
         }
       },
-      &state);
+      this);
 
-  pa_context_connect(context, nullptr, PA_CONTEXT_NOFLAGS, nullptr);
+  if (pa_threaded_mainloop_start(mainloop_) < 0) {
+    LOG_ERROR("Failed to start mainloop");
+    Cleanup();
+    return -1;
+  }
 
-  std::thread loop_thread([&]() {
-    int ret = 0;
-    pa_mainloop_run(mainloop, &ret);
-  });
+  pa_threaded_mainloop_lock(mainloop_);
 
-  {
-    std::unique_lock<std::mutex> lock(mtx);
-    cv.wait_for(lock, std::chrono::seconds(2), [&] { return ready; });
+  if (pa_context_connect(context_, nullptr, PA_CONTEXT_NOFLAGS, nullptr) <
+      0) {
+    LOG_ERROR("Failed to connect context");
+    pa_threaded_mainloop_unlock(mainloop_);
+    Cleanup();
+    return -1;
   }
 
-  pa_context_disconnect(context);
-  pa_context_unref(context);
-  pa_mainloop_quit(mainloop, 0);
-  loop_thread.join();
-  pa_mainloop_free(mainloop);
+  while (true) {
+    pa_context_state_t state = pa_context_get_state(context_);
+    if (state == PA_CONTEXT_READY) break;
+    if (!PA_CONTEXT_IS_GOOD(state)) {
+      LOG_ERROR("Failed to connect to pulseaudio server");
+      pa_threaded_mainloop_unlock(mainloop_);
+      Cleanup();
+      return -1;
+    }
+    pa_threaded_mainloop_wait(mainloop_);
+  }
 
-  return monitor_name;
-}
+  pa_operation* operation = pa_context_subscribe(
+      context_,
+      (pa_subscription_mask_t)(PA_SUBSCRIPTION_MASK_SERVER |
+                               PA_SUBSCRIPTION_MASK_SINK),
+      nullptr, nullptr);
+  if (operation) {
+    pa_operation_unref(operation);
+  }
 
-int SpeakerCapturerLinux::Start() {
-  if (!inited_ || mainloop_thread_.joinable()) return -1;
-  stop_flag_ = false;
+  RequestServerInfo();
+  while (!server_info_ready_ &&
+         PA_CONTEXT_IS_GOOD(pa_context_get_state(context_))) {
+    pa_threaded_mainloop_wait(mainloop_);
+  }
 
-  mainloop_thread_ = std::thread([this]() {
-    std::string monitor_name = GetDefaultMonitorSourceName();
-    if (monitor_name.empty()) {
-      LOG_ERROR("Failed to get monitor source");
-      return;
-    }
+  pa_threaded_mainloop_unlock(mainloop_);
 
-    mainloop_ = pa_threaded_mainloop_new();
-    pa_mainloop_api* api = pa_threaded_mainloop_get_api(mainloop_);
-    context_ = pa_context_new(api, "SpeakerCapturer");
-
-    pa_context_set_state_callback(
-        context_,
-        [](pa_context* c, void* userdata) {
-          auto self = static_cast<SpeakerCapturerLinux*>(userdata);
-          pa_context_state_t state = pa_context_get_state(c);
-          if (state == PA_CONTEXT_READY || state == PA_CONTEXT_FAILED ||
-              state == PA_CONTEXT_TERMINATED) {
-            pa_threaded_mainloop_signal(self->mainloop_, 0);
-          }
-        },
-        this);
-
-    if (pa_threaded_mainloop_start(mainloop_) < 0) {
-      LOG_ERROR("Failed to start mainloop");
-      Cleanup();
-      return;
-    }
+  if (monitor_name_.empty()) {
+    LOG_ERROR("Failed to get monitor source");
+    Cleanup();
+    return -1;
+  }
 
-    pa_threaded_mainloop_lock(mainloop_);
+  inited_ = true;
+  return 0;
+}
 
-    if (pa_context_connect(context_, nullptr, PA_CONTEXT_NOFLAGS, nullptr) <
-        0) {
-      LOG_ERROR("Failed to connect context");
-      pa_threaded_mainloop_unlock(mainloop_);
-      Cleanup();
-      return;
-    }
+int SpeakerCapturerLinux::Destroy() {
+  Stop();
+  Cleanup();
+  inited_ = false;
+  return 0;
+}
 
-    while (true) {
-      pa_context_state_t state = pa_context_get_state(context_);
-      if (state == PA_CONTEXT_READY) break;
-      if (!PA_CONTEXT_IS_GOOD(state) || stop_flag_) {
-        pa_threaded_mainloop_unlock(mainloop_);
-        Cleanup();
-        return;
-      }
-      pa_threaded_mainloop_wait(mainloop_);
-    }
+int SpeakerCapturerLinux::SetAudioConfig(const AudioConfig& audio_config) {
+  if (capturing_) {
+    LOG_ERROR("Audio config can not be changed while capturing");
+    return -1;
+  }
+
+  audio_config_ = audio_config;
+  frame_size_bytes_ = audio_config_.FrameSizeBytes();
+  frame_cache_.Clear();
+  return 0;
+}
+
+int SpeakerCapturerLinux::Start() {
+  if (!inited_) return -1;
 
-    pa_sample_spec ss = {kFormat, kSampleRate, kChannels};
-    stream_ = pa_stream_new(context_, "Capture", &ss, nullptr);
+  pa_threaded_mainloop_lock(mainloop_);
+  int ret = 0;
+  if (!capturing_) {
+    ret = CreateStream();
+    capturing_ = (0 == ret);
+  }
+  pa_threaded_mainloop_unlock(mainloop_);
 
-    pa_stream_set_read_callback(
-        stream_,
-        [](pa_stream* s, size_t len, void* u) {
-          auto self = static_cast<SpeakerCapturerLinux*>(u);
-          if (self->paused_ || self->stop_flag_) return;
+  return ret;
+}
 
-          const void* data = nullptr;
-          if (pa_stream_peek(s, &data, &len) < 0 || !data) return;
+int SpeakerCapturerLinux::Stop() {
+  if (!mainloop_) return 0;
 
-          const uint8_t* p = static_cast<const uint8_t*>(data);
-          self->frame_cache_.insert(self->frame_cache_.end(), p, p + len);
+  pa_threaded_mainloop_lock(mainloop_);
+  capturing_ = false;
+  DestroyStream();
+  pa_threaded_mainloop_unlock(mainloop_);
 
-          while (self->frame_cache_.size() >= kFrameSizeBytes) {
-            std::vector<uint8_t> temp_frame(
-                self->frame_cache_.begin(),
-                self->frame_cache_.begin() + kFrameSizeBytes);
-            self->cb_(temp_frame.data(), kFrameSizeBytes, "audio");
-            self->frame_cache_.erase(
-                self->frame_cache_.begin(),
-                self->frame_cache_.begin() + kFrameSizeBytes);
-          }
+  return 0;
+}
 
-          pa_stream_drop(s);
-        },
-        this);
-
-    pa_buffer_attr attr = {.maxlength = (uint32_t)-1,
-                           .tlength = 0,
-                           .prebuf = 0,
-                           .minreq = 0,
-                           .fragsize = (uint32_t)kFrameSizeBytes};
-
-    if (pa_stream_connect_record(stream_, monitor_name.c_str(), &attr,
-                                 PA_STREAM_ADJUST_LATENCY) < 0) {
-      LOG_ERROR("Failed to connect stream");
-      pa_threaded_mainloop_unlock(mainloop_);
-      Cleanup();
-      return;
-    }
+int SpeakerCapturerLinux::CreateStream() {
+  pa_sample_spec ss = {kFormat, AudioConfig::kSampleRate,
+                       (uint8_t)audio_config_.channels};
+  stream_ = pa_stream_new(context_, "Capture", &ss, nullptr);
+  if (!stream_) {
+    LOG_ERROR("Failed to create stream");
+    return -1;
+  }
 
-    while (true) {
-      pa_stream_state_t s = pa_stream_get_state(stream_);
-      if (s == PA_STREAM_READY) break;
-      if (!PA_STREAM_IS_GOOD(s) || stop_flag_) {
-        pa_threaded_mainloop_unlock(mainloop_);
-        Cleanup();
-        return;
-      }
-      pa_threaded_mainloop_wait(mainloop_);
-    }
+  pa_stream_set_read_callback(
+      stream_,
+      [](pa_stream* s, size_t len, void* u) {
+        auto self = static_cast<SpeakerCapturerLinux*>(u);
 
-    pa_threaded_mainloop_unlock(mainloop_);
+        const void* data = nullptr;
+        if (pa_stream_peek(s, &data, &len) < 0) return;
+
+        // a hole in the stream still has to be dropped
+        if (data && len > 0 && !self->paused_) {
+          self->OnStreamRead(static_cast<const uint8_t*>(data), len);
+        }
 
-    while (!stop_flag_)
-      std::this_thread::sleep_for(std::chrono::milliseconds(100));
-  });
+        if (len > 0) {
+          pa_stream_drop(s);
+        }
+      },
+      this);
+
+  pa_buffer_attr attr = {.maxlength = (uint32_t)-1,
+                         .tlength = 0,
+                         .prebuf = 0,
+                         .minreq = 0,
+                         .fragsize = (uint32_t)frame_size_bytes_};
+
+  if (pa_stream_connect_record(stream_, monitor_name_.c_str(), &attr,
+                               PA_STREAM_ADJUST_LATENCY) < 0) {
+    LOG_ERROR("Failed to connect stream to [{}]", monitor_name_);
+    pa_stream_unref(stream_);
+    stream_ = nullptr;
+    return -1;
+  }
 
   return 0;
 }
 
-int SpeakerCapturerLinux::Stop() {
-  stop_flag_ = true;
+void SpeakerCapturerLinux::DestroyStream() {
+  if (stream_) {
+    pa_stream_set_read_callback(stream_, nullptr, nullptr);
+    pa_stream_disconnect(stream_);
+    pa_stream_unref(stream_);
+    stream_ = nullptr;
+  }
 
-  if (mainloop_) {
-    pa_threaded_mainloop_lock(mainloop_);
-    pa_threaded_mainloop_signal(mainloop_, 0);
-    pa_threaded_mainloop_unlock(mainloop_);
+  frame_cache_.Clear();
+}
+
+void SpeakerCapturerLinux::RequestServerInfo() {
+  pa_operation* operation = pa_context_get_server_info(
+      context_,
+      [](pa_context*, const pa_server_info* info, void* userdata) {
+        auto self = static_cast<SpeakerCapturerLinux*>(userdata);
+        self->OnServerInfo(info);
+        pa_threaded_mainloop_signal(self->mainloop_, 0);
+      },
+      this);
+  if (operation) {
+    pa_operation_unref(operation);
   }
+}
 
-  if (mainloop_thread_.joinable()) {
-    mainloop_thread_.join();
+void SpeakerCapturerLinux::OnServerInfo(const pa_server_info* info) {
+  server_info_ready_ = true;
+  if (!info || !info->default_sink_name) {
+    return;
   }
 
-  Cleanup();
-  return 0;
+  std::string monitor_name = std::string(info->default_sink_name) + ".monitor";
+  if (monitor_name == monitor_name_) {
+    return;
+  }
+
+  LOG_INFO("Speaker capturer use monitor source [{}]", monitor_name);
+  monitor_name_ = monitor_name;
+
+  // runs on the mainloop thread, the lock is already held
+  if (capturing_) {
+    DestroyStream();
+    capturing_ = (0 == CreateStream());
+  }
 }
 
 void SpeakerCapturerLinux::Cleanup() {
   if (mainloop_) {
     pa_threaded_mainloop_stop(mainloop_);
-    pa_threaded_mainloop_lock(mainloop_);
 
-    if (stream_) {
-      pa_stream_disconnect(stream_);
-      pa_stream_unref(stream_);
-      stream_ = nullptr;
-    }
+    DestroyStream();
 
     if (context_) {
       pa_context_disconnect(context_);
@@ -251,12 +261,45 @@ void SpeakerCapturerLinux::Cleanup() {
       context_ = nullptr;
     }
 
-    pa_threaded_mainloop_unlock(mainloop_);
     pa_threaded_mainloop_free(mainloop_);
     mainloop_ = nullptr;
   }
 
-  frame_cache_.clear();
+  monitor_name_.clear();
+  server_info_ready_ = false;
+  frame_cache_.Clear();
+}
+
+void SpeakerCapturerLinux::OnStreamRead(const uint8_t* data, size_t len) {
+  const size_t frame_size = frame_size_bytes_;
+
+  // complete a frame left over from the previous read first
+  size_t cached = frame_cache_.Size();
+  if (cached > 0) {
+    size_t fill = std::min(len, frame_size - cached);
+    frame_cache_.Write(data, fill);
+    data += fill;
+    len -= fill;
+
+    if (frame_cache_.Size() < frame_size) {
+      return;
+    }
+
+    frame_cache_.Read(frame_buffer_.data(), frame_size);
+    cb_(frame_buffer_.data(), frame_size, "audio");
+  }
+
+  // frame aligned data goes out straight from the pulse buffer, the
+  // callback only reads it
+  while (len >= frame_size) {
+    cb_(const_cast<uint8_t*>(data), frame_size, "audio");
+    data += frame_size;
+    len -= frame_size;
+  }
+
+  if (len > 0) {
+    frame_cache_.Write(data, len);
+  }
 }
 
 int SpeakerCapturerLinux::Pause() {
@@ -11,11 +11,10 @@
 
 #include <atomic>
 #include <functional>
-#include <mutex>
 #include <string>
-#include <thread>
 #include <vector>
 
+#include "audio_ring_buffer.h"
 #include "speaker_capturer.h"
 
 namespace crossdesk {
@@ -29,28 +28,40 @@ class SpeakerCapturerLinux : public SpeakerCapturer {
   int Destroy() override;
   int Start() override;
   int Stop() override;
+  int SetAudioConfig(const AudioConfig& audio_config) override;
 
   int Pause();
   int Resume();
 
  private:
-  std::string GetDefaultMonitorSourceName();
+  // called with the mainloop lock held or from the mainloop thread
+  int CreateStream();
+  void DestroyStream();
+  void RequestServerInfo();
+  void OnServerInfo(const pa_server_info* info);
+  void OnStreamRead(const uint8_t* data, size_t len);
   void Cleanup();
 
  private:
   speaker_data_cb cb_ = nullptr;
+  AudioConfig audio_config_;
+  size_t frame_size_bytes_ = AudioConfig().FrameSizeBytes();
 
   std::atomic<bool> inited_;
   std::atomic<bool> paused_;
-  std::atomic<bool> stop_flag_;
+  bool capturing_ = false;
 
-  std::thread mainloop_thread_;
+  // mainloop and context live as long as the capturer, only the record
+  // stream is created and destroyed by Start and Stop
   pa_threaded_mainloop* mainloop_ = nullptr;
   pa_context* context_ = nullptr;
   pa_stream* stream_ = nullptr;
+  std::string monitor_name_;
+  bool server_info_ready_ = false;
 
-  std::mutex state_mtx_;
-  std::vector<uint8_t> frame_cache_;
+  // holds the tail of a read that did not end on a frame boundary
+  AudioRingBuffer frame_cache_;
+  std::vector<uint8_t> frame_buffer_;
 };
 }  // namespace crossdesk
 #endif
\ No newline at end of file
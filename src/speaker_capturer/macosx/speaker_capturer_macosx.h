@@ -10,6 +10,7 @@
 #include <thread>
 #include <vector>
 
+#include "audio_dsp.h"
 #include "speaker_capturer.h"
 
 namespace crossdesk {
@@ -24,13 +25,23 @@ class SpeakerCapturerMacosx : public SpeakerCapturer {
   virtual int Destroy();
   virtual int Start();
   virtual int Stop();
+  virtual int SetAudioConfig(const AudioConfig& audio_config);
 
   int Pause();
   int Resume();
 
+  // (re)initializes the converter when the delivered format changes
+  int PrepareConverter(bool is_float, int sample_rate, int channels);
+
  public:
   speaker_data_cb cb_ = nullptr;
   bool inited_ = false;
+  AudioConfig audio_config_;
+  AudioConverter converter_;
+  bool converter_ready_ = false;
+  bool converter_float_ = false;
+  int converter_rate_ = 0;
+  int converter_channels_ = 0;
 
   class Impl;
   Impl* impl_ = nullptr;
@@ -37,14 +37,28 @@ class SpeakerCapturerMacosx;
       CMAudioFormatDescriptionGetStreamBasicDescription(formatDesc);
 
   if (_owner->cb_ && dataPtr && length > 0 && asbd) {
-    std::vector<short> out_pcm16;
-    // ... 数据转换逻辑保持不变 ...
-    // 调用回调
-    size_t frame_bytes = 960;  // 480 * 2
-    size_t total_bytes = out_pcm16.size() * sizeof(short);
-    unsigned char* p = (unsigned char*)out_pcm16.data();
-    for (size_t offset = 0; offset + frame_bytes <= total_bytes; offset += frame_bytes) {
-      _owner->cb_(p + offset, frame_bytes, "audio");
+    bool is_float = asbd->mFormatFlags & kAudioFormatFlagIsFloat;
+    bool planar = asbd->mFormatFlags & kAudioFormatFlagIsNonInterleaved;
+    int channels = (int)asbd->mChannelsPerFrame;
+    if (!is_float && asbd->mBitsPerChannel != 16) return;
+    if (0 != _owner->PrepareConverter(is_float, (int)asbd->mSampleRate, channels)) return;
+
+    size_t frames = (size_t)CMSampleBufferGetNumSamples(sampleBuffer);
+    crossdesk::SpeakerCapturerMacosx* owner = _owner;
+    auto frame_cb = [owner](const uint8_t* frame, size_t size) {
+      owner->cb_(const_cast<uint8_t*>(frame), size, "audio");
+    };
+
+    if (planar && channels > 1) {
+      // non interleaved buffers hold the channel planes back to back
+      std::vector<const void*> planes(channels);
+      size_t plane_bytes = length / channels;
+      for (int c = 0; c < channels; c++) {
+        planes[c] = dataPtr + c * plane_bytes;
+      }
+      _owner->converter_.ProcessPlanar(planes.data(), frames, frame_cb);
+    } else {
+      _owner->converter_.Process(dataPtr, frames, frame_cb);
     }
   }
 }
@@ -97,8 +111,8 @@ int SpeakerCapturerMacosx::Init(speaker_data_cb cb) {
 
   impl_->config = [[SCStreamConfiguration alloc] init];
   impl_->config.capturesAudio = YES;
-  impl_->config.sampleRate = 48000;
-  impl_->config.channelCount = 1;
+  impl_->config.sampleRate = AudioConfig::kSampleRate;
+  impl_->config.channelCount = audio_config_.channels;
 
   dispatch_semaphore_t sema = dispatch_semaphore_create(0);
   __block NSError* error = nil;
@@ -137,6 +151,40 @@ int SpeakerCapturerMacosx::Init(speaker_data_cb cb) {
   return 0;
 }
 
+int SpeakerCapturerMacosx::SetAudioConfig(const AudioConfig& audio_config) {
+  if (inited_) {
+    LOG_ERROR("Audio config must be set before Init");
+    return -1;
+  }
+
+  audio_config_ = audio_config;
+  converter_ready_ = false;
+  return 0;
+}
+
+int SpeakerCapturerMacosx::PrepareConverter(bool is_float, int sample_rate, int channels) {
+  if (converter_ready_ && is_float == converter_float_ && sample_rate == converter_rate_ &&
+      channels == converter_channels_) {
+    return 0;
+  }
+
+  int ret = converter_.Init(
+      is_float ? AudioConverter::SampleFormat::F32 : AudioConverter::SampleFormat::S16,
+      sample_rate, channels, audio_config_);
+  if (0 != ret) {
+    LOG_ERROR("Unsupported audio format [{} Hz, {} channels]", sample_rate, channels);
+    return -1;
+  }
+
+  LOG_INFO("Speaker capture format [{} Hz, {} channels, {}]", sample_rate, channels,
+           is_float ? "f32" : "s16");
+  converter_ready_ = true;
+  converter_float_ = is_float;
+  converter_rate_ = sample_rate;
+  converter_channels_ = channels;
+  return 0;
+}
+
 int SpeakerCapturerMacosx::Start() {
   if (!inited_) {
     return -1;
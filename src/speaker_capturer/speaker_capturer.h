@@ -9,6 +9,8 @@
 
 #include <functional>
 
+#include "audio_config.h"
+
 namespace crossdesk {
 
 class SpeakerCapturer {
@@ -24,6 +26,9 @@ class SpeakerCapturer {
   virtual int Destroy() = 0;
   virtual int Start() = 0;
   virtual int Stop() = 0;
+
+  // called before Start, or while stopped, to change the frame layout
+  virtual int SetAudioConfig(const AudioConfig& audio_config) { return -1; }
 };
 }  // namespace crossdesk
 #endif
\ No newline at end of file
@@ -11,9 +11,12 @@ namespace crossdesk {
 
 static ma_device_config device_config_;
 static ma_device device_;
-static ma_format format_ = ma_format_s16;
-static ma_uint32 sample_rate_ = ma_standard_sample_rate_48000;
-static ma_uint32 channels_ = 1;
+// capture in the device's native float layout, the converter brings it to
+// the canonical format
+static ma_format format_ = ma_format_f32;
+static ma_uint32 sample_rate_ = 0;
+static ma_uint32 channels_ = 0;
+static ma_uint32 period_size_in_frames_ = 480;
 static FILE* fp_ = nullptr;
 
 void data_callback(ma_device* pDevice, void* pOutput, const void* pInput,
@@ -21,13 +24,13 @@ void data_callback(ma_device* pDevice, void* pOutput, const void* pInput,
   SpeakerCapturerWasapi* ptr = (SpeakerCapturerWasapi*)pDevice->pUserData;
   if (ptr) {
     if (SAVE_AUDIO_FILE) {
-      fwrite(pInput, frameCount * ma_get_bytes_per_frame(format_, channels_), 1,
-             fp_);
+      fwrite(pInput,
+             frameCount * ma_get_bytes_per_frame(format_,
+                                                 pDevice->capture.channels),
+             1, fp_);
     }
 
-    ptr->GetCallback()((unsigned char*)pInput,
-                       frameCount * ma_get_bytes_per_frame(format_, channels_),
-                       "audio");
+    ptr->OnCapturedData(pInput, frameCount);
   }
 
   (void)pOutput;
@@ -37,6 +40,14 @@ SpeakerCapturerWasapi::speaker_data_cb SpeakerCapturerWasapi::GetCallback() {
   return cb_;
 }
 
+void SpeakerCapturerWasapi::OnCapturedData(const void* data,
+                                           uint32_t frame_count) {
+  converter_.Process(data, frame_count, [this](const uint8_t* frame,
+                                               size_t size) {
+    cb_(const_cast<uint8_t*>(frame), size, "audio");
+  });
+}
+
 SpeakerCapturerWasapi::SpeakerCapturerWasapi() {}
 
 SpeakerCapturerWasapi::~SpeakerCapturerWasapi() {
@@ -64,6 +75,7 @@ int SpeakerCapturerWasapi::Init(speaker_data_cb cb) {
   device_config_.capture.format = format_;
   device_config_.capture.channels = channels_;
   device_config_.sampleRate = sample_rate_;
+  device_config_.periodSizeInFrames = period_size_in_frames_;
   device_config_.dataCallback = data_callback;
   device_config_.pUserData = this;
 
@@ -74,11 +86,33 @@ int SpeakerCapturerWasapi::Init(speaker_data_cb cb) {
     return -1;
   }
 
+  if (0 != converter_.Init(AudioConverter::SampleFormat::F32,
+                           device_.sampleRate, device_.capture.channels,
+                           audio_config_)) {
+    LOG_ERROR("Unsupported loopback format [{} Hz, {} channels]",
+              device_.sampleRate, device_.capture.channels);
+    ma_device_uninit(&device_);
+    return -1;
+  }
+  LOG_INFO("Loopback capture [{} Hz, {} channels]", device_.sampleRate,
+           device_.capture.channels);
+
   inited_ = true;
 
   return 0;
 }
 
+int SpeakerCapturerWasapi::SetAudioConfig(const AudioConfig& audio_config) {
+  if (inited_) {
+    LOG_ERROR("Audio config must be set before Init");
+    return -1;
+  }
+
+  audio_config_ = audio_config;
+  period_size_in_frames_ = (ma_uint32)audio_config.SamplesPerFrame();
+  return 0;
+}
+
 int SpeakerCapturerWasapi::Start() {
   ma_result result = ma_device_start(&device_);
   if (result != MA_SUCCESS) {
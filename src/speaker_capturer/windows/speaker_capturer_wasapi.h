@@ -7,6 +7,7 @@
 #ifndef _SPEAKER_CAPTURER_WASAPI_H_
 #define _SPEAKER_CAPTURER_WASAPI_H_
 
+#include "audio_dsp.h"
 #include "speaker_capturer.h"
 
 namespace crossdesk {
@@ -21,14 +22,18 @@ class SpeakerCapturerWasapi : public SpeakerCapturer {
   virtual int Destroy();
   virtual int Start();
   virtual int Stop();
+  virtual int SetAudioConfig(const AudioConfig& audio_config);
 
   int Pause();
   int Resume();
 
   speaker_data_cb GetCallback();
+  void OnCapturedData(const void* data, uint32_t frame_count);
 
  private:
   speaker_data_cb cb_ = nullptr;
+  AudioConfig audio_config_;
+  AudioConverter converter_;
 
  private:
   bool inited_ = false;
@@ -4,23 +4,27 @@
  * Copyright (c) 2025 by DI JUNKUN, All Rights Reserved.
  */
 
-#ifndef _VERSION_CHECKER_H_
-#define _VERSION_CHECKER_H_
+#include "version_checker.h"
 
 #include <httplib.h>
 
+#include <chrono>
+#include <fstream>
 #include <iostream>
 #include <nlohmann/json.hpp>
 #include <sstream>
 #include <string>
 #include <vector>
 
+// most hosts are offline or firewalled, never wait long for the server
+#define UPDATE_CHECK_TIMEOUT_S 2
+// a cached result younger than this skips the request
+#define UPDATE_CACHE_TTL_S (12 * 60 * 60)
+
 using json = nlohmann::json;
 
 namespace crossdesk {
 
-static std::string latest_release_date_ = "";
-
 std::string ExtractNumericPart(const std::string& ver) {
   size_t start = 0;
   while (start < ver.size() && !std::isdigit(ver[start])) start++;
@@ -76,9 +80,9 @@ bool IsNewerDate(const std::string& date1, const std::string& date2) {
   return date2 > date1;
 }
 
-bool IsNewerVersion(const std::string& current, const std::string& latest) {
+bool IsNewerVersion(const std::string& current, const UpdateInfo& latest) {
   auto v1 = SplitVersion(ExtractNumericPart(current));
-  auto v2 = SplitVersion(ExtractNumericPart(latest));
+  auto v2 = SplitVersion(ExtractNumericPart(latest.version));
 
   size_t len = std::max(v1.size(), v2.size());
   v1.resize(len, 0);
@@ -90,11 +94,11 @@ bool IsNewerVersion(const std::string& current, const std::string& latest) {
   }
 
   // if versions are equal, compare by release date
-  if (!latest_release_date_.empty()) {
+  if (!latest.release_date.empty()) {
     // try to extract date from current version string
     std::string current_date = ExtractDateFromVersion(current);
     if (!current_date.empty()) {
-      return IsNewerDate(current_date, latest_release_date_);
+      return IsNewerDate(current_date, latest.release_date);
     } else {
       return true;
     }
@@ -129,37 +133,93 @@ bool IsNewerVersionWithDate(const std::string& current_version,
   return false;
 }
 
-std::string CheckUpdate() {
+static int64_t NowSeconds() {
+  return std::chrono::duration_cast<std::chrono::seconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+static bool ReadUpdateCache(const std::string& cache_file, json& cache) {
+  std::ifstream file(cache_file);
+  if (!file) {
+    return false;
+  }
+  try {
+    cache = json::parse(file);
+    return cache.contains("checkedAt") && cache["checkedAt"].is_number() &&
+           cache.contains("version") && cache["version"].is_string() &&
+           (!cache.contains("releaseDate") ||
+            cache["releaseDate"].is_string());
+  } catch (std::exception&) {
+    return false;
+  }
+}
+
+static bool FetchLatestVersion(UpdateInfo* info) {
   httplib::Client cli("https://version.crossdesk.cn");
 
-  cli.set_connection_timeout(5);
-  cli.set_read_timeout(5);
-
-  if (auto res = cli.Get("/version.json")) {
-    if (res->status == 200) {
-      try {
-        auto j = json::parse(res->body);
-        std::string latest = j["version"];
-        if (j.contains("releaseDate") && j["releaseDate"].is_string()) {
-          latest_release_date_ = j["releaseDate"];
-        } else {
-          latest_release_date_ = "";
-        }
-        return latest;
-      } catch (std::exception&) {
-        latest_release_date_ = "";
-        return "";
-      }
+  cli.set_connection_timeout(UPDATE_CHECK_TIMEOUT_S);
+  cli.set_read_timeout(UPDATE_CHECK_TIMEOUT_S);
+
+  auto res = cli.Get("/version.json");
+  if (!res || res->status != 200) {
+    return false;
+  }
+
+  try {
+    auto j = json::parse(res->body);
+    info->version = j["version"];
+    if (j.contains("releaseDate") && j["releaseDate"].is_string()) {
+      info->release_date = j["releaseDate"];
     } else {
-      latest_release_date_ = "";
-      return "";
+      info->release_date = "";
     }
-  } else {
-    latest_release_date_ = "";
-    return "";
+    return true;
+  } catch (std::exception&) {
+    return false;
   }
 }
 
-std::string GetLatestReleaseDate() { return latest_release_date_; }
-}  // namespace crossdesk
-#endif
\ No newline at end of file
+UpdateInfo CheckUpdate(const std::string& cache_file,
+                       std::shared_ptr<std::atomic<bool>> abandoned) {
+  json cache;
+  bool cached = ReadUpdateCache(cache_file, cache);
+  UpdateInfo cached_info;
+  if (cached) {
+    cached_info.version = cache["version"].get<std::string>();
+    cached_info.release_date = cache.value("releaseDate", "");
+  }
+  if (cached && NowSeconds() - cache["checkedAt"].get<int64_t>() <
+                    UPDATE_CACHE_TTL_S) {
+    cached_info.source = UpdateInfo::Source::CACHE;
+    return cached_info;
+  }
+
+  UpdateInfo latest;
+  if (!FetchLatestVersion(&latest)) {
+    // an expired answer still beats none
+    if (cached) {
+      cached_info.source = UpdateInfo::Source::EXPIRED_CACHE;
+      return cached_info;
+    }
+    return UpdateInfo();
+  }
+  latest.source = UpdateInfo::Source::SERVER;
+
+  // the app may be gone by now, leave its cache directory alone
+  if (abandoned && abandoned->load()) {
+    return latest;
+  }
+
+  cache = {{"checkedAt", NowSeconds()},
+           {"version", latest.version},
+           {"releaseDate", latest.release_date}};
+  std::ofstream file(cache_file, std::ios::trunc);
+  if (file) {
+    file << cache.dump();
+  } else {
+    latest.cache_write_failed = true;
+  }
+  return latest;
+}
+}  // namespace crossdesk
\ No newline at end of file
@@ -7,13 +7,32 @@
 #ifndef _VERSION_CHECKER_H_
 #define _VERSION_CHECKER_H_
 
+#include <atomic>
+#include <memory>
 #include <string>
 
 namespace crossdesk {
 
-std::string CheckUpdate();
+struct UpdateInfo {
+  enum class Source { NONE = 0, CACHE, SERVER, EXPIRED_CACHE };
 
-bool IsNewerVersion(const std::string& current, const std::string& latest);
+  std::string version;
+  // YYYY-MM-DD, empty when the server does not say
+  std::string release_date;
+  // NONE when neither the server nor the cache answered
+  Source source = Source::NONE;
+  bool cache_write_failed = false;
+};
+
+// call it off the ui thread. The timeouts bound connect and read but not
+// the name lookup, so never wait for it on shutdown. A result younger than
+// the cache ttl is returned without a request, an expired one only when
+// the server can not be reached. It never logs, the caller may have shut
+// the logger down, and once abandoned is set it leaves the cache alone.
+UpdateInfo CheckUpdate(const std::string& cache_file,
+                       std::shared_ptr<std::atomic<bool>> abandoned);
+
+bool IsNewerVersion(const std::string& current, const UpdateInfo& latest);
 
 }  // namespace crossdesk
 
@@ -7,6 +7,12 @@ option("CROSSDESK_VERSION")
     set_description("Set CROSSDESK_VERSION for build")
 option_end()
 
+option("CROSSDESK_TRACE")
+    set_default(true)
+    set_showmenu(true)
+    set_description("Compile in the chrome trace recorder")
+option_end()
+
 add_rules("mode.release", "mode.debug")
 set_languages("c++17")
 set_encodings("utf-8")
@@ -19,6 +25,9 @@ add_defines("UNICODE")
 if is_mode("debug") then
     add_defines("CROSSDESK_DEBUG")
 end
+if has_config("CROSSDESK_TRACE") then
+    add_defines("CROSSDESK_TRACE")
+end
 
 add_requires("spdlog 1.14.1", {system = false})
 add_requires("imgui v1.91.5-docking", {configs = {sdl3 = true, sdl3_renderer = true}})
@@ -37,7 +46,7 @@ elseif is_os("linux") then
     add_links("pulse-simple", "pulse")
     add_requires("libyuv") 
     add_syslinks("pthread", "dl")
-    add_links("SDL3", "asound", "X11", "Xtst", "Xrandr")
+    add_links("SDL3", "asound", "X11", "Xtst", "Xrandr", "Xfixes")
     add_cxflags("-Wno-unused-variable")   
 elseif is_os("macosx") then
     add_links("SDL3")
@@ -90,7 +99,7 @@ target("screen_capturer")
 
 target("speaker_capturer")
     set_kind("object")
-    add_deps("rd_log")
+    add_deps("rd_log", "common")
     add_includedirs("src/speaker_capturer", {public = true})
     if is_os("windows") then
         add_packages("miniaudio")
@@ -141,7 +150,7 @@ target("autostart")
 
 target("config_center")
     set_kind("object")
-    add_deps("rd_log", "autostart")
+    add_deps("rd_log", "common", "autostart")
     add_files("src/config_center/*.cpp")
     add_includedirs("src/config_center", {public = true})
 
@@ -160,13 +169,41 @@ target("version_checker")
     add_files("src/version_checker/*.cpp")
     add_includedirs("src/version_checker", {public = true})
 
+target("metrics_server")
+    set_kind("object")
+    add_packages("cpp-httplib")
+    add_deps("rd_log", "common")
+    add_files("src/metrics_server/*.cpp")
+    add_includedirs("src/metrics_server", {public = true})
+
+target("loopback")
+    set_kind("object")
+    add_deps("rd_log", "common", "minirtc")
+    add_files("src/loopback/loopback_link.cpp")
+    add_includedirs("src/loopback", {public = true})
+
+-- headless component pipeline benchmark without minirtc in the path,
+-- xmake build loopback_bench
+target("loopback_bench")
+    set_kind("binary")
+    set_default(false)
+    add_deps("rd_log", "common", "loopback")
+    add_files("src/loopback/loopback_bench.cpp")
+
+-- audio cost benchmarks, xmake build audio_bench
+target("audio_bench")
+    set_kind("binary")
+    set_default(false)
+    add_deps("rd_log", "common", "loopback")
+    add_files("src/loopback/audio_bench.cpp")
+
 target("gui")
     set_kind("object")
     add_packages("libyuv")
     add_defines("CROSSDESK_VERSION=\"" .. (get_config("CROSSDESK_VERSION") or "Unknown") .. "\"")
     add_deps("rd_log", "common", "assets", "config_center", "minirtc", 
         "path_manager", "screen_capturer", "speaker_capturer", 
-        "device_controller", "thumbnail", "version_checker")
+        "device_controller", "thumbnail", "version_checker", "metrics_server")
     add_files("src/gui/*.cpp", "src/gui/panels/*.cpp", "src/gui/toolbars/*.cpp",
         "src/gui/windows/*.cpp")
     add_includedirs("src/gui", "src/gui/panels", "src/gui/toolbars",